@@ -1,12 +1,89 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <stdexcept>
 #include <string>
+#include <vector>
+
+#include <afina/ValueRef.h>
 
 namespace Afina {
 
 /**
+ * # Memory used by the storage
+ * Payload is the bytes of keys and values, overhead is everything else storage
+ * allocates for items: headers, unused block capacity, index and timers
+ */
+struct MemoryStats {
+    size_t items;
+    size_t payload;
+    size_t overhead;
+
+    // Number of bytes storage is allowed to use, 0 if unknown
+    size_t limit;
+};
+
+/**
+ * # Item visited by the storage scan
+ */
+struct ScanItem {
+    std::string key;
+    ValueRef value;
+
+    // Expiration time of the item, 0 if it never expires
+    time_t expire;
+};
+
+/**
+ * # Result of the compare and set
+ */
+enum class CasResult {
+    // Value is stored
+    Stored,
+
+    // Item was changed since its version was read
+    Exists,
+
+    // Item doesn't exist
+    NotFound,
+
+    // Versions match, but value doesn't fit into the storage
+    NotStored
+};
+
+/**
+ * # Value of the counter
+ * Counter is a value of decimal digits only that fits into 64-bit unsigned
+ * integer, see Storage::Increment. Returns false if the value is not a counter
+ */
+inline bool ParseCounter(const char *data, size_t size, uint64_t &counter) {
+    if (size == 0) {
+        return false;
+    }
+    counter = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] < '0' || data[i] > '9' || counter > (UINT64_MAX - (data[i] - '0')) / 10) {
+            return false;
+        }
+        counter = counter * 10 + (data[i] - '0');
+    }
+    return true;
+}
+
+/**
+ * # Key-value storage
+ * Items could have expiration time: absolute unix time in seconds after which
+ * item is not visible anymore, 0 means item never expires. Once time comes item
+ * behaves as deleted one, even if storage reclaims its memory later. Item
+ * stored with expiration time already in the past is expired immediately.
  *
+ * Storage that supports versions gives each item a 64-bit version which changes
+ * every time the item does, so clients could detect concurrent changes, see Gets
+ * and CompareAndSet.
  */
 class Storage {
 public:
@@ -27,8 +104,9 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param expire time of the association, 0 if it never expires
      */
-    virtual bool Put(const std::string &key, const std::string &value) = 0;
+    virtual bool Put(const std::string &key, const std::string &value, time_t expire = 0) = 0;
 
     /**
      * Stores association between given key/value pair if key isn't present in
@@ -40,8 +118,9 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param expire time of the association, 0 if it never expires
      */
-    virtual bool PutIfAbsent(const std::string &key, const std::string &value) = 0;
+    virtual bool PutIfAbsent(const std::string &key, const std::string &value, time_t expire = 0) = 0;
 
     /**
      * Updates existing association between given key/value pair
@@ -53,8 +132,9 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param expire new expiration time of the association, 0 if it never expires
      */
-    virtual bool Set(const std::string &key, const std::string &value) = 0;
+    virtual bool Set(const std::string &key, const std::string &value, time_t expire = 0) = 0;
 
     /**
      * Removes association for the given key
@@ -72,6 +152,79 @@ public:
      */
     virtual bool Delete(const std::string &key) = 0;
 
+    /**
+     * Adds data to the end of the value for the given key
+     * If requested key doesn't present in storage method returns false and
+     * doesnt change anything. Expiration time of the association is kept.
+     *
+     * Default implementation is Get followed by Set: it is not atomic and drops
+     * expiration time, so storage overrides it with a single update
+     *
+     * @param key to change value of
+     * @param data to add after the value
+     */
+    virtual bool Append(const std::string &key, const std::string &data) {
+        std::string value;
+        return Get(key, value) && Set(key, value + data);
+    }
+
+    /**
+     * Adds data to the beginning of the value for the given key, same as Append
+     * otherwise
+     *
+     * @param key to change value of
+     * @param data to add before the value
+     */
+    virtual bool Prepend(const std::string &key, const std::string &data) {
+        std::string value;
+        return Get(key, value) && Set(key, data + value);
+    }
+
+    /**
+     * Adds delta to the counter stored for the given key, see ParseCounter.
+     * Counter wraps around on overflow. If requested key doesn't present in
+     * storage method returns false and doesnt change anything. Expiration time
+     * of the association is kept.
+     *
+     * Throws std::invalid_argument if the value is not a counter. Default
+     * implementation is Get followed by Set, see Append
+     *
+     * @param key of the counter
+     * @param delta to add to the counter
+     * @param value output parameter to put the new value of the counter to
+     */
+    virtual bool Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+        std::string current;
+        if (!Get(key, current)) {
+            return false;
+        }
+        if (!ParseCounter(current.data(), current.size(), value)) {
+            throw std::invalid_argument("Value is not a number");
+        }
+        value += delta;
+        return Set(key, std::to_string(value));
+    }
+
+    /**
+     * Subtracts delta from the counter stored for the given key, counter never
+     * goes below 0. Same as Increment otherwise
+     *
+     * @param key of the counter
+     * @param delta to subtract from the counter
+     * @param value output parameter to put the new value of the counter to
+     */
+    virtual bool Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+        std::string current;
+        if (!Get(key, current)) {
+            return false;
+        }
+        if (!ParseCounter(current.data(), current.size(), value)) {
+            throw std::invalid_argument("Value is not a number");
+        }
+        value -= std::min(value, delta);
+        return Set(key, std::to_string(value));
+    }
+
     /**
      * Retrive key for the given value
      * If there is an association for the given key then method copies value
@@ -84,6 +237,101 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) const = 0;
+
+    /**
+     * Retrive reference to the value for the given key
+     * Same as Get, but value is not copied if storage could avoid it: reference
+     * keeps value alive even if association is changed or deleted later, see
+     * ValueRef. Empty reference is returned if key not found
+     *
+     * @param key to retrive value for
+     */
+    virtual ValueRef GetRef(const std::string &key) const {
+        std::string value;
+        return Get(key, value) ? ValueRef::Copy(value) : ValueRef();
+    }
+
+    /**
+     * Retrive references to the values for several keys at once
+     * Same as GetRef called for each key, but storage could resolve the whole
+     * batch at once, for example under a single lock. Output gets the size of
+     * keys, values[i] is empty if keys[i] not found
+     *
+     * @param keys to retrive values for
+     * @param values output parameter to put references to
+     * @return number of found keys
+     */
+    virtual size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values) const {
+        values.assign(keys.size(), ValueRef());
+
+        size_t count = 0;
+        for (size_t i = 0; i < keys.size(); i++) {
+            values[i] = GetRef(keys[i]);
+            if (values[i]) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * Same as MultiGet, but also returns the current version of each found
+     * item. Output gets the size of keys, versions[i] is 0 if keys[i] not found.
+     *
+     * Throws std::logic_error if storage doesn't support versions
+     *
+     * @param keys to retrive values for
+     * @param values output parameter to put references to
+     * @param versions output parameter to put versions to
+     * @return number of found keys
+     */
+    virtual size_t Gets(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                        std::vector<uint64_t> &versions) const {
+        throw std::logic_error("Storage doesn't support versions");
+    }
+
+    /**
+     * Updates existing association only if its version is still the given one,
+     * that is nobody changed it since the version was read by Gets. Check and
+     * update are a single atomic operation.
+     *
+     * Throws std::logic_error if storage doesn't support versions
+     *
+     * @param key to be associated with value
+     * @param value to be assigned for the key
+     * @param version of the item the caller has read
+     * @param expire new expiration time of the association, 0 if it never expires
+     */
+    virtual CasResult CompareAndSet(const std::string &key, const std::string &value, uint64_t version,
+                                    time_t expire = 0) {
+        throw std::logic_error("Storage doesn't support versions");
+    }
+
+    /**
+     * Iterates over items of the storage step by step, so the storage is never
+     * blocked for long. Iteration starts with cursor 0, each call looks at about
+     * count more places of the storage and returns cursor of the next step, 0 once
+     * the whole storage is visited. Items found on the step are appended to the
+     * output, expired ones are skipped.
+     *
+     * Storage could be changed between steps, then items changed meanwhile could
+     * be missed or returned twice, the rest are returned exactly once.
+     *
+     * Throws std::logic_error if storage doesn't support iteration
+     *
+     * @param cursor returned by the previous step, 0 for the first one
+     * @param count amount of work to do on this step
+     * @param items output parameter to append found items to
+     */
+    virtual size_t Scan(size_t cursor, size_t count, std::vector<ScanItem> &items) const {
+        throw std::logic_error("Storage doesn't support scan");
+    }
+
+    /**
+     * Returns memory usage of the storage. Storage that doesn't track it reports
+     * zeros
+     */
+    virtual MemoryStats Memory() const { return MemoryStats(); }
 };
 
 } // namespace Afina
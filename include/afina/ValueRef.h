@@ -0,0 +1,121 @@
+#ifndef AFINA_VALUE_REF_H
+#define AFINA_VALUE_REF_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace Afina {
+
+/**
+ * # Reference to the immutable value
+ * Points to the value bytes wherever they live, usually right in the storage
+ * memory, and keeps them alive: memory is released once the last reference to it
+ * is gone, even if the value was deleted or replaced in the storage since then.
+ * Copying reference never copies the value.
+ *
+ * Memory owner provides the counter and the function that releases memory once
+ * counter drops to zero. Reference without counter points to data that outlives
+ * it, like string literals.
+ *
+ * Empty reference points to nothing, that is how missing value is returned.
+ */
+class ValueRef {
+public:
+    using Release = void (*)(void *owner);
+
+    ValueRef() : _data(nullptr), _size(0), _refs(nullptr), _owner(nullptr), _release(nullptr) {}
+
+    /**
+     * Takes reference to the data owned by the owner. Counter must be already
+     * incremented for this reference
+     */
+    ValueRef(const char *data, size_t size, std::atomic<uint32_t> *refs, void *owner, Release release)
+        : _data(data), _size(size), _refs(refs), _owner(owner), _release(release) {}
+
+    ValueRef(const ValueRef &other)
+        : _data(other._data), _size(other._size), _refs(other._refs), _owner(other._owner), _release(other._release) {
+        if (_refs != nullptr) {
+            _refs->fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    ValueRef(ValueRef &&other) : ValueRef() { swap(other); }
+
+    ValueRef &operator=(ValueRef other) {
+        swap(other);
+        return *this;
+    }
+
+    ~ValueRef() {
+        if (_refs != nullptr && _refs->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            _release(_owner);
+        }
+    }
+
+    /**
+     * Reference to the data that outlives it, nothing is counted
+     */
+    static ValueRef Static(const char *data, size_t size) { return ValueRef(data, size, nullptr, nullptr, nullptr); }
+
+    /**
+     * Copies data into the new block owned by the reference only
+     */
+    static ValueRef Copy(const char *data, size_t size) {
+        char *copy;
+        ValueRef ref = Allocate(size, copy);
+        std::memcpy(copy, data, size);
+        return ref;
+    }
+
+    /**
+     * Allocates new block of the given size owned by the reference only. Block
+     * is returned through data to be filled before the reference is shared
+     */
+    static ValueRef Allocate(size_t size, char *&data) {
+        Block *block = static_cast<Block *>(std::malloc(sizeof(Block) + size));
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+        new (&block->refs) std::atomic<uint32_t>(1);
+        data = reinterpret_cast<char *>(block + 1);
+        return ValueRef(data, size, &block->refs, block, std::free);
+    }
+
+    static ValueRef Copy(const std::string &value) { return Copy(value.data(), value.size()); }
+
+    void swap(ValueRef &other) {
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+        std::swap(_refs, other._refs);
+        std::swap(_owner, other._owner);
+        std::swap(_release, other._release);
+    }
+
+    // True if reference points to some value, maybe the empty one
+    explicit operator bool() const { return _data != nullptr; }
+
+    const char *data() const { return _data; }
+    size_t size() const { return _size; }
+    std::string str() const { return std::string(_data, _size); }
+
+private:
+    // Header of the block allocated by Allocate
+    struct Block {
+        std::atomic<uint32_t> refs;
+    };
+
+    const char *_data;
+    size_t _size;
+    std::atomic<uint32_t> *_refs;
+    void *_owner;
+    Release _release;
+};
+
+} // namespace Afina
+
+#endif // AFINA_VALUE_REF_H
@@ -7,6 +7,14 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * # Relocatable pointer
+ * Refers to the slot in the allocator indirection table rather than to the memory
+ * itself. Allocator updates slot once block is moved, so pointer stays valid over
+ * realloc and defrag. Copies of the pointer share the same slot.
+ *
+ * Address returned by get() is valid only until the next realloc/defrag call.
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +25,14 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    void *get() const { return _slot == nullptr ? nullptr : *_slot; }
+
+private:
+    friend class Simple;
+
+    explicit Pointer(void **slot) : _slot(slot) {}
+
+    void **_slot;
 };
 
 } // namespace Allocator
@@ -15,6 +15,16 @@ class Pointer;
  * Wraps given memory area and provides defagmentation allocator interface on
  * the top of it.
  *
+ * Blocks are placed from the begin of the area upwards, each one has a small header
+ * with its size. Indirection table of Pointer slots grows from the end of the area
+ * downwards, free space between them is the "top". Freed blocks are kept in the
+ * free list and merged with free neighbours immediately (boundary tags), so free
+ * takes O(1).
+ *
+ * Since callers hold Pointer instead of raw addresses, blocks could be moved:
+ * defrag() slides all used blocks to the begin of the area and returns all holes
+ * to the top.
+ *
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
@@ -25,37 +35,70 @@ public:
     Simple(void *base, const size_t size);
 
     /**
-     * TODO: semantics
+     * Allocates block of at least N bytes. First fitting free block is used, then the
+     * top. Throws AllocError with NoMemory type if no space left, in that case
+     * defrag() might help
      * @param N size_t
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Changes size of the block keeping its content. Block grows in place if next
+     * block is free or it is the last one, otherwise content is moved into new block
+     * and p is updated. Empty p is allocated
      * @param p Pointer
      * @param N size_t
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Releases block and resets p. Throws AllocError with InvalidFree type if p
+     * doesn't refer to allocated block
      * @param p Pointer
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Moves all allocated blocks to the begin of the area, so all free space becomes
+     * contiguous. Takes time linear to the number of blocks
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Human readable list of blocks
      */
     std::string dump() const;
 
 private:
+    struct Block;
+
+    Block *_AllocBlock(size_t size);
+    void _Release(Block *block);
+    void _Split(Block *block, size_t size);
+    void _MarkFree(Block *block, size_t size);
+    void _UnlinkFree(Block *block);
+
+    void **_AcquireSlot();
+    void _ReleaseSlot(void **slot);
+    Block *_BlockOf(const Pointer &p) const;
+
     void *_base;
     const size_t _base_len;
+
+    // First block
+    char *_begin;
+
+    // End of the last block
+    char *_top;
+
+    // Lowest slot of the indirection table
+    char *_end;
+
+    // Free blocks list
+    Block *_free_blocks;
+
+    // Free slots list, each free slot keeps address of the next one
+    void **_free_slots;
 };
 
 } // namespace Allocator
@@ -0,0 +1,141 @@
+#ifndef AFINA_ALLOCATOR_SLAB_H
+#define AFINA_ALLOCATOR_SLAB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Slab allocator
+ * Wraps given memory area (arena) and splits it into equal slabs. Each slab once
+ * needed is assigned to one of the size classes (mempools) and carved into chunks
+ * of the class size. Classes grow geometrically, so internal fragmentation is
+ * bounded by the growth factor.
+ *
+ * Slab that has no used chunks anymore goes back to the arena and could be reused
+ * by any other class, that allows memory to migrate between classes under churn.
+ *
+ * All metadata lives outside of the arena, so every arena byte could be given
+ * out to the caller, and arena size is exactly the amount of memory allocator
+ * could ever touch.
+ *
+ * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
+ * on destruction. Allocator isn't thread safe.
+ */
+class Slab {
+public:
+    /**
+     * @param base begin of the arena
+     * @param size arena size in bytes
+     * @param slab_size size of a single slab, must be power of two, it is also the
+     * biggest chunk allocator could give out
+     * @param min_chunk size of the smallest size class
+     * @param factor growth factor between size classes
+     */
+    Slab(void *base, size_t size, size_t slab_size = 1 << 20, size_t min_chunk = 64, double factor = 1.25);
+
+    /**
+     * Allocates chunk of at least N bytes. Throws AllocError with NoMemory type if
+     * there is no free chunk of the suitable class and no free slabs left
+     * @param N size_t
+     */
+    void *alloc(size_t N);
+
+    /**
+     * Same as alloc, but returns nullptr instead of throwing
+     * @param N size_t
+     */
+    void *try_alloc(size_t N);
+
+    /**
+     * Returns chunk back to its size class. Throws AllocError with InvalidFree type
+     * if pointer doesn't point to the begin of the allocated chunk
+     * @param p void *
+     */
+    void free(void *p);
+
+    /**
+     * Returns number of bytes usable in the chunk that would be allocated for
+     * N bytes request, 0 if request is too big
+     * @param N size_t
+     */
+    size_t chunk_size(size_t N) const;
+
+    /**
+     * Returns size class of the chunk that would be allocated for N bytes request
+     */
+    size_t size_class(size_t N) const;
+
+    /**
+     * Returns size class of the already allocated chunk
+     */
+    size_t size_class(const void *p) const;
+
+    // Number of bytes in chunks given out to the caller
+    size_t used() const { return _used; }
+
+    // Number of bytes that could be used by chunks
+    size_t capacity() const { return _slabs.size() * _slab_size; }
+
+    // Number of slabs not assigned to any class
+    size_t free_slabs() const { return _free_slabs_count; }
+
+    /**
+     * Human readable state of the allocator: classes and slabs usage
+     */
+    std::string dump() const;
+
+private:
+    struct SlabInfo {
+        // Size class this slab is assigned to
+        uint32_t size_class;
+
+        // Number of chunks given out
+        uint32_t used;
+
+        // Number of chunks carved from the slab so far, chunks after that are never
+        // used yet and don't need free list
+        uint32_t carved;
+
+        // Free list of the returned chunks, list is stored in chunks memory
+        void *free_list;
+
+        // Links in the pool partial list or in the arena free list
+        SlabInfo *next;
+        SlabInfo *prev;
+    };
+
+    struct Pool {
+        size_t chunk_size;
+        uint32_t chunks_per_slab;
+
+        // Slabs that have at least one free chunk
+        SlabInfo *partial;
+
+        // Number of slabs assigned to the pool
+        size_t slabs;
+    };
+
+    SlabInfo *_SlabOf(const void *p) const;
+    void _Unlink(SlabInfo *&list, SlabInfo *slab);
+    void _Push(SlabInfo *&list, SlabInfo *slab);
+
+    char *_base;
+    size_t _slab_size;
+    size_t _used;
+
+    std::vector<Pool> _pools;
+    std::vector<SlabInfo> _slabs;
+
+    SlabInfo *_free_slabs;
+    size_t _free_slabs_count;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SLAB_H
@@ -2,6 +2,9 @@
 #define AFINA_EXECUTE_COMMAND_H
 
 #include <string>
+#include <vector>
+
+#include <afina/ValueRef.h>
 
 namespace Afina {
 
@@ -19,6 +22,18 @@ public:
     virtual ~Command() {}
 
     virtual void Execute(Storage &storage, const std::string &args, std::string &out) = 0;
+
+    /**
+     * Same as above, but response is appended to out as a sequence of chunks that
+     * could be written with a single writev. Commands that return values override
+     * it to reference values right in the storage memory, the rest just have their
+     * response copied into one chunk
+     */
+    virtual void Execute(Storage &storage, const std::string &args, std::vector<ValueRef> &out) {
+        std::string result;
+        Execute(storage, args, result);
+        out.push_back(ValueRef::Copy(result));
+    }
 };
 
 } // namespace Execute
@@ -41,6 +41,9 @@ public:
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
+    // Values are not copied, chunks reference them in the storage
+    void Execute(Storage &storage, const std::string &args, std::vector<ValueRef> &out) override;
+
 private:
     std::vector<std::string> _keys;
 };
@@ -0,0 +1,34 @@
+#ifndef AFINA_EXECUTE_GETS_H
+#define AFINA_EXECUTE_GETS_H
+
+#include <string>
+#include <vector>
+
+#include "Get.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Retrive values for the keys with their versions
+ * Same as Get, but each item also has the version of the item:
+ * VALUE <key> <flags> <bytes> <cas unique>\r\n
+ * <data>\r\n
+ *
+ * Where <cas unique> is the 64-bit version client passes to cas to update the
+ * item only if nobody changed it since
+ */
+class Gets : public Get {
+public:
+    Gets(const std::vector<std::string> &keys) : Get(keys) {}
+    ~Gets() {}
+
+    using Get::Execute;
+
+    void Execute(Storage &storage, const std::string &args, std::vector<ValueRef> &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_GETS_H
@@ -2,6 +2,7 @@
 #define AFINA_EXECUTE_INSERT_COMMAND_H
 
 #include <cstdint>
+#include <ctime>
 #include <string>
 
 #include "Command.h"
@@ -23,6 +24,18 @@ public:
     inline const int32_t expire() const { return _expire; }
 
 protected:
+    // Values of expire time greater than that are absolute unix time, not offset
+    static const int32_t max_expire_offset = 60 * 60 * 24 * 30;
+
+    // Converts memcached expire time into the one storage expects, see Storage.h
+    time_t _Deadline() const {
+        if (_expire == 0 || _expire > max_expire_offset) {
+            return _expire;
+        }
+        // Negative time gives deadline in the past, so item is expired immediately
+        return std::time(nullptr) + _expire;
+    }
+
     const std::string _key;
     const uint32_t _flags;
     const int32_t _expire;
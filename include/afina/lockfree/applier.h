@@ -1,3 +1,11 @@
+#ifndef AFINA_LOCKFREE_APPLIER_H
+#define AFINA_LOCKFREE_APPLIER_H
+
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <afina/lockfree/flatcombine.h>
 #include <afina/Storage.h>
 
@@ -5,22 +13,124 @@ namespace Afina {
 namespace LockFree {
 
 enum class Method {
-  Put, PutIfAbsent, Get, Delete, Set 
+  Put, PutIfAbsent, Get, Delete, Set, GetRef, MultiGet, Append, Prepend, Gets, CompareAndSet,
+  Increment, Decrement
+};
+
+// Arguments of MultiGet and Gets, versions are set for the latter only
+struct MultiGetArgs {
+  const std::vector<std::string>* keys;
+  std::vector<ValueRef>* values;
+  std::vector<uint64_t>* versions;
+  size_t count;
+};
+
+// Arguments of CompareAndSet
+struct CasArgs {
+  uint64_t version;
+  CasResult result;
+};
+
+// Arguments of Increment and Decrement
+struct CounterArgs {
+  uint64_t delta;
+  uint64_t value;
 };
 
+// Request of a single storage call. Caller waits until it is applied, so
+// arguments are passed by pointers. Combiner can't throw into the caller thread,
+// so exception of the call is passed back in error and is rethrown by the caller
 struct ApplierSlot {
   bool status;
   Method opcode;
-  std::string key;
-  std::string val;
-  std::string res;
+  const std::string* key;
+  const std::string* val;
+  std::string* res;
+  time_t expire;
+  MultiGetArgs* multi;
+  ValueRef* ref;
+  CasArgs* cas;
+  CounterArgs* counter;
+  std::exception_ptr error;
 };
 
-class Applier : public FC<ApplierSlot> {
-  Storage* storage;
-  Applier(Storage* _storage) : storage(_storage) {}
-  virtual void flat_combine(void);
+/**
+ * # Flat combining storage
+ * Decorates another storage: calls from all threads are published into the flat
+ * combining list and one thread at a time applies the whole batch, see FC
+ */
+class Applier : public Storage {
+public:
+  explicit Applier(std::shared_ptr<Storage> _storage) : storage(std::move(_storage)) {}
+
+  void Start() override { storage->Start(); }
+  void Stop() override { storage->Stop(); }
+
+  // Implements Afina::Storage interface
+  bool Put(const std::string& key, const std::string& value, time_t expire = 0) override;
+
+  // Implements Afina::Storage interface
+  bool PutIfAbsent(const std::string& key, const std::string& value, time_t expire = 0) override;
+
+  // Implements Afina::Storage interface
+  bool Set(const std::string& key, const std::string& value, time_t expire = 0) override;
+
+  // Implements Afina::Storage interface
+  bool Delete(const std::string& key) override;
+
+  // Implements Afina::Storage interface
+  bool Append(const std::string& key, const std::string& data) override;
+
+  // Implements Afina::Storage interface
+  bool Prepend(const std::string& key, const std::string& data) override;
+
+  // Implements Afina::Storage interface
+  bool Increment(const std::string& key, uint64_t delta, uint64_t& value) override;
+
+  // Implements Afina::Storage interface
+  bool Decrement(const std::string& key, uint64_t delta, uint64_t& value) override;
+
+  // Implements Afina::Storage interface
+  bool Get(const std::string& key, std::string& value) const override;
+
+  // Implements Afina::Storage interface, decorated storage is thread safe itself
+  MemoryStats Memory() const override { return storage->Memory(); }
+
+  // Implements Afina::Storage interface, scan steps bypass the combiner as well
+  size_t Scan(size_t cursor, size_t count, std::vector<ScanItem>& items) const override {
+    return storage->Scan(cursor, count, items);
+  }
+
+  // Implements Afina::Storage interface
+  ValueRef GetRef(const std::string& key) const override;
+
+  // Implements Afina::Storage interface, the whole batch is a single request
+  size_t MultiGet(const std::vector<std::string>& keys, std::vector<ValueRef>& values) const override;
+
+  // Implements Afina::Storage interface, the whole batch is a single request
+  size_t Gets(const std::vector<std::string>& keys, std::vector<ValueRef>& values,
+              std::vector<uint64_t>& versions) const override;
+
+  // Implements Afina::Storage interface
+  CasResult CompareAndSet(const std::string& key, const std::string& value, uint64_t version,
+                          time_t expire = 0) override;
+
+private:
+  bool execute(Method opcode, const std::string* key, const std::string* val, std::string* res,
+               time_t expire = 0, MultiGetArgs* multi = nullptr, ValueRef* ref = nullptr,
+               CasArgs* cas = nullptr, CounterArgs* counter = nullptr) const;
+
+  // Calls backend for the request, runs in the combiner thread
+  static void apply(Storage& backend, ApplierSlot& slot);
+
+  // Runs Increment or Decrement through the combiner
+  bool count(Method opcode, const std::string& key, uint64_t delta, uint64_t& value);
+
+  std::shared_ptr<Storage> storage;
+  mutable FC<ApplierSlot> combiner;
 };
 
 } // LockFree
 } // Afina
+
+#endif // AFINA_LOCKFREE_APPLIER_H
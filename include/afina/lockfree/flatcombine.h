@@ -1,7 +1,7 @@
-#include <mutex>
+#ifndef AFINA_LOCKFREE_FLATCOMBINE_H
+#define AFINA_LOCKFREE_FLATCOMBINE_H
+
 #include <atomic>
-#include <set>
-#include <string>
 #include <thread>
 #include <afina/lockfree/thread_local.h>
 
@@ -9,62 +9,148 @@ namespace Afina {
 
 namespace LockFree {
 
+/**
+ * # Flat combining
+ * Each thread owns publication record in the shared list. To execute operation
+ * thread puts request into its record and marks it pending. Then it either takes
+ * the combiner lock and applies all pending requests of all threads in one pass,
+ * or spins on its own record until some other combiner does that.
+ *
+ * So data structure behind is accessed by a single thread at a time, it stays in
+ * its cache, and lock is taken once per batch instead of once per operation.
+ *
+ * Records are pushed into the list once, when thread executes its first
+ * operation. Record of the exited thread is marked dead and combiner unlinks and
+ * deletes it later.
+ */
 template<typename Slot>
 class FC {
 protected:
   struct Record {
-    bool active = false;
-    size_t been_activated = 0; 
+    std::atomic<bool> pending;
+    std::atomic<bool> dead;
     Slot slot;
-    Record* next = NULL;
+    Record* next;
+
+    Record() : pending(false), dead(false), next(nullptr) {}
   };
 
-  ThreadLocal<Record*> node;
+  ThreadLocal<Record> node;
+
+  std::atomic<bool> lock;
+  std::atomic<Record*> head;
+
+  // Called on thread exit instead of delete, record could still be in the list
+  static void abandon(void* mem) {
+    static_cast<Record*>(mem)->dead.store(true, std::memory_order_release);
+  }
 
-  volatile std::atomic<uint8_t> count;
-  volatile std::atomic<Record*> head;
 public:
-  void enqueque_slot(const Slot& c) {
-    publicate(c);
-    if (acquire_lock()) {
-      flat_combine();
-      release_lock();
+  FC(void) : node(&FC::abandon), lock(false), head(nullptr) {}
+
+  ~FC(void) {
+    Record* record = head.load();
+    while (record != nullptr) {
+      Record* next = record->next;
+      delete record;
+      record = next;
     }
   }
 
-  bool acquire_lock(void) {
-    uint8_t _count = 0;
-    while(!count.compare_exchange_weak(_count, _count | 1, std::memory_order_release, std::memory_order_relaxed)) { // пытаемся установить мьютекс
-      _count &= ~uint8_t(1); // ожидаем сброшенный мьютекст
-      Record* local_record = node.get();
-      if (!local_record || !local_record->active) {
-        return false;
+  FC(const FC&) = delete;
+  FC& operator=(const FC&) = delete;
+
+  /**
+   * Publishes request and waits until it is applied. apply(Slot&) is called by the
+   * combiner for each pending slot, so it must be the same for all callers.
+   * Returns the slot after application, it stays valid until the next call from
+   * the same thread.
+   *
+   * apply should not throw: its exception goes to the combiner thread whoever owns
+   * the slot, the rest of the batch stays pending for the next combiner. Errors of
+   * requests are to be passed back through their slots
+   */
+  template<typename F>
+  Slot& execute(const Slot& request, F apply) {
+    Record* record = publicate(request);
+    while (record->pending.load(std::memory_order_acquire)) {
+      if (acquire_lock()) {
+        LockGuard guard(*this);
+        combine(apply);
+      } else {
+        std::this_thread::yield();
       }
-      std::this_thread::yield();
     }
-    count += 2; // подсчет эры, не сбрасывая мьютекса
-    return true;
+    return record->slot;
+  }
+
+protected:
+  // Releases combiner lock even if apply throws, otherwise waiters spin forever
+  struct LockGuard {
+    FC& fc;
+
+    explicit LockGuard(FC& _fc) : fc(_fc) {}
+    ~LockGuard() { fc.release_lock(); }
+  };
+
+  bool acquire_lock(void) {
+    bool expected = false;
+    return !lock.load(std::memory_order_relaxed) &&
+           lock.compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed);
   }
 
   void release_lock(void) {
-    count.store(count & ~uint8_t(1), std::memory_order_relaxed);
+    lock.store(false, std::memory_order_release);
   }
 
-  void publicate(const Slot& c) {
-    Record* local_node = node.get();
-    if (local_node == NULL) {
-      local_node = new Record();
-      local_node->slot = c;
-      node.set(local_node);
+  Record* publicate(const Slot& request) {
+    Record* record = node.get();
+    if (record == nullptr) {
+      record = new Record();
+      node.set(record);
+
+      record->next = head.load(std::memory_order_relaxed);
+      while (!head.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed)) {
+      }
     }
-    while(!(head.compare_exchange_weak(local_node->next, local_node, std::memory_order_release, std::memory_order_relaxed))) {}
+
+    record->slot = request;
+    record->pending.store(true, std::memory_order_release);
+    return record;
   }
 
-  FC(void) : count(0), head(NULL) {};
-  ~FC(void) {};
+  template<typename F>
+  void combine(F apply) {
+    // Head could be replaced by concurrent push any time, so it is never unlinked
+    Record* prev = head.load(std::memory_order_acquire);
+    if (prev == nullptr) {
+      return;
+    }
+    if (prev->pending.load(std::memory_order_acquire)) {
+      apply(prev->slot);
+      prev->pending.store(false, std::memory_order_release);
+    }
 
-  virtual void flat_combine(void) {}
+    Record* record = prev->next;
+    while (record != nullptr) {
+      if (record->dead.load(std::memory_order_acquire)) {
+        prev->next = record->next;
+        delete record;
+        record = prev->next;
+        continue;
+      }
+
+      if (record->pending.load(std::memory_order_acquire)) {
+        apply(record->slot);
+        record->pending.store(false, std::memory_order_release);
+      }
+      prev = record;
+      record = record->next;
+    }
+  }
 };
 
 } // LockFree
 } // Afina
+
+#endif // AFINA_LOCKFREE_FLATCOMBINE_H
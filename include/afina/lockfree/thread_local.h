@@ -1,9 +1,17 @@
+#ifndef AFINA_LOCKFREE_THREAD_LOCAL_H
+#define AFINA_LOCKFREE_THREAD_LOCAL_H
+
 #include <pthread.h>
 #include <type_traits>
 
 namespace Afina {
 namespace LockFree {
 
+/**
+ * # Per object thread local pointer
+ * Unlike thread_local variables, each instance has its own value in every
+ * thread. Value is passed to destr_fn once thread exits, by default it is deleted
+ */
 template<typename T>
 class ThreadLocal {
 private:
@@ -34,3 +42,5 @@ public:
 
 } // LockFree
 } // Afina
+
+#endif // AFINA_LOCKFREE_THREAD_LOCAL_H
@@ -1,40 +1,324 @@
 #include <afina/allocator/Simple.h>
 
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
+namespace {
 
-/**
- * TODO: semantics
- * @param N size_t
- */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
+const size_t alignment = sizeof(void *);
 
-/**
- * TODO: semantics
- * @param p Pointer
- * @param N size_t
- */
-void Simple::realloc(Pointer &p, size_t N) {}
+// Block is given out
+const size_t flag_used = 1;
 
-/**
- * TODO: semantics
- * @param p Pointer
- */
-void Simple::free(Pointer &p) {}
+// Previous block is free and has footer
+const size_t flag_prev_free = 2;
 
-/**
- * TODO: semantics
- */
-void Simple::defrag() {}
+const size_t flags_mask = alignment - 1;
+
+size_t align_up(size_t value) { return (value + alignment - 1) & ~(alignment - 1); }
+
+} // namespace
 
 /**
- * TODO: semantics
+ * Block header. Size is a number of payload bytes, it is always aligned so the
+ * lowest bits keep flags. Free block payload starts with free list links and ends
+ * with a copy of the size (footer), that allows next block to find it on merge
  */
-std::string Simple::dump() const { return ""; }
+struct Simple::Block {
+    struct Links {
+        Block *next;
+        Block *prev;
+    };
+
+    // Free block must fit links and footer
+    static const size_t min_payload = sizeof(Links) + sizeof(size_t);
+
+    size_t size;
+
+    // Slot of the indirection table that refers to the block, valid for used blocks
+    void **slot;
+
+    size_t Payload() const { return size & ~flags_mask; }
+    char *Data() { return reinterpret_cast<char *>(this + 1); }
+    Block *Next() { return reinterpret_cast<Block *>(Data() + Payload()); }
+    Links *FreeLinks() { return reinterpret_cast<Links *>(Data()); }
+    size_t *Footer() { return reinterpret_cast<size_t *>(Data() + Payload()) - 1; }
+
+    static size_t RequestSize(size_t N) { return N < min_payload ? min_payload : align_up(N); }
+};
+
+Simple::Simple(void *base, size_t size) : _base(base), _base_len(size), _free_blocks(nullptr), _free_slots(nullptr) {
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(base) + alignment - 1) & ~(alignment - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(base) + size) & ~(alignment - 1);
+    if (end < begin) {
+        end = begin;
+    }
+
+    _begin = reinterpret_cast<char *>(begin);
+    _top = _begin;
+    _end = reinterpret_cast<char *>(end);
+}
+
+// See Simple.h
+Pointer Simple::alloc(size_t N) {
+    void **slot = _AcquireSlot();
+    if (slot == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No space left for pointer");
+    }
+
+    Block *block = _AllocBlock(Block::RequestSize(N));
+    if (block == nullptr) {
+        _ReleaseSlot(slot);
+        throw AllocError(AllocErrorType::NoMemory, "No free block of the requested size");
+    }
+
+    block->slot = slot;
+    *slot = block->Data();
+    return Pointer(slot);
+}
+
+// See Simple.h
+void Simple::realloc(Pointer &p, size_t N) {
+    if (p.get() == nullptr) {
+        p = alloc(N);
+        return;
+    }
+
+    Block *block = _BlockOf(p);
+    size_t size = Block::RequestSize(N);
+    size_t current = block->Payload();
+    if (size <= current) {
+        _Split(block, size);
+        return;
+    }
+
+    // Last block just takes more of the top
+    Block *next = block->Next();
+    if (reinterpret_cast<char *>(next) == _top) {
+        if (size_t(_end - block->Data()) >= size) {
+            block->size = size | (block->size & flags_mask);
+            _top = block->Data() + size;
+            return;
+        }
+    } else if (!(next->size & flag_used) && current + sizeof(Block) + next->Payload() >= size) {
+        // Absorb free neighbour, then give back what is left of it
+        _UnlinkFree(next);
+        block->size = (current + sizeof(Block) + next->Payload()) | (block->size & flags_mask);
+
+        Block *after = block->Next();
+        if (reinterpret_cast<char *>(after) != _top) {
+            after->size &= ~flag_prev_free;
+        }
+        _Split(block, size);
+        return;
+    }
+
+    Block *moved = _AllocBlock(size);
+    if (moved == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No free block of the requested size");
+    }
+
+    std::memcpy(moved->Data(), block->Data(), current);
+    moved->slot = block->slot;
+    *moved->slot = moved->Data();
+    _Release(block);
+}
+
+// See Simple.h
+void Simple::free(Pointer &p) {
+    if (p._slot == nullptr) {
+        return;
+    }
+
+    Block *block = _BlockOf(p);
+    _Release(block);
+    _ReleaseSlot(p._slot);
+    p._slot = nullptr;
+}
+
+// See Simple.h
+void Simple::defrag() {
+    char *cursor = _begin;
+    for (Block *block = reinterpret_cast<Block *>(_begin); reinterpret_cast<char *>(block) < _top;) {
+        Block *next = block->Next();
+        if (block->size & flag_used) {
+            size_t size = block->Payload();
+            Block *moved = reinterpret_cast<Block *>(cursor);
+            if (moved != block) {
+                std::memmove(moved, block, sizeof(Block) + size);
+            }
+
+            moved->size = size | flag_used;
+            *moved->slot = moved->Data();
+            cursor += sizeof(Block) + size;
+        }
+        block = next;
+    }
+
+    _top = cursor;
+    _free_blocks = nullptr;
+}
+
+// See Simple.h
+std::string Simple::dump() const {
+    std::stringstream out;
+    size_t used = 0, holes = 0, blocks = 0;
+    for (Block *block = reinterpret_cast<Block *>(_begin); reinterpret_cast<char *>(block) < _top;
+         block = block->Next()) {
+        out << (reinterpret_cast<char *>(block) - _begin) << ": " << block->Payload()
+            << ((block->size & flag_used) ? " used" : " free") << std::endl;
+        ((block->size & flag_used) ? used : holes) += block->Payload();
+        blocks++;
+    }
+
+    out << blocks << " blocks, " << used << " bytes used, " << holes << " bytes in holes, " << (_end - _top)
+        << " bytes on top, " << (static_cast<char *>(_base) + _base_len - _end) / sizeof(void *)
+        << " slots" << std::endl;
+    return out.str();
+}
+
+// Returns used block with at least size bytes of payload or nullptr
+Simple::Block *Simple::_AllocBlock(size_t size) {
+    for (Block *block = _free_blocks; block != nullptr; block = block->FreeLinks()->next) {
+        if (block->Payload() < size) {
+            continue;
+        }
+
+        // Free block never follows other free block, so prev is used
+        _UnlinkFree(block);
+        block->size = block->Payload() | flag_used;
+
+        Block *next = block->Next();
+        if (reinterpret_cast<char *>(next) != _top) {
+            next->size &= ~flag_prev_free;
+        }
+        _Split(block, size);
+        return block;
+    }
+
+    if (size_t(_end - _top) < sizeof(Block) + size) {
+        return nullptr;
+    }
+
+    Block *block = reinterpret_cast<Block *>(_top);
+    block->size = size | flag_used;
+    _top += sizeof(Block) + size;
+    return block;
+}
+
+// Returns block to the free space merging it with free neighbours. Free block is
+// never adjacent to other free block or to the top
+void Simple::_Release(Block *block) {
+    size_t size = block->Payload();
+    Block *next = block->Next();
+
+    if (block->size & flag_prev_free) {
+        size_t prev_size = *(reinterpret_cast<size_t *>(block) - 1);
+        Block *prev = reinterpret_cast<Block *>(reinterpret_cast<char *>(block) - prev_size - sizeof(Block));
+        _UnlinkFree(prev);
+        size += prev_size + sizeof(Block);
+        block = prev;
+    }
+
+    if (reinterpret_cast<char *>(next) == _top) {
+        _top = reinterpret_cast<char *>(block);
+        return;
+    }
+
+    if (!(next->size & flag_used)) {
+        _UnlinkFree(next);
+        size += sizeof(Block) + next->Payload();
+    }
+    _MarkFree(block, size);
+}
+
+// Cuts block to the given size and releases the rest if it is big enough
+void Simple::_Split(Block *block, size_t size) {
+    size_t current = block->Payload();
+    if (current < size + sizeof(Block) + Block::min_payload) {
+        return;
+    }
+
+    block->size = size | (block->size & flags_mask);
+    Block *rest = block->Next();
+    rest->size = (current - size - sizeof(Block)) | flag_used;
+    _Release(rest);
+}
+
+// Turns block into free one and puts it into free list
+void Simple::_MarkFree(Block *block, size_t size) {
+    block->size = size;
+    *block->Footer() = size;
+
+    block->FreeLinks()->prev = nullptr;
+    block->FreeLinks()->next = _free_blocks;
+    if (_free_blocks != nullptr) {
+        _free_blocks->FreeLinks()->prev = block;
+    }
+    _free_blocks = block;
+
+    block->Next()->size |= flag_prev_free;
+}
+
+void Simple::_UnlinkFree(Block *block) {
+    Block::Links *l = block->FreeLinks();
+    if (l->prev != nullptr) {
+        l->prev->FreeLinks()->next = l->next;
+    } else {
+        _free_blocks = l->next;
+    }
+    if (l->next != nullptr) {
+        l->next->FreeLinks()->prev = l->prev;
+    }
+}
+
+void **Simple::_AcquireSlot() {
+    if (_free_slots != nullptr) {
+        void **slot = _free_slots;
+        _free_slots = static_cast<void **>(*slot);
+        return slot;
+    }
+
+    if (size_t(_end - _top) < sizeof(void *)) {
+        return nullptr;
+    }
+    _end -= sizeof(void *);
+    return reinterpret_cast<void **>(_end);
+}
+
+void Simple::_ReleaseSlot(void **slot) {
+    // Lowest slot goes back to the top right away
+    if (reinterpret_cast<char *>(slot) == _end) {
+        _end += sizeof(void *);
+        return;
+    }
+
+    *slot = _free_slots;
+    _free_slots = slot;
+}
+
+// Checks that pointer refers to the used block
+Simple::Block *Simple::_BlockOf(const Pointer &p) const {
+    char *address = static_cast<char *>(p.get());
+    char *slot = reinterpret_cast<char *>(p._slot);
+    char *slots_end = static_cast<char *>(_base) + _base_len;
+    if (slot < _end || slot >= slots_end || address < _begin + sizeof(Block) || address > _top) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't belong to the allocator");
+    }
+
+    Block *block = reinterpret_cast<Block *>(address) - 1;
+    if (!(block->size & flag_used) || block->slot != p._slot) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't refer to allocated block");
+    }
+    return block;
+}
 
 } // namespace Allocator
 } // namespace Afina
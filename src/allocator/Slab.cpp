@@ -0,0 +1,211 @@
+#include <afina/allocator/Slab.h>
+
+#include <sstream>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+// Chunks are always aligned to this boundary
+static const size_t chunk_alignment = 8;
+
+static size_t align_up(size_t value, size_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+// See Slab.h
+Slab::Slab(void *base, size_t size, size_t slab_size, size_t min_chunk, double factor)
+    : _slab_size(slab_size), _used(0), _free_slabs(nullptr), _free_slabs_count(0) {
+    if (slab_size == 0 || (slab_size & (slab_size - 1)) != 0) {
+        throw std::invalid_argument("Slab size must be a power of two");
+    }
+    if (factor <= 1.0 || min_chunk < sizeof(void *) || min_chunk > slab_size) {
+        throw std::invalid_argument("Invalid slab allocator size classes");
+    }
+
+    // Size classes: geometric progression up to the slab size, the last class
+    // always holds one chunk of the whole slab
+    size_t chunk = align_up(min_chunk, chunk_alignment);
+    while (chunk < slab_size) {
+        _pools.push_back(Pool{chunk, uint32_t(slab_size / chunk), nullptr, 0});
+        size_t next = align_up(size_t(chunk * factor), chunk_alignment);
+        chunk = (next > chunk) ? next : chunk + chunk_alignment;
+    }
+    _pools.push_back(Pool{slab_size, 1, nullptr, 0});
+
+    // Arena split into slabs, unaligned head and tail are not used
+    uintptr_t begin = align_up(reinterpret_cast<uintptr_t>(base), chunk_alignment);
+    uintptr_t end = reinterpret_cast<uintptr_t>(base) + size;
+    _base = reinterpret_cast<char *>(begin);
+
+    size_t n_slabs = (end > begin) ? (end - begin) / slab_size : 0;
+    _slabs.resize(n_slabs);
+    for (size_t i = n_slabs; i > 0; i--) {
+        _slabs[i - 1] = SlabInfo{0, 0, 0, nullptr, nullptr, nullptr};
+        _Push(_free_slabs, &_slabs[i - 1]);
+    }
+    _free_slabs_count = n_slabs;
+}
+
+// See Slab.h
+size_t Slab::size_class(size_t N) const {
+    size_t lo = 0, hi = _pools.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (_pools[mid].chunk_size < N) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// See Slab.h
+size_t Slab::size_class(const void *p) const { return _SlabOf(p)->size_class; }
+
+// See Slab.h
+size_t Slab::chunk_size(size_t N) const {
+    size_t cls = size_class(N);
+    return cls < _pools.size() ? _pools[cls].chunk_size : 0;
+}
+
+// See Slab.h
+void *Slab::alloc(size_t N) {
+    void *result = try_alloc(N);
+    if (result == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No free chunks of the requested size");
+    }
+    return result;
+}
+
+// See Slab.h
+void *Slab::try_alloc(size_t N) {
+    size_t cls = size_class(N);
+    if (cls >= _pools.size()) {
+        return nullptr;
+    }
+    Pool &pool = _pools[cls];
+
+    // No partially used slabs, take a new one from the arena
+    if (pool.partial == nullptr) {
+        if (_free_slabs == nullptr) {
+            return nullptr;
+        }
+        SlabInfo *slab = _free_slabs;
+        _Unlink(_free_slabs, slab);
+        _free_slabs_count--;
+
+        slab->size_class = cls;
+        slab->used = 0;
+        slab->carved = 0;
+        slab->free_list = nullptr;
+        _Push(pool.partial, slab);
+        pool.slabs++;
+    }
+
+    SlabInfo *slab = pool.partial;
+    void *result;
+    if (slab->free_list != nullptr) {
+        result = slab->free_list;
+        slab->free_list = *reinterpret_cast<void **>(result);
+    } else {
+        size_t index = slab - &_slabs[0];
+        result = _base + index * _slab_size + size_t(slab->carved) * pool.chunk_size;
+        slab->carved++;
+    }
+
+    slab->used++;
+    if (slab->used == pool.chunks_per_slab) {
+        _Unlink(pool.partial, slab);
+    }
+
+    _used += pool.chunk_size;
+    return result;
+}
+
+// See Slab.h
+void Slab::free(void *p) {
+    if (p == nullptr) {
+        return;
+    }
+
+    SlabInfo *slab = _SlabOf(p);
+    if (slab == nullptr || slab->used == 0) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't belong to allocated slab");
+    }
+
+    Pool &pool = _pools[slab->size_class];
+    size_t offset = (static_cast<char *>(p) - _base) % _slab_size;
+    if (offset % pool.chunk_size != 0 || offset / pool.chunk_size >= slab->carved) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't point to chunk begin");
+    }
+
+    // Slab was full, so it isn't in the partial list yet
+    if (slab->used == pool.chunks_per_slab) {
+        _Push(pool.partial, slab);
+    }
+
+    *reinterpret_cast<void **>(p) = slab->free_list;
+    slab->free_list = p;
+    slab->used--;
+    _used -= pool.chunk_size;
+
+    // Empty slab goes back to the arena, so other classes could use it
+    if (slab->used == 0) {
+        _Unlink(pool.partial, slab);
+        pool.slabs--;
+        _Push(_free_slabs, slab);
+        _free_slabs_count++;
+    }
+}
+
+// See Slab.h
+std::string Slab::dump() const {
+    std::stringstream out;
+    out << "slab allocator: " << _slabs.size() << " slabs of " << _slab_size << " bytes, " << _free_slabs_count
+        << " free, " << _used << " bytes used" << std::endl;
+    for (size_t i = 0; i < _pools.size(); i++) {
+        if (_pools[i].slabs == 0) {
+            continue;
+        }
+        out << "  class " << i << ": chunk " << _pools[i].chunk_size << " bytes, " << _pools[i].slabs << " slabs"
+            << std::endl;
+    }
+    return out.str();
+}
+
+// See Slab.h
+Slab::SlabInfo *Slab::_SlabOf(const void *p) const {
+    const char *ptr = static_cast<const char *>(p);
+    if (ptr < _base || ptr >= _base + _slabs.size() * _slab_size) {
+        return nullptr;
+    }
+    return const_cast<SlabInfo *>(&_slabs[(ptr - _base) / _slab_size]);
+}
+
+// See Slab.h
+void Slab::_Unlink(SlabInfo *&list, SlabInfo *slab) {
+    if (slab->prev != nullptr) {
+        slab->prev->next = slab->next;
+    } else {
+        list = slab->next;
+    }
+    if (slab->next != nullptr) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = nullptr;
+    slab->prev = nullptr;
+}
+
+// See Slab.h
+void Slab::_Push(SlabInfo *&list, SlabInfo *slab) {
+    slab->prev = nullptr;
+    slab->next = list;
+    if (list != nullptr) {
+        list->prev = slab;
+    }
+    list = slab;
+}
+
+} // namespace Allocator
+} // namespace Afina
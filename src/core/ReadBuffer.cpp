@@ -0,0 +1,61 @@
+#include "ReadBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace Afina {
+namespace Core {
+
+ReadBuffer::ReadBuffer(size_t capacity) : _data(new char[capacity]), _capacity(capacity), _begin(0), _end(0)
+{}
+
+void ReadBuffer::Consume(size_t count)
+{
+	assert(count <= Size());
+	_begin += count;
+	if (_begin == _end) { Clear(); }
+}
+
+void ReadBuffer::Clear()
+{
+	_begin = _end = 0;
+	if (_capacity > max_idle_capacity)
+	{
+		_data.reset(new char[default_capacity]);
+		_capacity = default_capacity;
+	}
+}
+
+char* ReadBuffer::Reserve(size_t count)
+{
+	if (Free() >= count) { return _data.get() + _end; }
+
+	size_t size = Size();
+	if (_capacity - size >= count && _begin >= size)
+	{
+		// Moves less than was consumed since the last move
+		std::memmove(_data.get(), _data.get() + _begin, size);
+	}
+	else
+	{
+		size_t capacity = std::max(_capacity * 2, size + count);
+		std::unique_ptr<char[]> data(new char[capacity]);
+		std::memcpy(data.get(), _data.get() + _begin, size);
+		_data = std::move(data);
+		_capacity = capacity;
+	}
+
+	_begin = 0;
+	_end = size;
+	return _data.get() + _end;
+}
+
+void ReadBuffer::Append(const char* data, size_t size)
+{
+	std::memcpy(Reserve(size), data, size);
+	Commit(size);
+}
+
+} //namespace Core
+} //namespace Afina
@@ -0,0 +1,64 @@
+#ifndef AFINA_READ_BUFFER_H
+#define AFINA_READ_BUFFER_H
+
+#include <cstddef>
+#include <memory>
+
+namespace Afina {
+namespace Core {
+
+/**
+ * # Input buffer of a connection
+ * Contiguous buffer that data is received into right away and is consumed from
+ * the front by advancing an offset, so parsing a pipelined input doesn't move
+ * bytes that are left. Unconsumed bytes are moved to the front only once they
+ * take less space than consumed ones, so each byte is moved a constant number
+ * of times on average. Data stays contiguous, so a command or its argument can
+ * always be read in one piece
+ */
+class ReadBuffer
+{
+	public:
+		static const size_t default_capacity = 16 * 1024;
+
+		// Empty buffer keeps no more memory than this, the rest is given back
+		static const size_t max_idle_capacity = 16 * default_capacity;
+
+	private:
+		std::unique_ptr<char[]> _data;
+		size_t _capacity;
+
+		// Unconsumed data is [_begin, _end)
+		size_t _begin;
+		size_t _end;
+
+	public:
+		explicit ReadBuffer(size_t capacity = default_capacity);
+
+		const char* Data() const { return _data.get() + _begin; }
+		size_t Size() const { return _end - _begin; }
+		bool Empty() const { return _begin == _end; }
+
+		// Drops count bytes from the front
+		void Consume(size_t count);
+		void Clear();
+
+		/**
+		 * Makes at least count bytes of free space after the data and returns
+		 * pointer to it. Once written, bytes must be added by Commit
+		 */
+		char* Reserve(size_t count);
+
+		// Free space available after the data without Reserve
+		size_t Free() const { return _capacity - _end; }
+
+		// Adds count bytes written to the free space
+		void Commit(size_t count) { _end += count; }
+
+		void Append(const char* data, size_t size);
+};
+
+} //namespace Core
+} //namespace Afina
+
+#endif // AFINA_READ_BUFFER_H
@@ -0,0 +1,28 @@
+#include <afina/Storage.h>
+#include <afina/execute/Cas.h>
+
+#include <iostream>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "cas" means "store this data but only if no one else has updated since I last fetched it".
+void Cas::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::cout << "Cas(" << _key << ", " << _version << "): " << args << std::endl;
+    switch (storage.CompareAndSet(_key, args, _version, _Deadline())) {
+    case CasResult::Stored:
+        out = "STORED";
+        break;
+    case CasResult::Exists:
+        out = "EXISTS";
+        break;
+    case CasResult::NotFound:
+        out = "NOT_FOUND";
+        break;
+    default:
+        out = "NOT_STORED";
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
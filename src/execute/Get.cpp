@@ -22,22 +22,34 @@ to indicate the end of response.
 */
 
 void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::vector<ValueRef> chunks;
+    Execute(storage, args, chunks);
+
+    out.clear();
+    for (const ValueRef &chunk : chunks) {
+        out.append(chunk.data(), chunk.size());
+    }
+}
+
+void Get::Execute(Storage &storage, const std::string &args, std::vector<ValueRef> &out) {
     std::stringstream keyStream;
     copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
     std::cout << "Get(" << keyStream.str() << ")" << std::endl;
 
-    std::stringstream outStream;
+    // Storage resolves all keys at once, that is much cheaper than lookup per key
+    std::vector<ValueRef> values;
+    storage.MultiGet(_keys, values);
 
-    std::string value;
-    for (auto &key : _keys) {
-        if (!storage.Get(key, value))
+    static const char crlf[] = "\r\n";
+    static const char end[] = "END"; // networking layer should add the last \r\n
+    for (size_t i = 0; i < _keys.size(); i++) {
+        if (!values[i])
             continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+        out.push_back(ValueRef::Copy("VALUE " + _keys[i] + " 0 " + std::to_string(values[i].size()) + "\r\n"));
+        out.push_back(std::move(values[i]));
+        out.push_back(ValueRef::Static(crlf, sizeof(crlf) - 1));
     }
-    outStream << "END"; // networking layer should add the last \r\n
-
-    out = outStream.str();
+    out.push_back(ValueRef::Static(end, sizeof(end) - 1));
 }
 
 } // namespace Execute
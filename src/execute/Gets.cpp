@@ -0,0 +1,44 @@
+#include <afina/Storage.h>
+#include <afina/execute/Gets.h>
+
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace Afina {
+namespace Execute {
+
+/* memcached protocol:
+
+Each item sent by the server in response to "gets" looks like this:
+
+VALUE <key> <flags> <bytes> <cas unique>\r\n
+<data block>\r\n
+
+*/
+
+void Gets::Execute(Storage &storage, const std::string &args, std::vector<ValueRef> &out) {
+    std::stringstream keyStream;
+    copy(keys().begin(), keys().end(), std::ostream_iterator<std::string>(keyStream, " "));
+    std::cout << "Gets(" << keyStream.str() << ")" << std::endl;
+
+    // Values and versions are read at once, so each version matches its value
+    std::vector<ValueRef> values;
+    std::vector<uint64_t> versions;
+    storage.Gets(keys(), values, versions);
+
+    static const char crlf[] = "\r\n";
+    static const char end[] = "END"; // networking layer should add the last \r\n
+    for (size_t i = 0; i < keys().size(); i++) {
+        if (!values[i])
+            continue;
+        out.push_back(ValueRef::Copy("VALUE " + keys()[i] + " 0 " + std::to_string(values[i].size()) + " " +
+                                     std::to_string(versions[i]) + "\r\n"));
+        out.push_back(std::move(values[i]));
+        out.push_back(ValueRef::Static(crlf, sizeof(crlf) - 1));
+    }
+    out.push_back(ValueRef::Static(end, sizeof(end) - 1));
+}
+
+} // namespace Execute
+} // namespace Afina
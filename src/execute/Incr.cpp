@@ -0,0 +1,22 @@
+#include <afina/Storage.h>
+#include <afina/execute/Incr.h>
+
+#include <iostream>
+#include <stdexcept>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "incr" means "add delta to the number stored for the key".
+void Incr::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::cout << "Incr(" << _key << ", " << _delta << ")" << std::endl;
+    try {
+        uint64_t value;
+        out = storage.Increment(_key, _delta, value) ? std::to_string(value) : "NOT_FOUND";
+    } catch (std::invalid_argument &) {
+        out = "CLIENT_ERROR cannot increment or decrement non-numeric value";
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
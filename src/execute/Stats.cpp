@@ -8,7 +8,29 @@
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+/* memcached protocol:
+
+Server sends statistics as lines of
+
+STAT <name> <value>\r\n
+
+terminated by the "END\r\n" line. Besides items count and bytes of keys and values
+(bytes), server reports memory it spends on items on top of that (bytes_overhead)
+
+*/
+
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    MemoryStats memory = storage.Memory();
+
+    std::stringstream outStream;
+    outStream << "STAT curr_items " << memory.items << "\r\n";
+    outStream << "STAT bytes " << memory.payload << "\r\n";
+    outStream << "STAT bytes_overhead " << memory.overhead << "\r\n";
+    outStream << "STAT limit_maxbytes " << memory.limit << "\r\n";
+    outStream << "END"; // networking layer should add the last \r\n
+
+    out = outStream.str();
+}
 
 } // namespace Execute
 } // namespace Afina
@@ -1,61 +1,147 @@
 #include <afina/lockfree/applier.h>
-#include <set>
-#include <string>
 
 namespace Afina {
 namespace LockFree {
 
-void Applier::flat_combine(void) {
-  Record* _head = head.load();
-  std::set<std::string> deleted;
-  while(_head != NULL) {
-    if (_head->active) {
-      switch(_head->slot.opcode) {
-        case Method::Put: {
-          if (deleted.count(_head->slot.key)) {
-            _head->slot.status = false;
-          } else {
-            _head->slot.status = storage->Put(_head->slot.key, _head->slot.val);
-          }
-          break;
-        }
-        case Method::PutIfAbsent: {
-          if (deleted.count(_head->slot.key)) {
-            _head->slot.status = false;
-          } else {
-            _head->slot.status = storage->PutIfAbsent(_head->slot.key, _head->slot.val);
-          }
-
-          break;
-        }
-        case Method::Delete: {
-          deleted.insert(_head->slot.key);
-          _head->slot.status = storage->Delete(_head->slot.key);
-          break;
-        }
-        case Method::Set: {
-          if (deleted.count(_head->slot.key)) {
-            _head->slot.status = false;
-          } else {
-            _head->slot.status = storage->Set(_head->slot.key, _head->slot.val);
-          }
-          break;
-        }
-        case Method::Get: {
-          if (deleted.count(_head->slot.key)) {
-            _head->slot.status = false;
-          } else {
-            _head->slot.status = storage->Get(_head->slot.key, _head->slot.res);
-          }
-          break;
-        }
-      }
-      _head->active = false;
+bool Applier::Put(const std::string& key, const std::string& value, time_t expire) {
+  return execute(Method::Put, &key, &value, nullptr, expire);
+}
+
+bool Applier::PutIfAbsent(const std::string& key, const std::string& value, time_t expire) {
+  return execute(Method::PutIfAbsent, &key, &value, nullptr, expire);
+}
+
+bool Applier::Set(const std::string& key, const std::string& value, time_t expire) {
+  return execute(Method::Set, &key, &value, nullptr, expire);
+}
+
+bool Applier::Delete(const std::string& key) {
+  return execute(Method::Delete, &key, nullptr, nullptr);
+}
+
+bool Applier::Append(const std::string& key, const std::string& data) {
+  return execute(Method::Append, &key, &data, nullptr);
+}
+
+bool Applier::Prepend(const std::string& key, const std::string& data) {
+  return execute(Method::Prepend, &key, &data, nullptr);
+}
+
+bool Applier::Increment(const std::string& key, uint64_t delta, uint64_t& value) {
+  return count(Method::Increment, key, delta, value);
+}
+
+bool Applier::Decrement(const std::string& key, uint64_t delta, uint64_t& value) {
+  return count(Method::Decrement, key, delta, value);
+}
+
+bool Applier::Get(const std::string& key, std::string& value) const {
+  return execute(Method::Get, &key, nullptr, &value);
+}
+
+ValueRef Applier::GetRef(const std::string& key) const {
+  ValueRef ref;
+  execute(Method::GetRef, &key, nullptr, nullptr, 0, nullptr, &ref);
+  return ref;
+}
+
+size_t Applier::MultiGet(const std::vector<std::string>& keys, std::vector<ValueRef>& values) const {
+  MultiGetArgs multi{&keys, &values, nullptr, 0};
+  execute(Method::MultiGet, nullptr, nullptr, nullptr, 0, &multi);
+  return multi.count;
+}
+
+size_t Applier::Gets(const std::vector<std::string>& keys, std::vector<ValueRef>& values,
+                     std::vector<uint64_t>& versions) const {
+  MultiGetArgs multi{&keys, &values, &versions, 0};
+  execute(Method::Gets, nullptr, nullptr, nullptr, 0, &multi);
+  return multi.count;
+}
+
+CasResult Applier::CompareAndSet(const std::string& key, const std::string& value, uint64_t version,
+                                 time_t expire) {
+  CasArgs cas{version, CasResult::NotFound};
+  execute(Method::CompareAndSet, &key, &value, nullptr, expire, nullptr, nullptr, &cas);
+  return cas.result;
+}
+
+bool Applier::count(Method opcode, const std::string& key, uint64_t delta, uint64_t& value) {
+  CounterArgs counter{delta, 0};
+  bool found = execute(opcode, &key, nullptr, nullptr, 0, nullptr, nullptr, nullptr, &counter);
+  value = counter.value;
+  return found;
+}
+
+bool Applier::execute(Method opcode, const std::string* key, const std::string* val, std::string* res,
+                      time_t expire, MultiGetArgs* multi, ValueRef* ref, CasArgs* cas,
+                      CounterArgs* counter) const {
+  Storage* backend = storage.get();
+  ApplierSlot request{false, opcode, key, val, res, expire, multi, ref, cas, counter, nullptr};
+
+  // Runs in the combiner thread, requests of other threads included
+  ApplierSlot& result = combiner.execute(request, [backend](ApplierSlot& slot) {
+    try {
+      apply(*backend, slot);
+    } catch (...) {
+      slot.error = std::current_exception();
     }
-    _head = _head->next;
+  });
+
+  if (result.error) {
+    std::exception_ptr error;
+    std::swap(error, result.error);
+    std::rethrow_exception(error);
   }
+  return result.status;
 }
 
-} // LockFree
+void Applier::apply(Storage& backend, ApplierSlot& slot) {
+  switch(slot.opcode) {
+    case Method::Put:
+      slot.status = backend.Put(*slot.key, *slot.val, slot.expire);
+      break;
+    case Method::PutIfAbsent:
+      slot.status = backend.PutIfAbsent(*slot.key, *slot.val, slot.expire);
+      break;
+    case Method::Set:
+      slot.status = backend.Set(*slot.key, *slot.val, slot.expire);
+      break;
+    case Method::Delete:
+      slot.status = backend.Delete(*slot.key);
+      break;
+    case Method::Append:
+      slot.status = backend.Append(*slot.key, *slot.val);
+      break;
+    case Method::Prepend:
+      slot.status = backend.Prepend(*slot.key, *slot.val);
+      break;
+    case Method::Get:
+      slot.status = backend.Get(*slot.key, *slot.res);
+      break;
+    case Method::GetRef:
+      *slot.ref = backend.GetRef(*slot.key);
+      slot.status = static_cast<bool>(*slot.ref);
+      break;
+    case Method::MultiGet:
+      slot.multi->count = backend.MultiGet(*slot.multi->keys, *slot.multi->values);
+      slot.status = true;
+      break;
+    case Method::Gets:
+      slot.multi->count = backend.Gets(*slot.multi->keys, *slot.multi->values, *slot.multi->versions);
+      slot.status = true;
+      break;
+    case Method::CompareAndSet:
+      slot.cas->result = backend.CompareAndSet(*slot.key, *slot.val, slot.cas->version, slot.expire);
+      slot.status = slot.cas->result == CasResult::Stored;
+      break;
+    case Method::Increment:
+      slot.status = backend.Increment(*slot.key, slot.counter->delta, slot.counter->value);
+      break;
+    case Method::Decrement:
+      slot.status = backend.Decrement(*slot.key, slot.counter->delta, slot.counter->value);
+      break;
+  }
+}
 
+} // LockFree
 } // Afina
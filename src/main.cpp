@@ -7,17 +7,26 @@
 
 #include <afina/Storage.h>
 #include <afina/Version.h>
+#include <afina/lockfree/applier.h>
 #include <afina/network/Server.h>
 
 #include "pipes/FIFOServer.h"
 
 #include "network/blocking/ServerImpl.h"
 #include "network/nonblocking/ServerImpl.h"
+#include "network/uring/ServerImpl.h"
 #include "network/uv/ServerImpl.h"
+#include "storage/MapBasedEpochImpl.h"
 #include "storage/MapBasedGlobalLockImpl.h"
+#include "storage/MapBasedSlabImpl.h"
+#include "storage/MapBasedStripedLockImpl.h"
+#include "storage/MapBasedTieredImpl.h"
+#include "storage/Snapshot.h"
+#include "storage/WriteAheadLog.h"
 
 typedef struct {
     std::shared_ptr<Afina::Storage> storage;
+    std::shared_ptr<Afina::Backend::Snapshot> snapshot;
     std::shared_ptr<Afina::Network::Server> server;
 	std::shared_ptr<Afina::FIFONamespace::FIFOServer> fifo;
 } Application;
@@ -51,7 +60,23 @@ int main(int argc, char **argv) {
         // TODO: use custom cxxopts::value to print options possible values in help message
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
+        options.add_options()("e,eviction", "Eviction policy: lru, clock, slru or tinylfu",
+                              cxxopts::value<std::string>());
+        options.add_options()("m,memory", "Memory limit for items in megabytes, overhead included",
+                              cxxopts::value<size_t>());
+        options.add_options()("spill", "File for values of map_tiered storage evicted from memory",
+                              cxxopts::value<std::string>());
+        options.add_options()("spill-size", "Size of the spill file in megabytes", cxxopts::value<size_t>());
+        options.add_options()("compress", "Keep values of at least that many bytes compressed",
+                              cxxopts::value<size_t>());
+        options.add_options()("f,flat-combine", "Apply storage operations in batches by flat combining");
+        options.add_options()("snapshot", "File to load storage from on start and to save it to periodically",
+                              cxxopts::value<std::string>());
+        options.add_options()("wal", "Log file to make every change durable before it is acknowledged",
+                              cxxopts::value<std::string>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("listen", "How nonblocking workers listen: shared, reuseport or cpu",
+                              cxxopts::value<std::string>());
 		options.add_options()("r,read", "Reading FIFO name", cxxopts::value<std::string>());
 		options.add_options()("w,write", "Writing FIFO name", cxxopts::value<std::string>());
         options.add_options()("h,help", "Print usage info");
@@ -76,12 +101,76 @@ int main(int argc, char **argv) {
         storage_type = options["storage"].as<std::string>();
     }
 
+    std::string eviction = "lru";
+    if (options.count("eviction") > 0) {
+        eviction = options["eviction"].as<std::string>();
+    }
+
+    size_t memory = 64;
+    if (options.count("memory") > 0) {
+        memory = options["memory"].as<size_t>();
+    }
+    memory *= 1024 * 1024;
+
+    size_t compress = 0;
+    if (options.count("compress") > 0) {
+        compress = options["compress"].as<size_t>();
+    }
+
+    // Payload can't exceed memory limit, so it is the only one that matters
     if (storage_type == "map_global") {
-        app.storage = std::make_shared<Afina::Backend::MapBasedGlobalLockImpl>();
+        auto storage = std::make_shared<Afina::Backend::MapBasedGlobalLockImpl>(
+            memory, Afina::Backend::EvictionPolicy::Create(eviction, memory), memory);
+        storage->SetCompression(compress);
+        app.storage = storage;
+    } else if (storage_type == "striped_lru") {
+        auto storage = std::make_shared<Afina::Backend::MapBasedStripedLockImpl>(memory, 16, eviction, memory);
+        storage->SetCompression(compress);
+        app.storage = storage;
+    } else if (storage_type == "map_slab") {
+        auto storage = std::make_shared<Afina::Backend::MapBasedSlabImpl>(memory, eviction);
+        storage->SetCompression(compress);
+        app.storage = storage;
+    } else if (storage_type == "epoch_lru") {
+        if (compress != 0) {
+            throw std::runtime_error("Compression is not supported by epoch_lru storage");
+        }
+        app.storage = std::make_shared<Afina::Backend::MapBasedEpochImpl>(memory, memory);
+    } else if (storage_type == "map_tiered") {
+        std::string spill = "afina.spill";
+        if (options.count("spill") > 0) {
+            spill = options["spill"].as<std::string>();
+        }
+        size_t spill_size = 1024;
+        if (options.count("spill-size") > 0) {
+            spill_size = options["spill-size"].as<size_t>();
+        }
+        auto storage = std::make_shared<Afina::Backend::MapBasedTieredImpl>(memory, spill, spill_size * 1024 * 1024,
+                                                                            eviction, memory);
+        storage->SetCompression(compress);
+        app.storage = storage;
     } else {
         throw std::runtime_error("Unknown storage type");
     }
 
+    if (options.count("flat-combine") > 0) {
+        app.storage = std::make_shared<Afina::LockFree::Applier>(app.storage);
+    }
+
+    if (options.count("snapshot") > 0) {
+        app.snapshot = std::make_shared<Afina::Backend::Snapshot>(app.storage, options["snapshot"].as<std::string>());
+    }
+
+    // Log is outside of the flat combining, so concurrent writers share fsyncs.
+    // Compacted log is a full image of the storage, so it takes the snapshot
+    // only if there is no log yet
+    std::shared_ptr<Afina::Backend::WriteAheadLog> wal;
+    if (options.count("wal") > 0) {
+        std::string snapshot = options.count("snapshot") > 0 ? options["snapshot"].as<std::string>() : std::string();
+        wal = std::make_shared<Afina::Backend::WriteAheadLog>(app.storage, options["wal"].as<std::string>(), snapshot);
+        app.storage = wal;
+    }
+
     // Build  & start network layer
     std::string network_type = "uv";
     if (options.count("network") > 0) {
@@ -93,7 +182,25 @@ int main(int argc, char **argv) {
     } else if (network_type == "blocking") {
         app.server = std::make_shared<Afina::Network::Blocking::ServerImpl>(app.storage);
     } else if (network_type == "nonblocking") {
-        app.server = std::make_shared<Afina::Network::NonBlocking::ServerImpl>(app.storage);
+        using Afina::Network::NonBlocking::ServerImpl;
+        std::string listen = "shared";
+        if (options.count("listen") > 0) {
+            listen = options["listen"].as<std::string>();
+        }
+
+        ServerImpl::Listening listening;
+        if (listen == "shared") {
+            listening = ServerImpl::Listening::Shared;
+        } else if (listen == "reuseport") {
+            listening = ServerImpl::Listening::PerWorker;
+        } else if (listen == "cpu") {
+            listening = ServerImpl::Listening::PerCpu;
+        } else {
+            throw std::runtime_error("Unknown listen mode");
+        }
+        app.server = std::make_shared<ServerImpl>(app.storage, listening);
+    } else if (network_type == "uring") {
+        app.server = std::make_shared<Afina::Network::Uring::ServerImpl>(app.storage);
     } else {
         throw std::runtime_error("Unknown network type");
     }
@@ -131,7 +238,18 @@ int main(int argc, char **argv) {
 
     // Start services
     try {
+        // Cache is warmed up before the first client comes
+        if (app.snapshot != nullptr && wal == nullptr) {
+            std::cout << "Loaded " << app.snapshot->Load() << " items from snapshot" << std::endl;
+        }
         app.storage->Start();
+        if (wal != nullptr) {
+            std::cout << "Loaded " << wal->Loaded() << " items from snapshot, replayed " << wal->Replayed()
+                      << " log records" << std::endl;
+        }
+        if (app.snapshot != nullptr) {
+            app.snapshot->Start();
+        }
         app.server->Start(8080);
 	if (app.fifo != nullptr) { app.fifo->Start(reading_fifo_name, writing_fifo_name); }
 
@@ -146,6 +264,9 @@ int main(int argc, char **argv) {
 		app.fifo->Stop();
 		app.fifo->Join();
 	}
+        if (app.snapshot != nullptr) {
+            app.snapshot->Stop();
+        }
         app.storage->Stop();
 
         std::cout << "Application stopped" << std::endl;
@@ -12,6 +12,7 @@
 #include <netdb.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -231,64 +232,25 @@ void ServerImpl::RunConnection(int client_socket) {
     // TODO: All connection work is here
 
 	// TODO: Start new thread and process data from/to connection
-	Afina::Protocol::Parser parser;
-	std::string current_data;
+	Afina::Protocol::Executor executor(pStorage);
 	while (running.load()) {
-		char new_data [reading_portion_g] = "";
-		if (recv(client_socket, new_data, reading_portion_g * sizeof(char), 0) <= 0) { break; }
-		current_data.append(new_data);
-		memset(new_data, 0, reading_portion_g *sizeof(char)); //No set '\0' in recv function
-		
-		size_t parsed = 0;
-		bool was_command = false;
-		try {
-			was_command = parser.Parse(current_data, parsed);
-		}
-		catch(std::exception& e) {
-			std::string error_msg = "Parsing error: ";
-			error_msg += e.what();
-			error_msg += "\r\n";
-			send(client_socket, error_msg.c_str(), error_msg.size(), 0);
-			current_data = "";
-			parser.Reset();
-			continue;
-		}
-		current_data = current_data.substr(parsed); //remove command from received data
-		if (!was_command) { continue; } //more data is needed
-		
-		//if command was accepted
-		uint32_t read_for_arg = 0;
-		auto command = parser.Build(read_for_arg);
-		if (read_for_arg != 0) { read_for_arg += 2; } //\r\n
-		if (read_for_arg > current_data.size()) { //we need to read some more for argument. Not need if no argument is needed
-			if (recv(client_socket, new_data, (read_for_arg) * sizeof(char), MSG_WAITALL) <= 0) {
-				NETWORK_CURRENT_PROCESS_DEBUG("Server hasn't received argument from client before the socket was closed");
-				break;
-			}
-			current_data.append(new_data);
+		Core::ReadBuffer& input = executor.GetInput();
+		ssize_t received = recv(client_socket, input.Reserve(reading_portion_g), input.Free(), 0);
+		if (received <= 0) { break; }
+		input.Commit(received);
+
+		// Responses to all commands of the portion are sent together
+		executor.TryExecute();
+		bool sent = true;
+		while (sent && executor.HasOutputData()) {
+			ssize_t len_sended = writev(client_socket, executor.GetOutputAsIovec(), executor.GetQueueSize());
+			if (len_sended <= 0) { sent = false; }
+			else { executor.RemoveFromOutput(len_sended); }
 		}
-		std::string argument;
-		if (read_for_arg > 2) {
-			argument = current_data.substr(0, read_for_arg-2); // \r\n not needed
-			current_data = current_data.substr(read_for_arg); //remove argument from received data
-		}
-
-		std::string out;
-		try {
-			command->Execute(*pStorage, argument, out);
-		}
-		catch(std::exception& e) {
-			out = "SERVER ERROR ";
-			out += e.what();
-		}
-		out += "\r\n";
-		size_t len_sended = send(client_socket, out.c_str(), out.size(), 0);
-		if (len_sended < out.size()) {
+		if (!sent) {
 			NETWORK_CURRENT_PROCESS_DEBUG("Server cannot send all data to client");
 			break;
 		}
-
-		parser.Reset();
 	}
 
 	close(client_socket);
@@ -9,6 +9,7 @@
 #include <iostream>
 
 #include <afina/network/Server.h>
+#include "./../../protocol/Executor.h"
 #include "./../../protocol/Parser.h"
 #include <afina/execute/Command.h>
 #include "./../../core/ThreadPool.h"
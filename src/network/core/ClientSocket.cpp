@@ -24,7 +24,7 @@ ClientSocket::IOInformation ClientSocket::Receive(std::string& out, int count, b
 		info.state = _InterpretateReturnValue(result);
 		if (result > 0)
 		{
-			out.append(new_data);
+			out.append(new_data, result);
 			info.result += result;
 			count -= reading_portion;
 		}
@@ -37,6 +37,18 @@ ClientSocket::IOInformation ClientSocket::Receive(std::string& out, int count, b
 	return info;
 }
 
+ClientSocket::IOInformation ClientSocket::Receive(Core::ReadBuffer& buffer)
+{
+	if (!_opened) { throw NetworkException("Cannot use ClientSocket from ServerSocket::AcceptInformation structure with incorrect state!"); }
+
+	char* free_space = buffer.Reserve(reading_portion);
+	int result = recv(_fd_id, free_space, buffer.Free(), 0);
+	IOInformation info = {IO_OPERATION_STATE::OK, result};
+	info.state = _InterpretateReturnValue(result);
+	if (result > 0) { buffer.Commit(result); }
+	return info;
+}
+
 ClientSocket::IOInformation ClientSocket::Send(const std::string& data)
 {
 	if (!_opened) { throw NetworkException("Cannot use ClientSocket from ServerSocket::AcceptInformation structure with incorrect state!"); }
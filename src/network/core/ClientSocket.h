@@ -2,6 +2,7 @@
 #define AFINA_NETWORK_CLIENT_SOCKET_H
 
 #include "Socket.h"
+#include "./../../core/ReadBuffer.h"
 
 #include <string>
 
@@ -31,6 +32,8 @@ class ClientSocket : public Socket
 		static const unsigned int reading_portion = 1024;
 		//Recieved information will be append to "out" string
 		IOInformation Receive(std::string& out, int count = reading_portion, bool wait_all = false);
+		//Receives right into the free space of buffer, at least reading_portion bytes of it
+		IOInformation Receive(Core::ReadBuffer& buffer);
 		IOInformation Send(const std::string& data);
 		IOInformation Send(const iovec iov[], int count);
 };
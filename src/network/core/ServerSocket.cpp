@@ -1,5 +1,7 @@
 #include <utility>
 
+#include <linux/filter.h>
+
 #include "ServerSocket.h"
 
 namespace Afina {
@@ -60,6 +62,20 @@ void ServerSocket::Start(unsigned int port, unsigned int max_listeners, bool mul
 	VALIDATE_NETWORK_FUNCTION(listen(_fd_id, max_listeners));
 }
 
+void ServerSocket::SteerByCpu(unsigned int listeners)
+{
+	// A = CPU of the packet, return A % listeners. With fewer listeners than CPUs the modulo sends
+	// CPU j to listener j % listeners, which runs on another core, so locality holds only when every
+	// CPU has its own listener
+	sock_filter code[] = {
+		{BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+		{BPF_ALU | BPF_MOD | BPF_K, 0, 0, listeners},
+		{BPF_RET | BPF_A, 0, 0, 0},
+	};
+	sock_fprog program = {sizeof(code) / sizeof(code[0]), code};
+	VALIDATE_NETWORK_FUNCTION(setsockopt(_fd_id, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)));
+}
+
 ServerSocket::AcceptInformation ServerSocket::Accept(sockaddr_in* client_addr)
 {
 	if (client_addr == nullptr)
@@ -26,6 +26,10 @@ class ServerSocket : public Socket
 
 		//If multiple_listeners = true, SO_REUSEPORT option will be set
 		void Start(unsigned int port, unsigned int max_listeners, bool multiple_listeners = false);
+
+		//Attaches program to the SO_REUSEPORT group of the socket that sends connection to the listener with index
+		//of the CPU that received it, modulo number of listeners. Index is the order listeners joined the group in
+		void SteerByCpu(unsigned int listeners);
 		
 		//If client_addr != nullptr, information about client will be writed to structure
 		AcceptInformation Accept(sockaddr_in* client_addr = nullptr);
@@ -1,10 +1,12 @@
 #include "ServerImpl.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <thread>
 
 #include <arpa/inet.h>
 #include <netdb.h>
@@ -21,8 +23,8 @@ namespace Network {
 namespace NonBlocking {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps)
-    : Server(ps), _server_socket(std::make_shared<ServerSocket>()) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, Listening listening)
+    : Server(ps), _listening(listening) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() { Stop(); }
@@ -41,15 +43,37 @@ void ServerImpl::Start(uint16_t port, uint16_t n_workers) {
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // Create server socket
-    _server_socket->Start(port, max_listen, true);
-    _server_socket->MakeNonblocking();
+    // Worker per CPU at most, extra ones would get no connections
+    unsigned n_cpus = std::thread::hardware_concurrency();
+    if (_listening == Listening::PerCpu) {
+        if (n_cpus == 0) {
+            throw std::runtime_error("Unable to get number of CPUs");
+        }
+        n_workers = std::min<unsigned>(n_workers, n_cpus);
+    }
+
+    // Create server sockets. Sockets of the workers join one SO_REUSEPORT group in the order of
+    // workers, so the group index of each socket is the index of its worker
+    size_t n_sockets = _listening == Listening::Shared ? 1 : n_workers;
+    for (size_t i = 0; i < n_sockets; i++) {
+        auto server_socket = std::make_shared<ServerSocket>();
+        server_socket->Start(port, max_listen, true);
+        server_socket->MakeNonblocking();
+        _server_sockets.push_back(server_socket);
+    }
+
+    // Worker i is pinned to CPU i and the group sends connection to the socket with index of
+    // the CPU that received it
+    if (_listening == Listening::PerCpu) {
+        _server_sockets.front()->SteerByCpu(n_workers);
+    }
 
     for (int i = 0; i < n_workers; i++) {
         _workers.emplace_back(pStorage);
     }
-    for (auto it = _workers.begin(); it != _workers.end(); it++) {
-        it->Start(_server_socket, max_listen);
+    for (size_t i = 0; i < _workers.size(); i++) {
+        int cpu = _listening == Listening::PerCpu ? i : -1;
+        _workers[i].Start(_server_sockets[i % n_sockets], max_listen, cpu);
     }
 }
 
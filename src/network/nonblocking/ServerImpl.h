@@ -2,6 +2,7 @@
 #define AFINA_NETWORK_NONBLOCKING_SERVER_H
 
 #include <deque>
+#include <vector>
 
 #include <afina/network/Server.h>
 
@@ -18,7 +19,21 @@ namespace NonBlocking {
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps);
+    // How workers get connections
+    enum class Listening {
+        // Workers wait on the one shared socket, connection goes to the worker that wakes up
+        Shared,
+
+        // Each worker listens on its own SO_REUSEPORT socket, kernel balances connections by hash
+        PerWorker,
+
+        // As PerWorker, but each worker is pinned to a CPU and gets connections whose packets
+        // are processed by that CPU, so the connection stays on the core of its NIC queue. There
+        // are no more workers than CPUs
+        PerCpu
+    };
+
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, Listening listening = Listening::Shared);
     ~ServerImpl();
 
     // See Server.h
@@ -31,7 +46,10 @@ public:
     void Join() override;
 
 private:
-    std::shared_ptr<ServerSocket> _server_socket;
+    Listening _listening;
+
+    // Single shared socket or socket per worker, in the order of workers
+    std::vector<std::shared_ptr<ServerSocket>> _server_sockets;
 
     // Thread that is accepting new connections
     std::deque<Worker> _workers;
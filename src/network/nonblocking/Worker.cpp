@@ -2,6 +2,8 @@
 
 #include <iostream>
 
+#include <pthread.h>
+#include <sched.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -21,7 +23,7 @@ Worker::~Worker() {
 }
 
 // See Worker.h
-void Worker::Start(std::shared_ptr<ServerSocket> server_socket, size_t max_listeners) {
+void Worker::Start(std::shared_ptr<ServerSocket> server_socket, size_t max_listeners, int cpu) {
 	NETWORK_DEBUG(__PRETTY_FUNCTION__);
     
 	if (!server_socket->IsNonblocking()) {
@@ -38,6 +40,15 @@ void Worker::Start(std::shared_ptr<ServerSocket> server_socket, size_t max_liste
 
 	_current_state.store(STATE::WORKS);
 	_thread = std::thread(&Worker::_ThreadWrapper, this);
+
+	if (cpu >= 0) {
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		if (pthread_setaffinity_np(_thread.native_handle(), sizeof(cpus), &cpus) != 0) {
+			NETWORK_DEBUG("Unable to pin worker to CPU " << cpu);
+		}
+	}
 }
 
 void Worker::_SignalHandler(int) {
@@ -72,25 +83,31 @@ void Worker::_ThreadWrapper() {
 	}
 }
 
-bool Worker::_ReadFromSocket(int epoll, ClientAndExecutor& client_executor) {
-	std::string str;
-	auto io_information = client_executor.client.Receive(str);
-	while (io_information.state == Core::FileDescriptor::IO_OPERATION_STATE::OK) {
+bool Worker::_ReadFromSocket(ClientAndExecutor& client_executor) {
+	// Edge triggered socket must be read till EAGAIN, otherwise there is no new event for the rest of data. If the
+	// budget is over first, connection is put to the ready list and is read again after the others
+	client_executor.ready = false;
+	for (size_t read = 0; read < read_budget;) {
+		auto io_information = client_executor.client.Receive(client_executor.executor.GetInput());
+		if (io_information.state == Core::FileDescriptor::IO_OPERATION_STATE::ASYNC_ERROR) { break; }
+		if (io_information.state == Core::FileDescriptor::IO_OPERATION_STATE::ERROR) { return false; }
 		if (io_information.result == 0) { return false; } //Socket was closed
 
-		if (client_executor.executor.AppendAndTryExecute(str)) {
-			epoll_event socket_event = {};
-			socket_event.data.fd = client_executor.client.GetID();
-			socket_event.events = EPOLLIN | EPOLLOUT;
-			VALIDATE_NETWORK_FUNCTION(epoll_ctl(epoll, EPOLL_CTL_MOD, client_executor.client.GetID(), &socket_event));
+		read += io_information.result;
+		client_executor.executor.TryExecute();
+		if (read >= read_budget) {
+			client_executor.ready = true;
+			_ready.push_back(client_executor.client.GetID());
 		}
-		io_information = client_executor.client.Receive(str);
 	}
-	if (io_information.state == Core::FileDescriptor::IO_OPERATION_STATE::ASYNC_ERROR) { return true; }
-	else { return false; }
+
+	// Responses to everything read in this turn are flushed together
+	return _WriteToSocket(client_executor);
 }
 
-bool Worker::_WriteToSocket(int epoll, ClientAndExecutor& client_executor) {
+bool Worker::_WriteToSocket(ClientAndExecutor& client_executor) {
+	// Socket is registered for EPOLLOUT once, so it is enough to stop on EAGAIN: edge triggered event comes as soon
+	// as there is room again
 	while (client_executor.executor.HasOutputData()) {
 		auto io_information = client_executor.client.Send(client_executor.executor.GetOutputAsIovec(), client_executor.executor.GetQueueSize());
 		if (io_information.state == Core::FileDescriptor::IO_OPERATION_STATE::ASYNC_ERROR) { return true; }
@@ -98,11 +115,6 @@ bool Worker::_WriteToSocket(int epoll, ClientAndExecutor& client_executor) {
 
 		client_executor.executor.RemoveFromOutput(io_information.result);
 	}
-	
-	epoll_event socket_event = {};
-	socket_event.data.fd = client_executor.client.GetID();
-	socket_event.events = EPOLLIN;
-	VALIDATE_NETWORK_FUNCTION(epoll_ctl(epoll, EPOLL_CTL_MOD, client_executor.client.GetID(), &socket_event));
 	return true;
 }
 
@@ -135,7 +147,8 @@ void Worker::_ThreadFunction() {
 	}
 	
 	while (_current_state.load() == STATE::WORKS) {
-		int n = epoll_wait(epoll, events, _max_listeners + 1, -1);
+		// Connections left with unread data must not wait for new events
+		int n = epoll_wait(epoll, events, _max_listeners + 1, _ready.empty() ? -1 : 0);
 		if (n == -1) {
 			if (errno == EINTR && _current_state.load() != STATE::WORKS) { break; } //Worker is stopping
 			else {
@@ -152,7 +165,7 @@ void Worker::_ThreadFunction() {
 
 				accept_information.socket.MakeNonblocking();
 				socket_event.data.fd = accept_information.socket.GetID();
-				socket_event.events = EPOLLIN;
+				socket_event.events = EPOLLIN | EPOLLOUT | EPOLLET;
 				VALIDATE_NETWORK_FUNCTION(epoll_ctl(epoll, EPOLL_CTL_ADD, accept_information.socket.GetID(), &socket_event));
 				_clients.emplace(std::make_pair(accept_information.socket.GetID(), ClientAndExecutor(std::move(accept_information.socket), _storage)));
 			}
@@ -167,24 +180,34 @@ void Worker::_ThreadFunction() {
 					continue;
 				}
 
-				auto client_executor = &(_clients.find(events[i].data.fd)->second);
-				if (events[i].events & EPOLLIN) {
-					if (!_ReadFromSocket(epoll, *client_executor)) {
+				auto client_executor = &(client->second);
+				if (events[i].events & EPOLLIN && !client_executor->ready) {
+					if (!_ReadFromSocket(*client_executor)) {
 						_clients.erase(client);
 						continue;
 					}
 				}
 				if (events[i].events & EPOLLOUT) {
-					if (!_WriteToSocket(epoll, *client_executor)) {
+					if (!_WriteToSocket(*client_executor)) {
 						_clients.erase(client);
 						continue;
 					}
 				}
 			}
 		}
+
+		// Each connection that is out of budget gets one more turn, those that are out again go to the end of list
+		std::vector<int> ready;
+		ready.swap(_ready);
+		for (int fd : ready) {
+			auto client = _clients.find(fd);
+			if (client == _clients.end() || !client->second.ready) { continue; }
+			if (!_ReadFromSocket(client->second)) { _clients.erase(client); }
+		}
 	}
 	
 	_clients.clear();
+	_ready.clear();
 	free(events);
 }
 
@@ -8,6 +8,7 @@
 #include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <errno.h>
 #include <signal.h>
@@ -40,9 +41,9 @@ public:
     /**
      * Spaws new background thread that is doing epoll on the given server
      * socket. Once connection accepted it must be registered and being processed
-     * on this thread
+     * on this thread. Thread is pinned to the given CPU unless it is negative
      */
-    void Start(std::shared_ptr<ServerSocket> server_socket, size_t max_listeners);
+    void Start(std::shared_ptr<ServerSocket> server_socket, size_t max_listeners, int cpu = -1);
 
     /**
      * Signal background thread to stop. After that signal thread must stop to
@@ -60,6 +61,9 @@ public:
 
     int GetThreadId() { return _thread.native_handle(); }
 
+    // Bytes read from one connection per turn, so a busy client can't starve the others
+    static const size_t read_budget = 64 * ClientSocket::reading_portion;
+
 private:
     enum class STATE { STOPPED, STOPPING, WORKS };
 
@@ -67,8 +71,11 @@ private:
         ClientSocket client;
         Protocol::Executor executor;
 
+        // Read budget is over before EAGAIN, connection is in the ready list
+        bool ready;
+
         ClientAndExecutor(ClientSocket &&client_socket, std::shared_ptr<Afina::Storage> storage)
-            : client(std::move(client_socket)), executor(storage) {}
+            : client(std::move(client_socket)), executor(storage), ready(false) {}
     };
 
 private:
@@ -80,8 +87,10 @@ private:
 
     static void _SignalHandler(int signal);
 
-    bool _ReadFromSocket(int epoll, ClientAndExecutor &client_executor);
-    bool _WriteToSocket(int epoll, ClientAndExecutor &client_executor);
+    // Both return false if connection must be closed. Responses are written right after execution, EPOLLOUT is only
+    // waited for once socket buffer is full
+    bool _ReadFromSocket(ClientAndExecutor &client_executor);
+    bool _WriteToSocket(ClientAndExecutor &client_executor);
 
 private:
     std::thread _thread;
@@ -90,6 +99,7 @@ private:
 
     std::shared_ptr<ServerSocket> _server_socket;
     std::unordered_map<int, ClientAndExecutor> _clients;
+    std::vector<int> _ready;
     size_t _max_listeners;
 
     std::shared_ptr<Afina::Storage> _storage;
@@ -0,0 +1,180 @@
+#include "Ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+namespace {
+
+int io_uring_setup(unsigned entries, io_uring_params *params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+std::runtime_error Error(const std::string &message) {
+    return std::runtime_error(message + ": " + std::strerror(errno));
+}
+
+template <typename T> T *At(void *base, size_t offset) {
+    return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+}
+
+} // namespace
+
+// See Ring.h
+Ring::Ring(unsigned entries) : _queued(0) {
+    // Ring has a single issuer, kernel runs completion work only once it is entered.
+    // Older kernels don't know these flags, then ring is created without them
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+    _fd = io_uring_setup(entries, &params);
+    if (_fd < 0 && errno == EINVAL) {
+        std::memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 4;
+        _fd = io_uring_setup(entries, &params);
+    }
+    if (_fd < 0) {
+        throw Error("Failed to create io_uring");
+    }
+
+    _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+    }
+    _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+    _sq_ring = mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+    if (_sq_ring == MAP_FAILED) {
+        close(_fd);
+        throw Error("Failed to map io_uring submission queue");
+    }
+    _cq_ring = _sq_ring;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        _cq_ring =
+            mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+        if (_cq_ring == MAP_FAILED) {
+            munmap(_sq_ring, _sq_ring_size);
+            close(_fd);
+            throw Error("Failed to map io_uring completion queue");
+        }
+    }
+    void *sqes = mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (_cq_ring != _sq_ring) {
+            munmap(_cq_ring, _cq_ring_size);
+        }
+        munmap(_sq_ring, _sq_ring_size);
+        close(_fd);
+        throw Error("Failed to map io_uring submission entries");
+    }
+    _sqes = static_cast<io_uring_sqe *>(sqes);
+
+    _sq_head = At<unsigned>(_sq_ring, params.sq_off.head);
+    _sq_tail = At<unsigned>(_sq_ring, params.sq_off.tail);
+    _sq_mask = At<unsigned>(_sq_ring, params.sq_off.ring_mask);
+    _sq_array = At<unsigned>(_sq_ring, params.sq_off.array);
+    _sq_entries = params.sq_entries;
+
+    _cq_head = At<unsigned>(_cq_ring, params.cq_off.head);
+    _cq_tail = At<unsigned>(_cq_ring, params.cq_off.tail);
+    _cq_mask = At<unsigned>(_cq_ring, params.cq_off.ring_mask);
+    _cqes = At<io_uring_cqe>(_cq_ring, params.cq_off.cqes);
+}
+
+// See Ring.h
+Ring::~Ring() {
+    munmap(_sqes, _sqes_size);
+    if (_cq_ring != _sq_ring) {
+        munmap(_cq_ring, _cq_ring_size);
+    }
+    munmap(_sq_ring, _sq_ring_size);
+    close(_fd);
+}
+
+// See Ring.h
+io_uring_sqe *Ring::GetSqe() {
+    unsigned tail = *_sq_tail;
+    unsigned head = reinterpret_cast<std::atomic<unsigned> *>(_sq_head)->load(std::memory_order_acquire);
+    if (tail - head == _sq_entries) {
+        // Completions are not waited for, so the entries are just consumed
+        Enter(0);
+        head = reinterpret_cast<std::atomic<unsigned> *>(_sq_head)->load(std::memory_order_acquire);
+        if (tail - head == _sq_entries) {
+            throw std::runtime_error("io_uring submission queue is full");
+        }
+    }
+
+    unsigned index = tail & *_sq_mask;
+    io_uring_sqe *sqe = &_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    _sq_array[index] = index;
+    reinterpret_cast<std::atomic<unsigned> *>(_sq_tail)->store(tail + 1, std::memory_order_release);
+    _queued++;
+    return sqe;
+}
+
+// See Ring.h
+bool Ring::Enter(unsigned wait_nr) {
+    int submitted = io_uring_enter(_fd, _queued, wait_nr, wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0);
+    if (submitted < 0) {
+        if (errno == EINTR) {
+            return false;
+        }
+        // Completion queue is full, entries are submitted once it is drained
+        if (errno == EAGAIN || errno == EBUSY) {
+            return true;
+        }
+        throw Error("Failed to enter io_uring");
+    }
+    _queued -= std::min<unsigned>(_queued, submitted);
+    return true;
+}
+
+// See Ring.h
+BufferGroup::BufferGroup(Ring &ring, uint16_t group, unsigned count, unsigned size)
+    : _ring(ring), _group(group), _count(count), _size(size) {
+    if (count == 0 || count > 65536) {
+        throw std::invalid_argument("Number of provided buffers must be between 1 and 65536");
+    }
+
+    _buffers = new char[size_t(count) * size];
+    _Provide(0, count);
+}
+
+// See Ring.h
+BufferGroup::~BufferGroup() { delete[] _buffers; }
+
+// See Ring.h
+void BufferGroup::Recycle(uint16_t id) { _Provide(id, 1); }
+
+void BufferGroup::_Provide(uint16_t id, unsigned count) {
+    io_uring_sqe *sqe = _ring.GetSqe();
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = count;
+    sqe->addr = reinterpret_cast<uint64_t>(Buffer(id));
+    sqe->len = _size;
+    sqe->off = id;
+    sqe->buf_group = _group;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
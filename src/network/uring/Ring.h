@@ -0,0 +1,122 @@
+#ifndef AFINA_NETWORK_URING_RING_H
+#define AFINA_NETWORK_URING_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+/**
+ * # io_uring instance
+ * Thin wrapper over the io_uring system calls, so there is no dependency on
+ * liburing: maps submission and completion queues of a new ring and hands out
+ * submission entries. Filled entries are only queued, Enter submits all of them
+ * with a single system call and waits for completions at the same time.
+ *
+ * Ring is not thread safe, it is owned by the thread that created it. Throws
+ * std::runtime_error if kernel doesn't support io_uring
+ */
+class Ring {
+public:
+    explicit Ring(unsigned entries);
+    ~Ring();
+
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    /**
+     * Returns zeroed submission entry to fill in. If the queue is full, queued
+     * entries are submitted first
+     */
+    io_uring_sqe *GetSqe();
+
+    /**
+     * Submits all queued entries and waits until at least wait_nr completions are
+     * ready. Returns false if the wait is interrupted by a signal
+     */
+    bool Enter(unsigned wait_nr);
+
+    // Calls handler for each ready completion, then marks them all as seen
+    template <typename F> void ForEachCqe(F handler) {
+        unsigned head = *_cq_head;
+        unsigned tail = reinterpret_cast<std::atomic<unsigned> *>(_cq_tail)->load(std::memory_order_acquire);
+        for (; head != tail; head++) {
+            handler(_cqes[head & *_cq_mask]);
+        }
+        reinterpret_cast<std::atomic<unsigned> *>(_cq_head)->store(head, std::memory_order_release);
+    }
+
+    int GetID() const { return _fd; }
+
+private:
+    int _fd;
+
+    void *_sq_ring;
+    size_t _sq_ring_size;
+    void *_cq_ring;
+    size_t _cq_ring_size;
+    io_uring_sqe *_sqes;
+    size_t _sqes_size;
+
+    unsigned *_sq_head;
+    unsigned *_sq_tail;
+    unsigned *_sq_mask;
+    unsigned *_sq_array;
+    unsigned _sq_entries;
+
+    unsigned *_cq_head;
+    unsigned *_cq_tail;
+    unsigned *_cq_mask;
+    io_uring_cqe *_cqes;
+
+    // Entries filled since the last Enter
+    unsigned _queued;
+};
+
+/**
+ * # Buffers provided to the kernel
+ * Fixed set of equal buffers handed to the ring as a buffer group. Receive with
+ * IOSQE_BUFFER_SELECT takes a free buffer from the group only once data arrives,
+ * so idle connections don't hold any memory, and completion tells which buffer
+ * is used. Buffer must be given back by Recycle once its data is consumed.
+ *
+ * Buffers are given with IORING_OP_PROVIDE_BUFFERS queued to the ring, so they
+ * go to the kernel along with the rest of the batch and produce no completions.
+ * Kernel forgets the group along with the ring, so the group must outlive it
+ */
+class BufferGroup {
+public:
+    BufferGroup(Ring &ring, uint16_t group, unsigned count, unsigned size);
+    ~BufferGroup();
+
+    BufferGroup(const BufferGroup &) = delete;
+    BufferGroup &operator=(const BufferGroup &) = delete;
+
+    uint16_t Group() const { return _group; }
+
+    const char *Buffer(uint16_t id) const { return _buffers + size_t(id) * _size; }
+
+    // Returns buffer to the kernel
+    void Recycle(uint16_t id);
+
+private:
+    // Queues entry that provides count buffers starting with id
+    void _Provide(uint16_t id, unsigned count);
+
+    Ring &_ring;
+    uint16_t _group;
+    unsigned _count;
+    unsigned _size;
+    char *_buffers;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_RING_H
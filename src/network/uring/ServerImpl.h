@@ -0,0 +1,44 @@
+#ifndef AFINA_NETWORK_URING_SERVER_H
+#define AFINA_NETWORK_URING_SERVER_H
+
+#include <deque>
+
+#include <afina/network/Server.h>
+
+#include "./../core/ServerSocket.h"
+#include "Worker.h"
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+/**
+ * # Network resource manager implementation
+ * io_uring based server
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps);
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint16_t workers = 1) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+private:
+    std::shared_ptr<ServerSocket> _server_socket;
+
+    // Threads running rings, each accepts connections on its own
+    std::deque<Worker> _workers;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_SERVER_H
@@ -0,0 +1,290 @@
+#include "Worker.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+// See Worker.h
+Worker::Worker(std::shared_ptr<Afina::Storage> ps)
+    : _storage(ps), _running(false), _wake_fd(-1), _wake_value(0), _last_id(0), _accepting(false) {}
+
+// See Worker.h
+Worker::~Worker() {
+    Stop();
+    Join();
+    if (_wake_fd >= 0) {
+        close(_wake_fd);
+    }
+}
+
+// See Worker.h
+void Worker::Start(std::shared_ptr<ServerSocket> server_socket) {
+    NETWORK_DEBUG(__PRETTY_FUNCTION__);
+    _server_socket = server_socket;
+    if (_wake_fd < 0) {
+        VALIDATE_NETWORK_FUNCTION(_wake_fd = eventfd(0, EFD_CLOEXEC));
+    }
+
+    _running.store(true);
+    _thread = std::thread(&Worker::_ThreadWrapper, this);
+}
+
+// See Worker.h
+void Worker::Stop() {
+    NETWORK_DEBUG(__PRETTY_FUNCTION__);
+    if (!_running.exchange(false)) {
+        return;
+    }
+
+    uint64_t wake = 1;
+    if (write(_wake_fd, &wake, sizeof(wake)) != sizeof(wake)) {
+        NETWORK_DEBUG("Failed to wake worker up: " << std::strerror(errno));
+    }
+}
+
+// See Worker.h
+void Worker::Join() {
+    NETWORK_DEBUG(__PRETTY_FUNCTION__);
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+void Worker::_ThreadWrapper() {
+    try {
+        _ThreadFunction();
+    } catch (std::exception &exc) {
+        NETWORK_CURRENT_PROCESS_DEBUG("EXCEPTION in thread (process will be stopped): " << exc.what());
+    }
+
+    // Closing the ring cancels whatever is still in flight
+    for (auto &connection : _connections) {
+        close(connection.second.fd);
+    }
+    _connections.clear();
+    _ring.reset();
+    _buffers.reset();
+}
+
+// See Worker.h
+void Worker::_ThreadFunction() {
+    NETWORK_CURRENT_PROCESS_DEBUG(__PRETTY_FUNCTION__);
+
+    // Ring is created by the thread that uses it, so it could have a single issuer
+    _ring.reset(new Ring(ring_entries));
+    _buffers.reset(new BufferGroup(*_ring, 0, recv_buffers, recv_buffer_size));
+    _Accept();
+    _WaitWake();
+
+    bool stopping = false;
+    while (!stopping || _accepting || !_connections.empty()) {
+        // Submits everything queued by the previous batch and waits for the next one
+        if (!_ring->Enter(1)) {
+            continue;
+        }
+
+        _ring->ForEachCqe([this](const io_uring_cqe &cqe) {
+            uint64_t id = cqe.user_data >> 8;
+            switch (static_cast<Op>(cqe.user_data & 0xff)) {
+            case Op::Accept:
+                _OnAccept(cqe);
+                break;
+            case Op::Recv:
+                _OnRecv(id, cqe);
+                break;
+            case Op::Send:
+                _OnSend(id, cqe);
+                break;
+            case Op::Wake:
+            case Op::Cancel:
+                break;
+            }
+        });
+
+        if (!stopping && !_running.load()) {
+            // Stop to accept and shut connections down, loop is over once their
+            // operations are complete
+            stopping = true;
+            if (_accepting) {
+                io_uring_sqe *sqe = _ring->GetSqe();
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->addr = _UserData(0, Op::Accept);
+                sqe->user_data = _UserData(0, Op::Cancel);
+            }
+            for (auto it = _connections.begin(); it != _connections.end();) {
+                auto next = std::next(it);
+                _Close(it);
+                it = next;
+            }
+        }
+    }
+}
+
+// See Worker.h
+void Worker::_Accept() {
+    io_uring_sqe *sqe = _ring->GetSqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = _server_socket->GetID();
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = _UserData(0, Op::Accept);
+    _accepting = true;
+}
+
+// See Worker.h
+void Worker::_Recv(uint64_t id, Connection &connection) {
+    io_uring_sqe *sqe = _ring->GetSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = connection.fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = _buffers->Group();
+    sqe->user_data = _UserData(id, Op::Recv);
+    connection.receiving = true;
+}
+
+// See Worker.h
+void Worker::_Send(uint64_t id, Connection &connection) {
+    // Executor could add more output while the send is in flight, so the kernel
+    // gets a copy of the iovecs. Chunks stay in place until they are sent
+    const iovec *iov = connection.executor.GetOutputAsIovec();
+    connection.iov.assign(iov, iov + connection.executor.GetQueueSize());
+    std::memset(&connection.msg, 0, sizeof(connection.msg));
+    connection.msg.msg_iov = connection.iov.data();
+    connection.msg.msg_iovlen = connection.iov.size();
+
+    io_uring_sqe *sqe = _ring->GetSqe();
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = connection.fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&connection.msg);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = _UserData(id, Op::Send);
+    connection.sending = true;
+}
+
+// See Worker.h
+void Worker::_WaitWake() {
+    io_uring_sqe *sqe = _ring->GetSqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = _wake_fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&_wake_value);
+    sqe->len = sizeof(_wake_value);
+    sqe->user_data = _UserData(0, Op::Wake);
+}
+
+// See Worker.h
+void Worker::_OnAccept(const io_uring_cqe &cqe) {
+    if (cqe.res >= 0) {
+        if (_running.load()) {
+            uint64_t id = ++_last_id;
+            auto it = _connections
+                          .emplace(std::piecewise_construct, std::forward_as_tuple(id),
+                                   std::forward_as_tuple(cqe.res, _storage))
+                          .first;
+            NETWORK_DEBUG("Client socket " << cqe.res << " was created");
+            _Recv(id, it->second);
+        } else {
+            close(cqe.res);
+        }
+    } else if (cqe.res == -EINVAL) {
+        throw std::runtime_error("Multishot accept is not supported, kernel 5.19 or newer is required");
+    } else if (cqe.res != -ECANCELED) {
+        NETWORK_DEBUG("Accept failed: " << std::strerror(-cqe.res));
+    }
+
+    // Kernel stops multishot accept on errors, then it is armed again
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        _accepting = false;
+        if (_running.load()) {
+            _Accept();
+        }
+    }
+}
+
+// See Worker.h
+void Worker::_OnRecv(uint64_t id, const io_uring_cqe &cqe) {
+    auto it = _connections.find(id);
+    if (cqe.flags & IORING_CQE_F_BUFFER) {
+        uint16_t buffer = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+        if (it != _connections.end() && !it->second.closing && cqe.res > 0) {
+            it->second.executor.AppendAndTryExecute(_buffers->Buffer(buffer), cqe.res);
+        }
+        _buffers->Recycle(buffer);
+    }
+    if (it == _connections.end()) {
+        return;
+    }
+
+    Connection &connection = it->second;
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        connection.receiving = false;
+    }
+    if (cqe.res == -EINVAL) {
+        throw std::runtime_error("Multishot receive is not supported, kernel 6.0 or newer is required");
+    }
+    if (connection.closing || cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS)) {
+        _Close(it);
+        return;
+    }
+
+    // Multishot receive stops once provided buffers run out, they are back already
+    if (!connection.receiving) {
+        _Recv(id, connection);
+    }
+    if (!connection.sending && connection.executor.HasOutputData()) {
+        _Send(id, connection);
+    }
+}
+
+// See Worker.h
+void Worker::_OnSend(uint64_t id, const io_uring_cqe &cqe) {
+    auto it = _connections.find(id);
+    if (it == _connections.end()) {
+        return;
+    }
+
+    Connection &connection = it->second;
+    connection.sending = false;
+    if (connection.closing || cqe.res < 0) {
+        _Close(it);
+        return;
+    }
+
+    connection.executor.RemoveFromOutput(cqe.res);
+    if (connection.executor.HasOutputData()) {
+        _Send(id, connection);
+    }
+}
+
+// See Worker.h
+void Worker::_Close(std::unordered_map<uint64_t, Connection>::iterator it) {
+    Connection &connection = it->second;
+    if (!connection.closing) {
+        // Operations in flight complete right away once socket is shut down
+        connection.closing = true;
+        shutdown(connection.fd, SHUT_RDWR);
+    }
+    if (!connection.receiving && !connection.sending) {
+        NETWORK_DEBUG("Client socket " << connection.fd << " was closed");
+        close(connection.fd);
+        _connections.erase(it);
+    }
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
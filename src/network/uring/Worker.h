@@ -0,0 +1,131 @@
+#ifndef AFINA_NETWORK_URING_WORKER_H
+#define AFINA_NETWORK_URING_WORKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "./../../protocol/Executor.h"
+#include "./../core/ServerSocket.h"
+#include "Ring.h"
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+
+namespace Network {
+namespace Uring {
+
+/**
+ * # Thread running io_uring
+ * Each worker owns a ring and does all socket IO through it: multishot accept
+ * on the shared server socket, multishot receive on each connection into the
+ * buffers provided to the kernel and sendmsg of the responses right from the
+ * executor chunks. Operations queued while completions are handled go to the
+ * kernel with the single system call that waits for the next completions, so
+ * under load there is about one system call per batch instead of several per
+ * request.
+ */
+class Worker {
+public:
+    Worker(std::shared_ptr<Afina::Storage> ps);
+    ~Worker();
+
+    /**
+     * Spaws new background thread that accepts connections on the given server
+     * socket and serves them
+     */
+    void Start(std::shared_ptr<ServerSocket> server_socket);
+
+    /**
+     * Signal background thread to stop. Thread stops to accept new connections,
+     * closes existing ones and exits
+     */
+    void Stop();
+
+    /**
+     * Blocks calling thread until background one for this worker is actually
+     * been destoryed
+     */
+    void Join();
+
+    // Number of submission queue entries of the ring
+    static const unsigned ring_entries = 1024;
+
+    // Number and size of the receive buffers provided to the kernel
+    static const unsigned recv_buffers = 512;
+    static const unsigned recv_buffer_size = 4096;
+
+private:
+    // Operation of the completion, kept in the low bits of user data
+    enum class Op : uint8_t { Accept, Recv, Send, Wake, Cancel };
+
+    struct Connection {
+        int fd;
+        Protocol::Executor executor;
+
+        // Multishot receive is armed
+        bool receiving;
+
+        // Send is in flight, msg and iov are owned by the kernel till its completion
+        bool sending;
+
+        // Connection is shut down and is removed once operations are over
+        bool closing;
+
+        msghdr msg;
+        std::vector<iovec> iov;
+
+        Connection(int fd, std::shared_ptr<Afina::Storage> storage)
+            : fd(fd), executor(storage), receiving(false), sending(false), closing(false) {}
+    };
+
+    static uint64_t _UserData(uint64_t id, Op op) { return (id << 8) | static_cast<uint8_t>(op); }
+
+    void _ThreadWrapper();
+    void _ThreadFunction();
+
+    void _Accept();
+    void _Recv(uint64_t id, Connection &connection);
+    void _Send(uint64_t id, Connection &connection);
+    void _WaitWake();
+
+    void _OnAccept(const io_uring_cqe &cqe);
+    void _OnRecv(uint64_t id, const io_uring_cqe &cqe);
+    void _OnSend(uint64_t id, const io_uring_cqe &cqe);
+
+    // Shuts connection down, it is removed once it has no operations in flight
+    void _Close(std::unordered_map<uint64_t, Connection>::iterator it);
+
+    std::shared_ptr<Afina::Storage> _storage;
+    std::shared_ptr<ServerSocket> _server_socket;
+
+    std::thread _thread;
+    std::atomic<bool> _running;
+
+    // Stop wakes the thread up through it
+    int _wake_fd;
+    uint64_t _wake_value;
+
+    // Ring, provided buffers and connections are used by the worker thread only
+    std::unique_ptr<Ring> _ring;
+    std::unique_ptr<BufferGroup> _buffers;
+    std::unordered_map<uint64_t, Connection> _connections;
+    uint64_t _last_id;
+
+    // Multishot accept is armed
+    bool _accepting;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_WORKER_H
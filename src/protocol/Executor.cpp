@@ -1,5 +1,7 @@
 #include "Executor.h"
 
+#include <cstring>
+
 //===============================================================================================
 
 namespace Afina {
@@ -23,15 +25,54 @@ void Executor::Command::SetNewCommand(command_ptr&& command_object, size_t arg_s
 
 //===============================================================================================
 
-Executor::Executor(std::shared_ptr<Afina::Storage> storage) : _storage(storage)
+const size_t Executor::max_copied_chunk;
+const size_t Executor::output_block_size;
+
+Executor::Executor(std::shared_ptr<Afina::Storage> storage) : _storage(storage), _block(nullptr), _block_size(0),
+																 _block_capacity(0)
 {}
 
 void Executor::_AddLineToQueue(const std::string& msg)
 {
-	_output_queue.push_back(msg+"\r\n");
+	_AddToBlock(msg.data(), msg.size());
+	_AddToBlock("\r\n", 2);
+}
+
+void Executor::_AddChunkToQueue(ValueRef&& chunk)
+{
+	if (chunk.size() == 0) { return; }
+	if (chunk.size() <= max_copied_chunk)
+	{
+		_AddToBlock(chunk.data(), chunk.size());
+		return;
+	}
+
+	_CloseBlock();
+	iovec new_iov = {(void*) chunk.data(), chunk.size()};
+	_output_queue.push_back(std::move(chunk));
+	_iovec_output.push_back(new_iov);
+}
+
+void Executor::_AddToBlock(const char* data, size_t size)
+{
+	if (_block == nullptr || _block_capacity - _block_size < size)
+	{
+		_block_capacity = std::max(output_block_size, size);
+		_block_size = 0;
+		_output_queue.push_back(ValueRef::Allocate(_block_capacity, _block));
+		_iovec_output.push_back({_block, 0});
+	}
+
+	// Block is the last one in the queue, its iovec ends where the data is added
+	std::memcpy(_block + _block_size, data, size);
+	_block_size += size;
+	_iovec_output.back().iov_len += size;
+}
 
-	iovec new_iov = {(void*) _output_queue.back().c_str(), _output_queue.back().size()};
-	_iovec_output.push_back(std::move(new_iov));
+void Executor::_CloseBlock()
+{
+	_block = nullptr;
+	_block_size = _block_capacity = 0;
 }
 
 void Executor::_Reset(bool clear_data)
@@ -39,36 +80,40 @@ void Executor::_Reset(bool clear_data)
 	_parser.Reset();
 	_current_command.Reset();
 
-	if (clear_data) { _current_string = ""; }
+	if (clear_data) { _input.Clear(); }
 }
 
 void Executor::_Execute()
 {
 	std::string argument;
-	std::string out;
+	std::vector<ValueRef> out;
 	if (_current_command.ArgumentSize() != 0) //Command need argument
 	{
-		argument = _current_string.substr(0, _current_command.ArgumentSize());
-		_current_string = _current_string.substr(_current_command.ArgumentSize()); //remove argument from received data
+		size_t size = _current_command.ArgumentSize();
+		bool terminated = std::memcmp(_input.Data() + size - 2, "\r\n", 2) == 0;
+		if (terminated) { argument.assign(_input.Data(), size - 2); } // \r\n not needed
+		_input.Consume(size); //remove argument from received data
 
-		if (argument.substr(argument.size() - 2) != "\r\n")
+		if (!terminated)
 		{
 			//_AddLineToQueue(std::string("Parsing error: ") + "command argument should finish by \\r\\n");
 			_AddLineToQueue("ERROR");
 			_Reset(false);
 			return;
 		}
-		argument = argument.substr(0, argument.size() - 2);  // \r\n not needed
 	}
 
 	try { _current_command.CommandObject()->Execute(*_storage, argument, out); }
 	catch (std::exception& e) {
-		out = "ERROR";
+		out.clear();
+		out.push_back(ValueRef::Copy("ERROR"));
 		//out = "SERVER ERROR ";
 		//out += e.what();
 	}
 
-	_AddLineToQueue(out);
+	static const char crlf[] = "\r\n";
+	for (auto& chunk : out) { _AddChunkToQueue(std::move(chunk)); }
+	_AddChunkToQueue(ValueRef::Static(crlf, sizeof(crlf) - 1));
 	_Reset(false);
 }
 
@@ -76,7 +121,7 @@ bool Executor::_ReadOneCommand()
 {
 	bool was_command = false;
 	size_t parsed = 0;
-	try { was_command = _parser.Parse(_current_string, parsed); }
+	try { was_command = _parser.Parse(_input.Data(), _input.Size(), parsed); }
 	catch (std::exception& e)
 	{
 		//_AddLineToQueue(std::string("Parsing error: ") + e.what());
@@ -85,14 +130,14 @@ bool Executor::_ReadOneCommand()
 		return true;
 	}
 
-	_current_string = _current_string.substr(parsed); //remove parsed part of string (was saved in parser) <or> remove command
+	_input.Consume(parsed); //remove parsed part of string (was saved in parser) <or> remove command
 	if (!was_command) { return false; } //need more data
 
 	uint32_t arg_size = 0;
 	auto command_object = _parser.Build(arg_size);
 	_current_command.SetNewCommand(std::move(command_object), arg_size);
 
-	if (_current_command.ArgumentSize() > _current_string.size()) { return false; } //need more data
+	if (_current_command.ArgumentSize() > _input.Size()) { return false; } //need more data
 	else
 	{
 		_Execute(); //Calls _Reset
@@ -100,10 +145,14 @@ bool Executor::_ReadOneCommand()
 	}
 }
 
-bool Executor::AppendAndTryExecute(const std::string& str)
+bool Executor::AppendAndTryExecute(const char* data, size_t size)
 {
-	_current_string.append(str);
+	_input.Append(data, size);
+	return TryExecute();
+}
 
+bool Executor::TryExecute()
+{
 	bool was_output = false;
 	while (_ReadOneCommand()) {
 	    was_output = true;
@@ -114,16 +163,12 @@ bool Executor::AppendAndTryExecute(const std::string& str)
 std::string Executor::GetWholeOutputAsString(bool remove)
 {
 	std::string result;
-	for (auto it = _output_queue.cbegin(); it != _output_queue.cend(); it++)
+	for (auto it = _iovec_output.cbegin(); it != _iovec_output.cend(); it++)
 	{
-		result += (*it);
+		result.append(static_cast<const char*>(it->iov_base), it->iov_len);
 	}
 
-	if (remove)
-	{
-		_output_queue.clear();
-		_iovec_output.clear();
-	}
+	if (remove) { ClearOutput(); }
 
 	return result;
 }
@@ -136,26 +181,26 @@ const iovec* Executor::GetOutputAsIovec() const
 void Executor::RemoveFromOutput(unsigned int bytes)
 {
 	size_t count_full_buffers = 0;
-	for (auto it = _output_queue.cbegin(); it != _output_queue.cend(); it++)
+	for (auto it = _iovec_output.cbegin(); it != _iovec_output.cend(); it++)
 	{
-		if (it->size() <= bytes)
+		if (it->iov_len <= bytes)
 		{ 
 			++count_full_buffers;
-			bytes -= it->size();
+			bytes -= it->iov_len;
 		}
 		else { break; }
 	}
 
-	//Erase full buffers
+	//Erase full buffers, open block is the last one
 	_output_queue.erase(_output_queue.begin(), _output_queue.begin() + count_full_buffers);
 	_iovec_output.erase(_iovec_output.begin(), _iovec_output.begin() + count_full_buffers);
+	if (_output_queue.empty()) { _CloseBlock(); }
 
 	//Need shrink the last buffer
 	if (!_output_queue.empty() && bytes != 0)
 	{
-		_output_queue[0] = _output_queue[0].substr(bytes);
-		_iovec_output[0].iov_base = (void*) _output_queue[0].c_str();
-		_iovec_output[0].iov_len  =  _output_queue[0].size();
+		_iovec_output[0].iov_base = static_cast<char*>(_iovec_output[0].iov_base) + bytes;
+		_iovec_output[0].iov_len -= bytes;
 	}
 }
 
@@ -163,6 +208,7 @@ void Executor::ClearOutput()
 {
 	_output_queue.clear();
 	_iovec_output.clear();
+	_CloseBlock();
 }
 
 } // namespace Protocol
@@ -1,19 +1,23 @@
 #ifndef AFINA_EXECUTOR_H
 #define AFINA_EXECUTOR_H
 
+#include <algorithm>
 #include <string>
 #include <deque>
 #include <vector>
 #include <utility>
 #include <memory>
 
+#include <climits>
 #include <sys/uio.h>
 
 #include <afina/Storage.h>
+#include <afina/ValueRef.h>
 #include <afina/execute/Command.h>
 
 #include "Parser.h"
 #include "./../core/Debug.h"
+#include "./../core/ReadBuffer.h"
 
 namespace Afina {
 class Storage;
@@ -47,31 +51,57 @@ class Executor
 	private:
 		std::shared_ptr<Afina::Storage> _storage;
 
-		std::string _current_string;
+		// Received data that isn't parsed yet, parser consumes it from the front
+		Core::ReadBuffer _input;
 		Parser _parser;
 		Command _current_command;
 
-		std::deque<std::string> _output_queue;
+		// Chunks of responses, values are referenced right in the storage memory.
+		// Each chunk has iovec pointing to its part that isn't sent yet
+		std::deque<ValueRef> _output_queue;
 		std::vector<iovec> _iovec_output;
 
+		// Small chunks are copied one after another into the last block of the queue,
+		// so responses to pipelined commands go out with a few iovecs. Block is open
+		// while it is the last one in the queue and has room
+		char* _block;
+		size_t _block_size;
+		size_t _block_capacity;
+
 	private:
 		void _AddLineToQueue(const std::string& msg);
+		void _AddChunkToQueue(ValueRef&& chunk);
+		void _AddToBlock(const char* data, size_t size);
+		void _CloseBlock();
 		void _Reset(bool clear_data);
 		
 		bool _ReadOneCommand();
 
-		// Executes _current_command. Assumes that _current_string is enough for command argument
+		// Executes _current_command. Assumes that _input is enough for command argument
 		void _Execute();
 
 	public:
+		// Chunks up to this size are copied into output blocks, bigger ones are referenced
+		static const size_t max_copied_chunk = 1024;
+		static const size_t output_block_size = 16 * 1024;
+
 		Executor(std::shared_ptr<Afina::Storage> storage);
 
 		//Returns true if new data is avaliable
-		bool AppendAndTryExecute(const std::string& str);
+		bool AppendAndTryExecute(const std::string& str) { return AppendAndTryExecute(str.data(), str.size()); }
+		bool AppendAndTryExecute(const char* data, size_t size);
+
+		// Buffer to receive data into directly, TryExecute must be called after that
+		Core::ReadBuffer& GetInput() { return _input; }
+
+		// Executes commands that are received completely. Returns true if new data is avaliable
+		bool TryExecute();
 		
 		std::string GetWholeOutputAsString(bool remove = false);
 		const iovec* GetOutputAsIovec() const;
-		size_t GetQueueSize() const { return _iovec_output.size(); }
+
+		// Number of iovecs to pass to a single writev
+		size_t GetQueueSize() const { return std::min<size_t>(_iovec_output.size(), IOV_MAX); }
 
 		bool HasOutputData() const { return !_output_queue.empty(); }
 		void RemoveFromOutput(unsigned int bytes);
@@ -59,10 +59,23 @@ private:
     /**
      * State of the command parser. Prefixes are:
      * - s: state for PUT and GET commands
-     * - sp: for PUT commands only
+     * - sp: for PUT commands only, spCas is for cas command only
      * - sg: for GET commands only
+     * - si: for incr and decr commands only, their key is parsed by spKey
      */
-    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+    enum State : uint16_t {
+        sCR,
+        sLF,
+        sName,
+        spKey,
+        spFlags,
+        spExprTimeStart,
+        spExprTime,
+        spBytes,
+        spCas,
+        siDelta,
+        sgKey
+    };
 
     // Current parser state
     State state;
@@ -88,6 +101,13 @@ private:
     // it's followed by an empty data block).
     uint32_t bytes;
 
+    // <cas unique> is a unique 64-bit value of an existing entry. Clients should use the value returned from the
+    // "gets" command when issuing "cas" updates.
+    uint64_t cas;
+
+    // <value> of incr and decr is the decimal representation of a 64-bit unsigned integer to change the counter by
+    uint64_t delta;
+
     bool negative;
     std::string curKey;
     bool parse_complete;
@@ -0,0 +1,28 @@
+#ifndef AFINA_STORAGE_CHECKSUM_H
+#define AFINA_STORAGE_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Backend {
+
+// Initial value of the FNV-1a checksum
+const uint64_t fnv_offset = 14695981039346656037ULL;
+
+/**
+ * Continues FNV-1a checksum of the data, start with fnv_offset. It is cheap and
+ * catches torn and corrupted writes of the files storage keeps on disk
+ */
+inline uint64_t Fnv(uint64_t hash, const char *data, size_t size) {
+    const uint64_t prime = 1099511628211ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+    }
+    return hash;
+}
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CHECKSUM_H
@@ -0,0 +1,55 @@
+#include "ClockPolicy.h"
+
+namespace Afina {
+namespace Backend {
+
+// See ClockPolicy.h
+void ClockPolicy::Insert(Entry *entry) {
+    entry->_referenced.store(0, std::memory_order_relaxed);
+    _list.PushFront(entry);
+}
+
+// See ClockPolicy.h
+void ClockPolicy::Touch(Entry *entry) {
+    // Check first, so hot entries don't dirty their header on every access
+    if (entry->_referenced.load(std::memory_order_relaxed) == 0) {
+        entry->_referenced.store(1, std::memory_order_relaxed);
+    }
+}
+
+// See ClockPolicy.h
+void ClockPolicy::Replace(Entry *old_entry, Entry *new_entry) {
+    new_entry->_referenced.store(old_entry->_referenced.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    _list.Replace(old_entry, new_entry);
+}
+
+// See ClockPolicy.h
+Entry *ClockPolicy::Victim(const Entry *keep, const Preference &prefer) {
+    // Each step clears one bit, so after a full round some entry has no bit left
+    // unless keep is the only one
+    for (size_t step = 0; step <= _list.Count(); step++) {
+        Entry *entry = _list.Tail();
+        if (entry == nullptr) {
+            return nullptr;
+        }
+        if (entry != keep && entry->_referenced.load(std::memory_order_relaxed) == 0) {
+            break;
+        }
+        entry->_referenced.store(0, std::memory_order_relaxed);
+        _list.MoveToFront(entry);
+    }
+
+    if (prefer) {
+        // Preferred entry is taken only if it has no second chance left either
+        size_t looked = 0;
+        for (Entry *entry = _list.Tail(); entry != nullptr && looked < max_lookup; entry = entry->_prev, looked++) {
+            if (entry != keep && entry->_referenced.load(std::memory_order_relaxed) == 0 && prefer(entry)) {
+                return entry;
+            }
+        }
+    }
+    return _Pick({&_list}, keep, nullptr);
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,43 @@
+#ifndef AFINA_STORAGE_CLOCK_POLICY_H
+#define AFINA_STORAGE_CLOCK_POLICY_H
+
+#include "EvictionPolicy.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # CLOCK
+ * Entries are kept in insertion order. Access only sets reference bit of the
+ * entry, list pointers are not written. Eviction sweeps from the tail: entry with
+ * the bit set is moved to the head with the bit cleared (second chance), the
+ * first one without the bit is the victim.
+ */
+class ClockPolicy : public EvictionPolicy {
+public:
+    // Implements EvictionPolicy interface
+    void Insert(Entry *entry) override;
+
+    // Implements EvictionPolicy interface
+    void Touch(Entry *entry) override;
+
+    // Implements EvictionPolicy interface
+    void Remove(Entry *entry) override { _list.Unlink(entry); }
+
+    // Implements EvictionPolicy interface
+    void Replace(Entry *old_entry, Entry *new_entry) override;
+
+    // Implements EvictionPolicy interface
+    void Resize(Entry *entry, size_t old_charge) override { _list.Resize(entry, old_charge); }
+
+    // Implements EvictionPolicy interface
+    Entry *Victim(const Entry *keep, const Preference &prefer = nullptr) override;
+
+private:
+    EntryList _list;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CLOCK_POLICY_H
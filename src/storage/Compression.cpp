@@ -0,0 +1,77 @@
+#include "Compression.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "Lzf.h"
+
+namespace Afina {
+namespace Backend {
+
+// Bytes of the original size in front of the stream
+static const size_t header_size = sizeof(uint32_t);
+
+// Returns original size of the packed value
+static size_t OriginalSize(const char *packed, size_t size) {
+    if (size < header_size) {
+        throw std::runtime_error("Compressed value is truncated");
+    }
+    uint32_t original;
+    std::memcpy(&original, packed, header_size);
+    return original;
+}
+
+// Unpacks the stream into exactly original size bytes at value
+static void Unpack(const char *packed, size_t size, char *value, size_t original) {
+    if (LzfDecompress(packed + header_size, size - header_size, value, original) != original) {
+        throw std::runtime_error("Compressed value is corrupted");
+    }
+}
+
+// See Compression.h
+bool Compress(const char *value, size_t size, std::string &packed) {
+    if (size > UINT32_MAX) {
+        return false;
+    }
+
+    // Output buffer is as large as packed value is allowed to be, so stream that
+    // doesn't save enough simply doesn't fit
+    size_t limit = size - size / min_saving;
+    if (limit <= header_size) {
+        return false;
+    }
+    packed.resize(limit);
+
+    uint32_t original = size;
+    std::memcpy(&packed[0], &original, header_size);
+    size_t written = LzfCompress(value, size, &packed[header_size], limit - header_size);
+    if (written == 0) {
+        return false;
+    }
+    packed.resize(header_size + written);
+    return true;
+}
+
+// See Compression.h
+void Decompress(const char *packed, size_t size, std::string &value) {
+    size_t original = OriginalSize(packed, size);
+    value.resize(original);
+    if (original != 0) {
+        Unpack(packed, size, &value[0], original);
+    }
+}
+
+// See Compression.h
+ValueRef Decompress(const char *packed, size_t size) {
+    size_t original = OriginalSize(packed, size);
+    char *data;
+    ValueRef ref = ValueRef::Allocate(original, data);
+    if (original != 0) {
+        Unpack(packed, size, data, original);
+    }
+    return ref;
+}
+
+} // namespace Backend
+} // namespace Afina
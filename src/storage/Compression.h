@@ -0,0 +1,45 @@
+#ifndef AFINA_STORAGE_COMPRESSION_H
+#define AFINA_STORAGE_COMPRESSION_H
+
+#include <cstddef>
+#include <string>
+
+#include <afina/ValueRef.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Compressed values
+ * Large values are kept in memory compressed by LZF, see Lzf.h. Packed value
+ * is
+ *
+ *     <original size:u32> <lzf stream>
+ *
+ * Value is packed only if that saves at least 1/min_saving of its size, so the
+ * storage never pays for decompression of the data that barely compresses, like
+ * images or values compressed by clients already.
+ */
+
+// Packing must save at least size / min_saving bytes
+const size_t min_saving = 8;
+
+/**
+ * Packs value into packed, returns false if value doesn't compress well enough,
+ * packed is garbage then
+ */
+bool Compress(const char *value, size_t size, std::string &packed);
+
+/**
+ * Unpacks value packed by Compress. Throws std::runtime_error if data is
+ * corrupted
+ */
+void Decompress(const char *packed, size_t size, std::string &value);
+
+// Unpacks value into the new block owned by the returned reference
+ValueRef Decompress(const char *packed, size_t size);
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_COMPRESSION_H
@@ -0,0 +1,211 @@
+#ifndef AFINA_STORAGE_CONCURRENT_INDEX_H
+#define AFINA_STORAGE_CONCURRENT_INDEX_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "EpochManager.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hash index with lock-free lookups
+ * Open addressing table of entry pointers with linear probing. Lookups take no
+ * locks and could run concurrently with a single writer, writers must be
+ * serialized by the caller.
+ *
+ * Slots only change by a single atomic store: empty -> entry, entry -> entry
+ * (replace) and entry -> tombstone (erase), so reader always observes either old
+ * or new state of a slot and probe sequences are never broken. Tombstones are
+ * dropped when table is rebuilt. Rebuild creates new table aside and publishes
+ * it at once, old table is retired via epoch manager, so lookups must be done
+ * inside EpochManager::Guard. The same holds for returned entries.
+ *
+ * Entry type must have `size_t _hash` member and provide method
+ * `bool Matches(const std::string &key) const`
+ */
+template <typename Entry> class ConcurrentIndex {
+public:
+    explicit ConcurrentIndex(EpochManager &epoch) : _epoch(epoch), _size(0) {
+        _table.store(_Allocate(min_capacity), std::memory_order_relaxed);
+    }
+    ~ConcurrentIndex() { std::free(_table.load(std::memory_order_relaxed)); }
+
+    ConcurrentIndex(const ConcurrentIndex &) = delete;
+    ConcurrentIndex &operator=(const ConcurrentIndex &) = delete;
+
+    static size_t Hash(const std::string &key) { return std::hash<std::string>()(key); }
+
+    /**
+     * Returns entry associated with the given key or nullptr. Safe to call
+     * concurrently with writers
+     */
+    Entry *Find(const std::string &key, size_t hash) const {
+        const Table *table = _table.load(std::memory_order_acquire);
+        for (size_t pos = hash & table->mask;; pos = (pos + 1) & table->mask) {
+            Entry *entry = table->slots[pos].load(std::memory_order_acquire);
+            if (entry == nullptr) {
+                return nullptr;
+            }
+            if (entry != _Tombstone() && entry->_hash == hash && entry->Matches(key)) {
+                return entry;
+            }
+        }
+    }
+
+    /**
+     * Hints CPU that slots for the given hash are going to be read soon
+     */
+    void Prefetch(size_t hash) const {
+        const Table *table = _table.load(std::memory_order_acquire);
+        __builtin_prefetch(&table->slots[hash & table->mask]);
+    }
+
+    /**
+     * Adds entry with the key that is not in the index yet
+     */
+    void Insert(Entry *entry) {
+        Table *table = _table.load(std::memory_order_relaxed);
+        if ((table->used + 1) * max_load_den > (table->mask + 1) * max_load_num) {
+            table = _Rebuild();
+        }
+
+        for (size_t pos = entry->_hash & table->mask;; pos = (pos + 1) & table->mask) {
+            Entry *current = table->slots[pos].load(std::memory_order_relaxed);
+            if (current == nullptr || current == _Tombstone()) {
+                table->used += (current == nullptr);
+                table->slots[pos].store(entry, std::memory_order_release);
+                break;
+            }
+        }
+        _size++;
+    }
+
+    /**
+     * Puts replacement in place of the old entry of the same key
+     */
+    void Replace(Entry *old_entry, Entry *new_entry) {
+        _Slot(old_entry).store(new_entry, std::memory_order_release);
+    }
+
+    /**
+     * Removes entry from the index
+     */
+    void Erase(Entry *entry) {
+        _Slot(entry).store(_Tombstone(), std::memory_order_release);
+        _size--;
+    }
+
+    /**
+     * Calls fn for entries in at most count slots starting from the cursor.
+     * Returns position to continue from, or 0 once the end of the table is
+     * reached. Must be called inside EpochManager::Guard, entries are moved if
+     * table is rebuilt between calls, so they could be missed or visited twice
+     */
+    template <typename F> size_t Scan(size_t cursor, size_t count, F fn) const {
+        const Table *table = _table.load(std::memory_order_acquire);
+        size_t end = cursor + count;
+        if (end > table->mask + 1 || end < cursor) {
+            end = table->mask + 1;
+        }
+        for (size_t i = cursor; i < end; i++) {
+            Entry *entry = table->slots[i].load(std::memory_order_acquire);
+            if (entry != nullptr && entry != _Tombstone()) {
+                fn(entry);
+            }
+        }
+        return end > table->mask ? 0 : end;
+    }
+
+    // Number of entries in the index
+    size_t Size() const { return _size; }
+
+    // Number of bytes used by the table
+    size_t MemoryUsage() const { return _Footprint(_table.load(std::memory_order_relaxed)->mask + 1); }
+
+private:
+    static const size_t min_capacity = 16;
+
+    // Table is rebuilt once live and dead slots take more than 3/4 of it
+    static const size_t max_load_num = 3;
+    static const size_t max_load_den = 4;
+
+    struct Table {
+        size_t mask;
+
+        // Number of not empty slots, including tombstones
+        size_t used;
+
+        std::atomic<Entry *> slots[1];
+    };
+
+    static Entry *_Tombstone() { return reinterpret_cast<Entry *>(uintptr_t(1)); }
+
+    static size_t _Footprint(size_t capacity) {
+        return sizeof(Table) + (capacity - 1) * sizeof(std::atomic<Entry *>);
+    }
+
+    static Table *_Allocate(size_t capacity) {
+        // Zeroed memory is a table of empty slots
+        Table *table = static_cast<Table *>(std::calloc(1, _Footprint(capacity)));
+        if (table == nullptr) {
+            throw std::bad_alloc();
+        }
+        table->mask = capacity - 1;
+        table->used = 0;
+        return table;
+    }
+
+    static void _Delete(void *table) { std::free(table); }
+
+    std::atomic<Entry *> &_Slot(Entry *entry) {
+        Table *table = _table.load(std::memory_order_relaxed);
+        for (size_t pos = entry->_hash & table->mask;; pos = (pos + 1) & table->mask) {
+            if (table->slots[pos].load(std::memory_order_relaxed) == entry) {
+                return table->slots[pos];
+            }
+        }
+    }
+
+    // Moves live entries into the new table, that keeps it at most half full
+    Table *_Rebuild() {
+        Table *old_table = _table.load(std::memory_order_relaxed);
+        size_t capacity = min_capacity;
+        while (capacity < (_size + 1) * 2) {
+            capacity *= 2;
+        }
+
+        Table *table = _Allocate(capacity);
+        for (size_t i = 0; i <= old_table->mask; i++) {
+            Entry *entry = old_table->slots[i].load(std::memory_order_relaxed);
+            if (entry == nullptr || entry == _Tombstone()) {
+                continue;
+            }
+
+            size_t pos = entry->_hash & table->mask;
+            while (table->slots[pos].load(std::memory_order_relaxed) != nullptr) {
+                pos = (pos + 1) & table->mask;
+            }
+            table->slots[pos].store(entry, std::memory_order_relaxed);
+            table->used++;
+        }
+
+        _table.store(table, std::memory_order_release);
+        _epoch.Retire(old_table, _Delete);
+        return table;
+    }
+
+    EpochManager &_epoch;
+    std::atomic<Table *> _table;
+    size_t _size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CONCURRENT_INDEX_H
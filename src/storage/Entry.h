@@ -0,0 +1,158 @@
+#ifndef AFINA_STORAGE_ENTRY_H
+#define AFINA_STORAGE_ENTRY_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <new>
+#include <string>
+
+#include <afina/ValueRef.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage entry
+ * Single contiguous memory block: header with intrusive LRU links followed by the
+ * key bytes and then value bytes. So each item costs exactly one allocation.
+ *
+ * Block could have more space than key + value needs (capacity), that allows to
+ * update value in place while it fits.
+ */
+struct Entry {
+    struct Entry *_next;
+    struct Entry *_prev;
+
+    // Hash of the key, cached to not rehash key on eviction
+    size_t _hash;
+
+    uint32_t _key_size;
+    uint32_t _value_size;
+
+    // Number of bytes available for key and value
+    uint32_t _capacity;
+
+    // Expiration unix time, 0 if entry never expires
+    uint32_t _expire;
+
+    // Handle of the entry timer, 0 if it isn't scheduled, see TimerWheel.h
+    uint32_t _timer;
+
+    // Version of the item, storage gives the new one on every change
+    uint64_t _version;
+
+    // Set by readers that don't move entry in the list themselves, entry with the
+    // flag set gets second chance on eviction. Fits into the header padding
+    std::atomic<uint8_t> _referenced;
+
+    // List of the eviction policy entry belongs to, see EvictionPolicy.h
+    uint8_t _segment;
+
+    // Set if value bytes are compressed, see Compression.h. Fits into the header
+    // padding too
+    uint8_t _compressed;
+
+    // Number of references to the entry: one of the storage while entry is stored
+    // plus one of each ValueRef to its value. Entry is immutable while there are
+    // references besides the storage one
+    std::atomic<uint32_t> _refs;
+
+    const char *Key() const { return reinterpret_cast<const char *>(this + 1); }
+    const char *Value() const { return Key() + _key_size; }
+    char *Value() { return reinterpret_cast<char *>(this + 1) + _key_size; }
+
+    bool Expired(uint32_t now) const { return _expire != 0 && _expire <= now; }
+
+    std::string KeyString() const { return std::string(Key(), _key_size); }
+
+    bool Matches(const std::string &key) const {
+        return key.size() == _key_size && std::memcmp(Key(), key.data(), _key_size) == 0;
+    }
+
+    // Bytes heap allocator keeps in front of each block
+    static const size_t heap_header = sizeof(size_t);
+
+    // Sizes are kept in 32 bits, so storages refuse items with larger key + value
+    static const size_t max_size = UINT32_MAX;
+
+    // Total number of bytes occupied by the block
+    size_t Footprint() const { return Footprint(_capacity); }
+    static size_t Footprint(size_t capacity) { return sizeof(Entry) + capacity; }
+
+    // Allocates new entry block with given key and value. Links are set to nullptr
+    static Entry *Create(const std::string &key, size_t hash, const std::string &value) {
+        return Create(key.data(), key.size(), hash, value.data(), value.size());
+    }
+
+    /**
+     * Allocates new entry block with given key and value, links are set to
+     * nullptr. Block has room for at least reserve bytes of key and value
+     */
+    static Entry *Create(const char *key, size_t key_size, size_t hash, const char *value, size_t value_size,
+                         size_t reserve = 0) {
+        void *memory = std::malloc(Footprint(std::max(key_size + value_size, reserve)));
+        if (memory == nullptr) {
+            throw std::bad_alloc();
+        }
+        // Allocator rounds block up, the rest of it is available for the value to grow
+        size_t capacity = malloc_usable_size(memory) - sizeof(Entry);
+        if (capacity > max_size) {
+            capacity = max_size;
+        }
+        return Init(memory, capacity, key, key_size, hash, value, value_size);
+    }
+
+    /**
+     * Builds entry in the given memory block which has capacity bytes for key and
+     * value after the header
+     */
+    static Entry *Init(void *memory, size_t capacity, const char *key, size_t key_size, size_t hash,
+                       const char *value, size_t value_size) {
+        Entry *entry = static_cast<Entry *>(memory);
+        entry->_next = nullptr;
+        entry->_prev = nullptr;
+        entry->_hash = hash;
+        entry->_key_size = key_size;
+        entry->_value_size = value_size;
+        entry->_capacity = capacity;
+        entry->_expire = 0;
+        entry->_timer = 0;
+        entry->_version = 0;
+        entry->_referenced.store(0, std::memory_order_relaxed);
+        entry->_segment = 0;
+        entry->_compressed = 0;
+        new (&entry->_refs) std::atomic<uint32_t>(1);
+        std::memcpy(entry + 1, key, key_size);
+        std::memcpy(entry->Value(), value, value_size);
+        return entry;
+    }
+
+    static void Destroy(Entry *entry) { std::free(entry); }
+
+    // Drops one reference to the heap entry, the last one frees it
+    static void Unref(Entry *entry) {
+        if (entry->_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Destroy(entry);
+        }
+    }
+
+    static void Release(void *entry) { Destroy(static_cast<Entry *>(entry)); }
+
+    /**
+     * Returns reference to the value of the heap entry
+     */
+    ValueRef Ref() {
+        _refs.fetch_add(1, std::memory_order_relaxed);
+        return ValueRef(Value(), _value_size, &_refs, this, Release);
+    }
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ENTRY_H
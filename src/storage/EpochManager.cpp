@@ -0,0 +1,112 @@
+#include "EpochManager.h"
+
+#include <mutex>
+#include <stdexcept>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Process wide registry of thread indexes, index is released once thread exits so
+// short living threads don't exhaust records
+std::mutex registry_lock;
+std::vector<size_t> free_indexes;
+size_t next_index = 0;
+
+struct ThreadIndex {
+    size_t index;
+
+    ThreadIndex() {
+        std::lock_guard<std::mutex> lock(registry_lock);
+        if (!free_indexes.empty()) {
+            index = free_indexes.back();
+            free_indexes.pop_back();
+        } else if (next_index < EpochManager::max_threads) {
+            index = next_index++;
+        } else {
+            throw std::runtime_error("Too many threads for epoch manager");
+        }
+    }
+
+    ~ThreadIndex() {
+        std::lock_guard<std::mutex> lock(registry_lock);
+        free_indexes.push_back(index);
+    }
+};
+
+size_t CurrentThreadIndex() {
+    static thread_local ThreadIndex current;
+    return current.index;
+}
+
+} // namespace
+
+// See EpochManager.h
+EpochManager::Guard::Guard(const EpochManager &manager)
+    : _announce(manager._records[CurrentThreadIndex()].epoch) {
+    // Announce must be visible before any shared pointer is read, so seq_cst. Writer
+    // might advance epoch in between, announce the fresh one then
+    uint64_t epoch = manager._global.load();
+    _announce.store(epoch);
+    while (epoch != manager._global.load()) {
+        epoch = manager._global.load();
+        _announce.store(epoch);
+    }
+}
+
+// See EpochManager.h
+EpochManager::Guard::~Guard() { _announce.store(0, std::memory_order_release); }
+
+// See EpochManager.h
+EpochManager::EpochManager() : _global(1), _retired_since_reclaim(0) {
+    for (Record &record : _records) {
+        record.epoch.store(0, std::memory_order_relaxed);
+    }
+}
+
+// See EpochManager.h
+EpochManager::~EpochManager() {
+    for (auto &list : _retired) {
+        _Free(list);
+    }
+}
+
+// See EpochManager.h
+void EpochManager::Retire(void *p, void (*deleter)(void *)) {
+    _retired[_global.load(std::memory_order_relaxed) % 3].push_back(Retired{p, deleter});
+    if (++_retired_since_reclaim >= reclaim_period) {
+        Reclaim();
+    }
+}
+
+// See EpochManager.h
+void EpochManager::Reclaim() {
+    _retired_since_reclaim = 0;
+
+    uint64_t epoch = _global.load();
+    for (const Record &record : _records) {
+        uint64_t announce = record.epoch.load();
+        if (announce != 0 && announce != epoch) {
+            return;
+        }
+    }
+
+    // All active readers are in the current epoch, so nobody could hold objects
+    // retired two epochs ago. Their list is reused for the next epoch
+    _global.store(epoch + 1);
+    _Free(_retired[(epoch + 1) % 3]);
+}
+
+// See EpochManager.h
+size_t EpochManager::Pending() const { return _retired[0].size() + _retired[1].size() + _retired[2].size(); }
+
+void EpochManager::_Free(std::vector<Retired> &list) {
+    for (const Retired &retired : list) {
+        retired.deleter(retired.p);
+    }
+    list.clear();
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,101 @@
+#ifndef AFINA_STORAGE_EPOCH_MANAGER_H
+#define AFINA_STORAGE_EPOCH_MANAGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Epoch based memory reclamation
+ * Lets readers access shared objects without locks while writers unlink and
+ * release them. Reader announces the global epoch it observed for the time of
+ * the access (see Guard). Writer that unlinks object retires it instead of
+ * deleting; object is deleted only once global epoch advanced twice since then,
+ * so no reader could still see it.
+ *
+ * Epoch advances only when all active readers announced the current one, so a
+ * stalled reader delays reclamation, but never blocks anyone.
+ *
+ * Readers are wait-free and could run in any number of threads (up to
+ * max_threads at once). Retire and Reclaim must be serialized by the caller,
+ * usually they are called under the writer lock.
+ */
+class EpochManager {
+public:
+    // Max number of threads that could be inside guards at the same time
+    static const size_t max_threads = 256;
+
+    /**
+     * Marks calling thread as active reader for the lifetime of the guard. Guards
+     * of the same manager must not be nested
+     */
+    class Guard {
+    public:
+        explicit Guard(const EpochManager &manager);
+        ~Guard();
+
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+
+    private:
+        std::atomic<uint64_t> &_announce;
+    };
+
+    EpochManager();
+
+    // Deletes all retired objects, there must be no readers left
+    ~EpochManager();
+
+    EpochManager(const EpochManager &) = delete;
+    EpochManager &operator=(const EpochManager &) = delete;
+
+    /**
+     * Schedules deleter(p) once no reader could access p anymore. Object must be
+     * already unreachable for the new readers
+     */
+    void Retire(void *p, void (*deleter)(void *));
+
+    /**
+     * Tries to advance epoch and deletes objects that are safe to delete
+     */
+    void Reclaim();
+
+    // Number of objects waiting for deletion
+    size_t Pending() const;
+
+private:
+    struct Retired {
+        void *p;
+        void (*deleter)(void *);
+    };
+
+    // Announce of a single thread, 0 if thread isn't inside a guard. Padded to
+    // the cache line, so readers never write the same line
+    struct Record {
+        std::atomic<uint64_t> epoch;
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    void _Free(std::vector<Retired> &list);
+
+    // Objects are retired at least once per this number of Retire calls
+    static const size_t reclaim_period = 64;
+
+    // Starts from 1, so 0 is never valid announce
+    std::atomic<uint64_t> _global;
+
+    mutable Record _records[max_threads];
+
+    // Retired objects by epoch % 3: current, previous and the one before it
+    std::vector<Retired> _retired[3];
+    size_t _retired_since_reclaim;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EPOCH_MANAGER_H
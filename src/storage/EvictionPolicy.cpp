@@ -0,0 +1,53 @@
+#include "EvictionPolicy.h"
+
+#include <stdexcept>
+
+#include "ClockPolicy.h"
+#include "LRUPolicy.h"
+#include "SegmentedLRUPolicy.h"
+#include "TinyLFUPolicy.h"
+
+namespace Afina {
+namespace Backend {
+
+// See EvictionPolicy.h
+std::unique_ptr<EvictionPolicy> EvictionPolicy::Create(const std::string &name, size_t max_size) {
+    if (name == "lru") {
+        return std::unique_ptr<EvictionPolicy>(new LRUPolicy());
+    } else if (name == "clock") {
+        return std::unique_ptr<EvictionPolicy>(new ClockPolicy());
+    } else if (name == "slru") {
+        return std::unique_ptr<EvictionPolicy>(new SegmentedLRUPolicy(max_size));
+    } else if (name == "tinylfu") {
+        return std::unique_ptr<EvictionPolicy>(new TinyLFUPolicy(max_size));
+    }
+    throw std::invalid_argument("Unknown eviction policy: " + name);
+}
+
+// See EvictionPolicy.h
+Entry *EvictionPolicy::_Pick(std::initializer_list<const EntryList *> lists, const Entry *keep,
+                             const Preference &prefer) {
+    if (prefer) {
+        size_t looked = 0;
+        for (const EntryList *list : lists) {
+            for (Entry *entry = list->Tail(); entry != nullptr && looked < max_lookup; entry = entry->_prev) {
+                if (entry != keep && prefer(entry)) {
+                    return entry;
+                }
+                looked++;
+            }
+        }
+    }
+
+    for (const EntryList *list : lists) {
+        for (Entry *entry = list->Tail(); entry != nullptr; entry = entry->_prev) {
+            if (entry != keep) {
+                return entry;
+            }
+        }
+    }
+    return nullptr;
+}
+
+} // namespace Backend
+} // namespace Afina
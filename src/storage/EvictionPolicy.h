@@ -0,0 +1,160 @@
+#ifndef AFINA_STORAGE_EVICTION_POLICY_H
+#define AFINA_STORAGE_EVICTION_POLICY_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "Entry.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Intrusive list of entries
+ * Uses entry links, so entry could be in a single list at a time. Keeps total
+ * charge of its entries, policies use it to limit segments by bytes
+ */
+class EntryList {
+public:
+    EntryList() : _head(nullptr), _tail(nullptr), _bytes(0), _count(0) {}
+
+    // Number of bytes storage accounts for the entry
+    static size_t Charge(const Entry *entry) { return entry->_key_size + entry->_value_size; }
+
+    Entry *Head() const { return _head; }
+    Entry *Tail() const { return _tail; }
+    size_t Bytes() const { return _bytes; }
+    size_t Count() const { return _count; }
+
+    void PushFront(Entry *entry) {
+        entry->_prev = nullptr;
+        entry->_next = _head;
+        if (_head != nullptr) {
+            _head->_prev = entry;
+        }
+        _head = entry;
+        if (_tail == nullptr) {
+            _tail = entry;
+        }
+        _bytes += Charge(entry);
+        _count++;
+    }
+
+    void Unlink(Entry *entry) {
+        if (entry->_prev != nullptr) {
+            entry->_prev->_next = entry->_next;
+        } else {
+            _head = entry->_next;
+        }
+        if (entry->_next != nullptr) {
+            entry->_next->_prev = entry->_prev;
+        } else {
+            _tail = entry->_prev;
+        }
+        entry->_next = nullptr;
+        entry->_prev = nullptr;
+        _bytes -= Charge(entry);
+        _count--;
+    }
+
+    void MoveToFront(Entry *entry) {
+        if (entry != _head) {
+            Unlink(entry);
+            PushFront(entry);
+        }
+    }
+
+    // New entry takes the place of the old one in the list
+    void Replace(Entry *old_entry, Entry *new_entry) {
+        new_entry->_prev = old_entry->_prev;
+        new_entry->_next = old_entry->_next;
+        (new_entry->_prev != nullptr ? new_entry->_prev->_next : _head) = new_entry;
+        (new_entry->_next != nullptr ? new_entry->_next->_prev : _tail) = new_entry;
+        _bytes = _bytes + Charge(new_entry) - Charge(old_entry);
+        new_entry->_segment = old_entry->_segment;
+    }
+
+    // Charge of the entry in the list was changed from old_charge
+    void Resize(Entry *entry, size_t old_charge) { _bytes = _bytes + Charge(entry) - old_charge; }
+
+private:
+    Entry *_head;
+    Entry *_tail;
+    size_t _bytes;
+    size_t _count;
+};
+
+/**
+ * # Eviction policy
+ * Decides which entry leaves the storage once there is no space for the new one.
+ * Policy owns order of the entries: storage notifies it about all changes and asks
+ * for victims, but never touches entry links itself.
+ *
+ * Policies:
+ *  - lru: strict move-to-front on every access
+ *  - clock: access only sets reference bit, tail entries with the bit set get
+ *    second chance, so reads don't write list pointers
+ *  - slru: segmented LRU, new entries go to probation segment and only those
+ *    accessed again get into protected one, so single scan can't flush hot set
+ *  - tinylfu: W-TinyLFU, small LRU window in front of SLRU and frequency sketch
+ *    that admits window candidate to the main part only if it is more popular
+ *    than the main victim
+ *
+ * Policy is not thread safe, storage calls it under its lock.
+ */
+class EvictionPolicy {
+public:
+    // Predicate over entries that should be evicted first if possible
+    using Preference = std::function<bool(const Entry *)>;
+
+    virtual ~EvictionPolicy() {}
+
+    /**
+     * Builds policy by name, throws std::invalid_argument for unknown one.
+     * max_size is the storage capacity, segmented policies split it
+     */
+    static std::unique_ptr<EvictionPolicy> Create(const std::string &name, size_t max_size);
+
+    // New entry is stored
+    virtual void Insert(Entry *entry) = 0;
+
+    // Entry is accessed: read or written
+    virtual void Touch(Entry *entry) = 0;
+
+    // Lookup of the key with given hash missed
+    virtual void Miss(size_t hash) {}
+
+    // Entry is about to be removed from the storage
+    virtual void Remove(Entry *entry) = 0;
+
+    // Entry block is reallocated, new one takes the place of the old one
+    virtual void Replace(Entry *old_entry, Entry *new_entry) = 0;
+
+    // Value of the entry was changed in place, it was old_charge bytes before
+    virtual void Resize(Entry *entry, size_t old_charge) = 0;
+
+    /**
+     * Returns entry that should be evicted next or nullptr if there is nothing but
+     * keep. If prefer is set, entries matching it are returned first if any of
+     * them is close to the eviction point. Policy may reorder entries while
+     * looking for the victim, but returned one is still tracked until Remove
+     */
+    virtual Entry *Victim(const Entry *keep, const Preference &prefer = nullptr) = 0;
+
+protected:
+    // Number of entries looked through for the preferred one
+    static const size_t max_lookup = 32;
+
+    /**
+     * Looks through lists from the tail to the head in the given order. Returns
+     * first preferred entry among the first max_lookup ones, or just the first one
+     */
+    static Entry *_Pick(std::initializer_list<const EntryList *> lists, const Entry *keep, const Preference &prefer);
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EVICTION_POLICY_H
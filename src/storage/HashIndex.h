@@ -0,0 +1,235 @@
+#ifndef AFINA_STORAGE_HASH_INDEX_H
+#define AFINA_STORAGE_HASH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Open addressing hash index over storage entries
+ * Robin Hood hash table that maps keys to entry pointers. The table owns no
+ * entries, it only keeps pointers to them together with the full key hash.
+ *
+ * Each slot is 16 bytes (hash + pointer), so a cache line holds four slots and
+ * lookup compares precomputed hashes first. Entry memory is touched only when
+ * hashes match, so a successful lookup usually costs one line of slots plus the
+ * entry itself.
+ *
+ * Robin Hood insertion keeps probe sequences short: a new element takes place of
+ * any element that is closer to its home slot. Erase uses backward shift so no
+ * tombstones are needed.
+ *
+ * Entry type must provide method `bool Matches(const std::string &key) const`
+ */
+template <typename Entry> class HashIndex {
+public:
+    HashIndex() : _slots(_Allocate(min_capacity)), _mask(min_capacity - 1), _size(0) {}
+    ~HashIndex() { std::free(_slots); }
+
+    HashIndex(const HashIndex &) = delete;
+    HashIndex &operator=(const HashIndex &) = delete;
+
+    /**
+     * Hash function used by the index. Callers could compute it once and pass to
+     * several calls
+     */
+    static size_t Hash(const std::string &key) { return _Fix(std::hash<std::string>()(key)); }
+
+    /**
+     * Returns entry associated with the given key or nullptr if there is no such
+     * key in the index
+     */
+    Entry *Find(const std::string &key, size_t hash) const {
+        hash = _Fix(hash);
+        size_t pos = hash & _mask;
+        for (size_t dist = 0;; dist++, pos = (pos + 1) & _mask) {
+            const Slot &slot = _slots[pos];
+            if (slot.hash == empty_hash || _Distance(slot.hash, pos) < dist) {
+                return nullptr;
+            }
+            if (slot.hash == hash && slot.entry->Matches(key)) {
+                return slot.entry;
+            }
+        }
+    }
+
+    /**
+     * Hints CPU that slots for the given hash are going to be read soon
+     */
+    void Prefetch(size_t hash) const { __builtin_prefetch(&_slots[_Fix(hash) & _mask]); }
+
+    /**
+     * Adds new entry into the index. Caller must guarantee that there is no
+     * entry with the same key yet
+     */
+    void Insert(size_t hash, Entry *entry) {
+        if ((_size + 1) * max_load_den > (_mask + 1) * max_load_num) {
+            _Grow();
+        }
+        _Place(_Fix(hash), entry);
+        _size++;
+    }
+
+    /**
+     * Replaces pointer for an entry which is already in the index, for example
+     * once entry was reallocated
+     */
+    void Replace(size_t hash, Entry *old_entry, Entry *new_entry) {
+        size_t pos = _Lookup(_Fix(hash), old_entry);
+        if (pos != not_found) {
+            _slots[pos].entry = new_entry;
+        }
+    }
+
+    /**
+     * Removes given entry from the index. Returns false if entry isn't indexed
+     */
+    bool Erase(size_t hash, Entry *entry) {
+        size_t pos = _Lookup(_Fix(hash), entry);
+        if (pos == not_found) {
+            return false;
+        }
+
+        // Backward shift: move following elements one step closer to their home
+        size_t next = (pos + 1) & _mask;
+        while (_slots[next].hash != empty_hash && _Distance(_slots[next].hash, next) != 0) {
+            _slots[pos] = _slots[next];
+            pos = next;
+            next = (next + 1) & _mask;
+        }
+        _slots[pos].hash = empty_hash;
+        _slots[pos].entry = nullptr;
+        _size--;
+        return true;
+    }
+
+    /**
+     * Calls fn for each entry in the index
+     */
+    template <typename F> void ForEach(F fn) const {
+        for (size_t i = 0; i <= _mask; i++) {
+            if (_slots[i].hash != empty_hash) {
+                fn(_slots[i].entry);
+            }
+        }
+    }
+
+    /**
+     * Calls fn for entries in at most count slots starting from the cursor.
+     * Returns position to continue from, or 0 once the end of the table is
+     * reached. Entries moved by inserts and erases between calls could be missed
+     * or visited twice
+     */
+    template <typename F> size_t Scan(size_t cursor, size_t count, F fn) const {
+        size_t end = cursor + count;
+        if (end > _mask + 1 || end < cursor) {
+            end = _mask + 1;
+        }
+        for (size_t i = cursor; i < end; i++) {
+            if (_slots[i].hash != empty_hash) {
+                fn(_slots[i].entry);
+            }
+        }
+        return end > _mask ? 0 : end;
+    }
+
+    size_t Size() const { return _size; }
+    size_t Capacity() const { return _mask + 1; }
+
+    /**
+     * Number of bytes used by the table itself
+     */
+    size_t MemoryUsage() const { return sizeof(Slot) * (_mask + 1); }
+
+private:
+    struct Slot {
+        size_t hash;
+        Entry *entry;
+    };
+
+    static const size_t empty_hash = 0;
+    static const size_t not_found = size_t(-1);
+    static const size_t min_capacity = 16;
+
+    // Table grows once it is filled up to 7/8
+    static const size_t max_load_num = 7;
+    static const size_t max_load_den = 8;
+
+    // Zero is reserved to mark empty slots
+    static size_t _Fix(size_t hash) { return hash == empty_hash ? 1 : hash; }
+
+    // How far slot at the given position is from its home slot
+    size_t _Distance(size_t hash, size_t pos) const { return (pos - (hash & _mask)) & _mask; }
+
+    size_t _Lookup(size_t hash, Entry *entry) const {
+        size_t pos = hash & _mask;
+        for (size_t dist = 0;; dist++, pos = (pos + 1) & _mask) {
+            const Slot &slot = _slots[pos];
+            if (slot.hash == empty_hash || _Distance(slot.hash, pos) < dist) {
+                return not_found;
+            }
+            if (slot.entry == entry) {
+                return pos;
+            }
+        }
+    }
+
+    void _Place(size_t hash, Entry *entry) {
+        Slot current = {hash, entry};
+        size_t pos = hash & _mask;
+        for (size_t dist = 0;; dist++, pos = (pos + 1) & _mask) {
+            Slot &slot = _slots[pos];
+            if (slot.hash == empty_hash) {
+                slot = current;
+                return;
+            }
+
+            // Rich element gives its place to the poor one and continues probing
+            size_t slot_dist = _Distance(slot.hash, pos);
+            if (slot_dist < dist) {
+                Slot tmp = slot;
+                slot = current;
+                current = tmp;
+                dist = slot_dist;
+            }
+        }
+    }
+
+    static Slot *_Allocate(size_t capacity) {
+        Slot *slots = static_cast<Slot *>(std::calloc(capacity, sizeof(Slot)));
+        if (slots == nullptr) {
+            throw std::bad_alloc();
+        }
+        return slots;
+    }
+
+    // Old table is replaced only once the new one is allocated, so the index
+    // stays intact if growing throws
+    void _Grow() {
+        Slot *old_slots = _slots;
+        size_t old_capacity = _mask + 1;
+
+        _slots = _Allocate(old_capacity * 2);
+        _mask = old_capacity * 2 - 1;
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old_slots[i].hash != empty_hash) {
+                _Place(old_slots[i].hash, old_slots[i].entry);
+            }
+        }
+        std::free(old_slots);
+    }
+
+    Slot *_slots;
+    size_t _mask;
+    size_t _size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_INDEX_H
@@ -0,0 +1,42 @@
+#ifndef AFINA_STORAGE_LRU_POLICY_H
+#define AFINA_STORAGE_LRU_POLICY_H
+
+#include "EvictionPolicy.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Least recently used
+ * Every access moves entry to the head of the list, victim is the tail
+ */
+class LRUPolicy : public EvictionPolicy {
+public:
+    // Implements EvictionPolicy interface
+    void Insert(Entry *entry) override { _list.PushFront(entry); }
+
+    // Implements EvictionPolicy interface
+    void Touch(Entry *entry) override { _list.MoveToFront(entry); }
+
+    // Implements EvictionPolicy interface
+    void Remove(Entry *entry) override { _list.Unlink(entry); }
+
+    // Implements EvictionPolicy interface
+    void Replace(Entry *old_entry, Entry *new_entry) override { _list.Replace(old_entry, new_entry); }
+
+    // Implements EvictionPolicy interface
+    void Resize(Entry *entry, size_t old_charge) override { _list.Resize(entry, old_charge); }
+
+    // Implements EvictionPolicy interface
+    Entry *Victim(const Entry *keep, const Preference &prefer = nullptr) override {
+        return _Pick({&_list}, keep, prefer);
+    }
+
+private:
+    EntryList _list;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_LRU_POLICY_H
@@ -0,0 +1,160 @@
+#include "Lzf.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace Afina {
+namespace Backend {
+
+// Size of the hash table is 1 << hash_log, it lives on the stack
+static const size_t hash_log = 13;
+static const size_t hash_size = 1 << hash_log;
+
+// Longest literal run, farthest and longest back reference
+static const size_t max_literal = 1 << 5;
+static const size_t max_offset = 1 << 13;
+static const size_t max_reference = (1 << 8) + (1 << 3);
+
+static inline uint32_t Hash(const uint8_t *p) {
+    uint32_t v = (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | p[2];
+    return (v * 2654435761u) >> (32 - hash_log);
+}
+
+// See Lzf.h
+size_t LzfCompress(const char *in_data, size_t size, char *out_data, size_t out_size) {
+    const uint8_t *in = reinterpret_cast<const uint8_t *>(in_data);
+    uint8_t *out = reinterpret_cast<uint8_t *>(out_data);
+
+    // Position + 1 of the last sequence with the given hash, 0 if there is none
+    uint32_t table[hash_size];
+
+    // Literal run is written behind its control byte at lit_start
+    size_t ip = 0, op = 1, lit_start = 0, lit = 0;
+
+    if (size == 0 || out_size == 0 || size > UINT32_MAX) {
+        return 0;
+    }
+    std::memset(table, 0, sizeof(table));
+
+    while (ip < size) {
+        if (ip + 2 < size) {
+            uint32_t h = Hash(in + ip);
+            size_t ref = table[h];
+            table[h] = static_cast<uint32_t>(ip + 1);
+
+            if (ref != 0 && ip - (ref - 1) <= max_offset && std::memcmp(in + ref - 1, in + ip, 3) == 0) {
+                size_t off = ip - ref, max = size - ip, len = 3;
+                ref--;
+                if (max > max_reference) {
+                    max = max_reference;
+                }
+                while (len < max && in[ref + len] == in[ip + len]) {
+                    len++;
+                }
+
+                // Close the literal run, control byte without literals is dropped
+                if (lit != 0) {
+                    out[lit_start] = static_cast<uint8_t>(lit - 1);
+                } else {
+                    op--;
+                }
+
+                // Back reference and control byte of the next run
+                if (op + 4 > out_size) {
+                    return 0;
+                }
+                len -= 2;
+                if (len < 7) {
+                    out[op++] = static_cast<uint8_t>((len << 5) | (off >> 8));
+                } else {
+                    out[op++] = static_cast<uint8_t>((7 << 5) | (off >> 8));
+                    out[op++] = static_cast<uint8_t>(len - 7);
+                }
+                out[op++] = static_cast<uint8_t>(off);
+                lit_start = op++;
+                lit = 0;
+
+                // Positions inside of the match are hashed too, that finds more
+                // matches at a small cost
+                len += 2;
+                for (size_t i = 1; i < len && ip + i + 2 < size; i++) {
+                    table[Hash(in + ip + i)] = static_cast<uint32_t>(ip + i + 1);
+                }
+                ip += len;
+                continue;
+            }
+        }
+
+        if (op >= out_size) {
+            return 0;
+        }
+        out[op++] = in[ip++];
+        if (++lit == max_literal) {
+            out[lit_start] = max_literal - 1;
+            lit_start = op++;
+            lit = 0;
+        }
+    }
+
+    if (lit != 0) {
+        out[lit_start] = static_cast<uint8_t>(lit - 1);
+    } else {
+        op--;
+    }
+    return op;
+}
+
+// See Lzf.h
+size_t LzfDecompress(const char *in_data, size_t size, char *out_data, size_t out_size) {
+    const uint8_t *in = reinterpret_cast<const uint8_t *>(in_data);
+    uint8_t *out = reinterpret_cast<uint8_t *>(out_data);
+    size_t ip = 0, op = 0;
+
+    while (ip < size) {
+        size_t ctrl = in[ip++];
+
+        if (ctrl < max_literal) {
+            // Literal run
+            size_t len = ctrl + 1;
+            if (size - ip < len || out_size - op < len) {
+                return 0;
+            }
+            std::memcpy(out + op, in + ip, len);
+            ip += len;
+            op += len;
+            continue;
+        }
+
+        // Back reference
+        size_t len = ctrl >> 5;
+        if (len == 7) {
+            if (ip >= size) {
+                return 0;
+            }
+            len += in[ip++];
+        }
+        if (ip >= size) {
+            return 0;
+        }
+        size_t off = ((ctrl & 0x1f) << 8) + in[ip++] + 1;
+        len += 2;
+        if (off > op || out_size - op < len) {
+            return 0;
+        }
+
+        // Reference overlapping the bytes it produces is copied bytewise
+        const uint8_t *ref = out + op - off;
+        if (off >= len) {
+            std::memcpy(out + op, ref, len);
+            op += len;
+        } else {
+            for (size_t i = 0; i < len; i++) {
+                out[op++] = ref[i];
+            }
+        }
+    }
+    return op;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,45 @@
+#ifndef AFINA_STORAGE_LZF_H
+#define AFINA_STORAGE_LZF_H
+
+#include <cstddef>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LZF codec
+ * Byte oriented LZ77 compression: no entropy coding, 8Kb window and a single hash
+ * probe per position. Ratio is modest, but both directions run at hundreds of
+ * megabytes per second on a single core.
+ *
+ * Stream is a sequence of chunks, each starts with a control byte:
+ *
+ *     000LLLLL <L+1 literal bytes>
+ *     LLLooooo oooooooo           copy L+2 bytes from o+1 bytes back, L in 1..6
+ *     111ooooo LLLLLLLL oooooooo  copy L+9 bytes from o+1 bytes back
+ *
+ * Layout of the chunks is the one of liblzf, but the codec is written and tested
+ * here, its streams are never read by anything but this storage.
+ */
+
+/**
+ * Compresses size bytes at in into out of out_size bytes. Returns size of the
+ * stream or 0 if it doesn't fit into out_size bytes (or input is empty), out is
+ * garbage then.
+ *
+ * Stream is never larger than 104% of the input plus 1 byte, so the output could
+ * be made smaller than the input to only keep data that compresses well
+ */
+size_t LzfCompress(const char *in, size_t size, char *out, size_t out_size);
+
+/**
+ * Decompresses size bytes of stream at in into out of out_size bytes. Returns
+ * size of the output or 0 if it doesn't fit into out_size bytes or the stream is
+ * corrupted. Never reads or writes out of the buffers
+ */
+size_t LzfDecompress(const char *in, size_t size, char *out, size_t out_size);
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_LZF_H
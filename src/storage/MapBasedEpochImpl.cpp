@@ -0,0 +1,418 @@
+#include "MapBasedEpochImpl.h"
+
+namespace Afina {
+namespace Backend {
+
+// See MapBasedEpochImpl.h
+MapBasedEpochImpl::MapBasedEpochImpl(size_t max_size, size_t memory_limit)
+    : _max_size(max_size), _memory_limit(memory_limit), _cur_size(0), _footprint(0), _last_version(0),
+      _index(_epoch), head(nullptr), tail(nullptr) {}
+
+// See MapBasedEpochImpl.h
+MapBasedEpochImpl::~MapBasedEpochImpl() {
+    // No readers are left, so entries could be freed right away
+    while (head != nullptr) {
+        Entry *next = head->_next;
+        Entry::Unref(head);
+        head = next;
+    }
+}
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::Put(const std::string &key, const std::string &value, time_t expire) {
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    uint32_t deadline = TimerWheel::Deadline(expire);
+    size_t hash = _index.Hash(key);
+    Entry *entry = _Find(key, hash, now);
+    if (deadline != 0 && deadline <= now) {
+        // Stored and expired right away
+        if (entry != nullptr) {
+            _Remove(entry);
+        }
+        return true;
+    }
+
+    if (entry == nullptr) {
+        return _Insert(key, hash, value, deadline);
+    }
+    return _Update(entry, value, deadline);
+}
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::PutIfAbsent(const std::string &key, const std::string &value, time_t expire) {
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    uint32_t deadline = TimerWheel::Deadline(expire);
+    size_t hash = _index.Hash(key);
+    if (_Find(key, hash, now) != nullptr) {
+        return false;
+    }
+    if (deadline != 0 && deadline <= now) {
+        return true;
+    }
+    return _Insert(key, hash, value, deadline);
+}
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::Set(const std::string &key, const std::string &value, time_t expire) {
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    uint32_t deadline = TimerWheel::Deadline(expire);
+    Entry *entry = _Find(key, _index.Hash(key), now);
+    if (entry == nullptr) {
+        return false;
+    }
+    if (deadline != 0 && deadline <= now) {
+        _Remove(entry);
+        return true;
+    }
+    return _Update(entry, value, deadline);
+}
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::Delete(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    Entry *entry = _Find(key, _index.Hash(key), now);
+    if (entry == nullptr) {
+        return false;
+    }
+    _Remove(entry);
+    return true;
+}
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::Append(const std::string &key, const std::string &data) { return _Extend(key, data, false); }
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::Prepend(const std::string &key, const std::string &data) { return _Extend(key, data, true); }
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Count(key, delta, false, value);
+}
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Count(key, delta, true, value);
+}
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::Get(const std::string &key, std::string &value) const {
+    EpochManager::Guard guard(_epoch);
+    Entry *entry = _index.Find(key, _index.Hash(key));
+    if (entry == nullptr || entry->Expired(TimerWheel::Now())) {
+        return false;
+    }
+    value.assign(entry->Value(), entry->_value_size);
+
+    // Check first, so hot entries are not written by every reader
+    if (entry->_referenced.load(std::memory_order_relaxed) == 0) {
+        entry->_referenced.store(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// See MapBasedEpochImpl.h
+ValueRef MapBasedEpochImpl::GetRef(const std::string &key) const {
+    EpochManager::Guard guard(_epoch);
+    Entry *entry = _index.Find(key, _index.Hash(key));
+    if (entry == nullptr || entry->Expired(TimerWheel::Now())) {
+        return ValueRef();
+    }
+    if (entry->_referenced.load(std::memory_order_relaxed) == 0) {
+        entry->_referenced.store(1, std::memory_order_relaxed);
+    }
+
+    // Guard keeps the entry alive, so its counter is still positive here
+    return entry->Ref();
+}
+
+// See MapBasedEpochImpl.h
+size_t MapBasedEpochImpl::MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values) const {
+    return _MultiGet(keys, values, nullptr);
+}
+
+// See MapBasedEpochImpl.h
+size_t MapBasedEpochImpl::Gets(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                               std::vector<uint64_t> &versions) const {
+    versions.assign(keys.size(), 0);
+    return _MultiGet(keys, values, &versions);
+}
+
+// See MapBasedEpochImpl.h
+CasResult MapBasedEpochImpl::CompareAndSet(const std::string &key, const std::string &value, uint64_t version,
+                                           time_t expire) {
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    uint32_t deadline = TimerWheel::Deadline(expire);
+    Entry *entry = _Find(key, _index.Hash(key), now);
+    if (entry == nullptr) {
+        return CasResult::NotFound;
+    }
+    if (entry->_version != version) {
+        return CasResult::Exists;
+    }
+    if (deadline != 0 && deadline <= now) {
+        _Remove(entry);
+        return CasResult::Stored;
+    }
+    return _Update(entry, value, deadline) ? CasResult::Stored : CasResult::NotStored;
+}
+
+// See MapBasedEpochImpl.h
+size_t MapBasedEpochImpl::_MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                                    std::vector<uint64_t> *versions) const {
+    values.assign(keys.size(), ValueRef());
+
+    std::vector<size_t> hashes(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = _index.Hash(keys[i]);
+    }
+
+    EpochManager::Guard guard(_epoch);
+    for (size_t i = 0; i < keys.size() && i < prefetch_distance; i++) {
+        _index.Prefetch(hashes[i]);
+    }
+
+    uint32_t now = TimerWheel::Now();
+    size_t count = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i + prefetch_distance < keys.size()) {
+            _index.Prefetch(hashes[i + prefetch_distance]);
+        }
+
+        Entry *entry = _index.Find(keys[i], hashes[i]);
+        if (entry == nullptr || entry->Expired(now)) {
+            continue;
+        }
+        if (entry->_referenced.load(std::memory_order_relaxed) == 0) {
+            entry->_referenced.store(1, std::memory_order_relaxed);
+        }
+        values[i] = entry->Ref();
+        if (versions != nullptr) {
+            (*versions)[i] = entry->_version;
+        }
+        count++;
+    }
+    return count;
+}
+
+// See MapBasedEpochImpl.h
+size_t MapBasedEpochImpl::Scan(size_t cursor, size_t count, std::vector<ScanItem> &items) const {
+    EpochManager::Guard guard(_epoch);
+    uint32_t now = TimerWheel::Now();
+    return _index.Scan(cursor, count, [now, &items](Entry *entry) {
+        if (!entry->Expired(now)) {
+            items.push_back(ScanItem{entry->KeyString(), entry->Ref(), entry->_expire});
+        }
+    });
+}
+
+// See MapBasedEpochImpl.h
+size_t MapBasedEpochImpl::PendingReclaim() const {
+    std::lock_guard<std::mutex> lock(mut);
+    return _epoch.Pending();
+}
+
+// See MapBasedEpochImpl.h
+MemoryStats MapBasedEpochImpl::Memory() const {
+    std::lock_guard<std::mutex> lock(mut);
+    MemoryStats stats;
+    stats.items = _index.Size();
+    stats.payload = _cur_size;
+    stats.overhead = _Allocated() - _cur_size;
+    stats.limit = _memory_limit != 0 ? _memory_limit : _max_size;
+    return stats;
+}
+
+// See MapBasedEpochImpl.h
+size_t MapBasedEpochImpl::Expire(size_t max) {
+    std::lock_guard<std::mutex> lock(mut);
+    return _Expire(TimerWheel::Now(), max);
+}
+
+// See MapBasedEpochImpl.h
+Entry *MapBasedEpochImpl::_Find(const std::string &key, size_t hash, uint32_t now) {
+    Entry *entry = _index.Find(key, hash);
+    if (entry != nullptr && entry->Expired(now)) {
+        _Remove(entry);
+        return nullptr;
+    }
+    return entry;
+}
+
+// See MapBasedEpochImpl.h
+size_t MapBasedEpochImpl::_Expire(uint32_t now, size_t max) {
+    size_t removed = 0;
+    while (removed < max) {
+        Entry *entry = _timers.Next(now);
+        if (entry == nullptr) {
+            break;
+        }
+        _Remove(entry);
+        removed++;
+    }
+    return removed;
+}
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::_Insert(const std::string &key, size_t hash, const std::string &value, uint32_t expire) {
+    size_t len = key.size() + value.size();
+    size_t bytes = Entry::Footprint(len) + Entry::heap_header;
+    if (len > _max_size || len > Entry::max_size || (_memory_limit != 0 && bytes > _memory_limit)) {
+        return false;
+    }
+    _Evict(len, bytes);
+
+    Entry *entry = Entry::Create(key, hash, value);
+    entry->_expire = expire;
+    entry->_version = ++_last_version;
+    _timers.Schedule(entry, expire);
+    _PushFront(entry);
+    _index.Insert(entry);
+    _cur_size += len;
+    _footprint += entry->Footprint() + Entry::heap_header;
+    return true;
+}
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::_Update(Entry *entry, const std::string &value, uint32_t expire) {
+    size_t len = entry->_key_size + value.size();
+    size_t bytes = Entry::Footprint(len) + Entry::heap_header;
+    if (len > _max_size || len > Entry::max_size || (_memory_limit != 0 && bytes > _memory_limit)) {
+        return false;
+    }
+
+    // Entry is out of the list while space is freed, so it is never evicted itself
+    _Unlink(entry);
+    _cur_size -= entry->_key_size + entry->_value_size;
+    _footprint -= entry->Footprint() + Entry::heap_header;
+    _Evict(len, bytes);
+
+    // Readers might copy the value right now, so it is never changed in place
+    Entry *replacement = Entry::Create(entry->Key(), entry->_key_size, entry->_hash, value.data(), value.size());
+    replacement->_expire = expire;
+    replacement->_version = ++_last_version;
+    _timers.Replace(entry, replacement);
+    _timers.Schedule(replacement, expire);
+    _cur_size += len;
+    _footprint += replacement->Footprint() + Entry::heap_header;
+    _PushFront(replacement);
+    _index.Replace(entry, replacement);
+    _epoch.Retire(entry, _Destroy);
+    return true;
+}
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::_Extend(const std::string &key, const std::string &data, bool front) {
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    Entry *entry = _Find(key, _index.Hash(key), now);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    std::string value;
+    value.reserve(entry->_value_size + data.size());
+    if (front) {
+        value.append(data).append(entry->Value(), entry->_value_size);
+    } else {
+        value.append(entry->Value(), entry->_value_size).append(data);
+    }
+    return _Update(entry, value, entry->_expire);
+}
+
+// See MapBasedEpochImpl.h
+bool MapBasedEpochImpl::_Count(const std::string &key, uint64_t delta, bool decrement, uint64_t &value) {
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    Entry *entry = _Find(key, _index.Hash(key), now);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    uint64_t counter;
+    if (!ParseCounter(entry->Value(), entry->_value_size, counter)) {
+        throw std::invalid_argument("Value is not a number");
+    }
+    value = decrement ? counter - std::min(counter, delta) : counter + delta;
+    return _Update(entry, std::to_string(value), entry->_expire);
+}
+
+// See MapBasedEpochImpl.h
+void MapBasedEpochImpl::_Remove(Entry *entry) {
+    _cur_size -= entry->_key_size + entry->_value_size;
+    _footprint -= entry->Footprint() + Entry::heap_header;
+    _Unlink(entry);
+    _index.Erase(entry);
+    _timers.Cancel(entry);
+    _epoch.Retire(entry, _Destroy);
+}
+
+// See MapBasedEpochImpl.h
+void MapBasedEpochImpl::_Evict(size_t len, size_t bytes) {
+    while (tail != nullptr &&
+           (_max_size - _cur_size < len || (_memory_limit != 0 && _Allocated() + bytes > _memory_limit))) {
+        Entry *victim = tail;
+        if (victim->_referenced.load(std::memory_order_relaxed) != 0 && victim != head) {
+            victim->_referenced.store(0, std::memory_order_relaxed);
+            _Unlink(victim);
+            _PushFront(victim);
+            continue;
+        }
+        _Remove(victim);
+    }
+}
+
+// See MapBasedEpochImpl.h
+void MapBasedEpochImpl::_Unlink(Entry *entry) {
+    if (entry->_prev != nullptr) {
+        entry->_prev->_next = entry->_next;
+    } else {
+        head = entry->_next;
+    }
+
+    if (entry->_next != nullptr) {
+        entry->_next->_prev = entry->_prev;
+    } else {
+        tail = entry->_prev;
+    }
+
+    entry->_next = nullptr;
+    entry->_prev = nullptr;
+}
+
+// See MapBasedEpochImpl.h
+void MapBasedEpochImpl::_PushFront(Entry *entry) {
+    entry->_prev = nullptr;
+    entry->_next = head;
+    if (head != nullptr) {
+        head->_prev = entry;
+    }
+    head = entry;
+    if (tail == nullptr) {
+        tail = entry;
+    }
+}
+
+// See MapBasedEpochImpl.h
+void MapBasedEpochImpl::_Destroy(void *entry) { Entry::Unref(static_cast<Entry *>(entry)); }
+
+} // namespace Backend
+} // namespace Afina
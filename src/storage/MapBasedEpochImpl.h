@@ -0,0 +1,173 @@
+#ifndef AFINA_STORAGE_MAP_BASED_EPOCH_IMPL_H
+#define AFINA_STORAGE_MAP_BASED_EPOCH_IMPL_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "ConcurrentIndex.h"
+#include "EpochManager.h"
+#include "Entry.h"
+#include "TimerWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Map based implementation with lock-free reads
+ * Get takes no locks: it looks key up in the concurrent index and copies value
+ * out of the entry. Writers are serialized by the mutex and never change entry
+ * that could be seen by readers, instead new entry is published and the old one
+ * is retired via epoch manager.
+ *
+ * Readers don't touch LRU list. They only set reference flag of the entry (once,
+ * until it is cleared), and eviction gives such entries second chance moving
+ * them to the head. So promotion is deferred to the writers, hot keys are still
+ * kept while cold ones go away in LRU order.
+ *
+ * Readers skip expired entries, but only writers remove them: once looked up or
+ * in bounded batches in order of expiration time, see TimerWheel.h
+ */
+class MapBasedEpochImpl : public Afina::Storage {
+public:
+    // See MapBasedGlobalLockImpl for the meaning of limits
+    MapBasedEpochImpl(size_t max_size = 1024, size_t memory_limit = 0);
+    ~MapBasedEpochImpl();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface. Readers could copy the value right now,
+    // so new entry is published with the whole value
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, see Append
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, new value is published as new entry,
+    // see Append
+    bool Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface, see Increment
+    bool Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) const override;
+
+    // Implements Afina::Storage interface. Entries waiting for readers to leave
+    // are not counted
+    MemoryStats Memory() const override;
+
+    // Implements Afina::Storage interface. Replaced entry is retired, not changed,
+    // so reference to it is taken without copying the value
+    ValueRef GetRef(const std::string &key) const override;
+
+    // Implements Afina::Storage interface, all keys are looked up in one epoch
+    size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values) const override;
+
+    // Implements Afina::Storage interface, same as MultiGet. Version of the
+    // published entry never changes, so it is read without locks too
+    size_t Gets(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                std::vector<uint64_t> &versions) const override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSet(const std::string &key, const std::string &value, uint64_t version,
+                            time_t expire = 0) override;
+
+    // Implements Afina::Storage interface, cursor is a slot of the index. Scan
+    // doesn't block writers
+    size_t Scan(size_t cursor, size_t count, std::vector<ScanItem> &items) const override;
+
+    // Number of entries waiting until readers leave them
+    size_t PendingReclaim() const;
+
+    // Removes at most max expired entries, returns number of removed ones
+    size_t Expire(size_t max = expire_batch);
+
+    // Number of expired entries reclaimed by each write operation
+    static const size_t expire_batch = 8;
+
+    // MultiGet prefetches index slots for keys that far ahead of the current one
+    static const size_t prefetch_distance = 8;
+
+private:
+    // Looks keys up in one epoch, versions are returned if not nullptr
+    size_t _MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                     std::vector<uint64_t> *versions) const;
+
+    // Finds live entry by the key, expired one is removed instead
+    Entry *_Find(const std::string &key, size_t hash, uint32_t now);
+
+    // Removes at most max entries expired by now
+    size_t _Expire(uint32_t now, size_t max);
+
+    // Creates new entry in the head of the list, entry must not exist yet
+    bool _Insert(const std::string &key, size_t hash, const std::string &value, uint32_t expire);
+
+    // Publishes new entry instead of the given one
+    bool _Update(Entry *entry, const std::string &value, uint32_t expire);
+
+    // Publishes new entry with data added before or after the value of existing key
+    bool _Extend(const std::string &key, const std::string &data, bool front);
+
+    // Publishes new entry with the counter changed by delta
+    bool _Count(const std::string &key, uint64_t delta, bool decrement, uint64_t &value);
+
+    // Unpublishes entry and retires it
+    void _Remove(Entry *entry);
+
+    // Number of bytes allocated for live entries, index and timers
+    size_t _Allocated() const { return _footprint + _index.MemoryUsage() + _timers.MemoryUsage(); }
+
+    // Removes entries from the tail until there is enough space for len more bytes
+    // of payload and bytes more of memory, referenced entries are moved to the head
+    // instead
+    void _Evict(size_t len, size_t bytes);
+
+    // List primitives
+    void _Unlink(Entry *entry);
+    void _PushFront(Entry *entry);
+
+    static void _Destroy(void *entry);
+
+    size_t _max_size;
+    size_t _memory_limit;
+
+    // Total number of bytes of keys and values
+    size_t _cur_size;
+
+    // Total number of bytes allocated for entry blocks
+    size_t _footprint;
+
+    // Version given to the last published entry
+    uint64_t _last_version;
+
+    std::mutex mutable mut;
+
+    // Must outlive index, since old tables of index are retired there
+    EpochManager mutable _epoch;
+    ConcurrentIndex<Entry> _index;
+
+    // Expiration of entries, owned by writers
+    TimerWheel _timers;
+
+    // LRU list, owned by writers
+    Entry *head;
+    Entry *tail;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MAP_BASED_EPOCH_IMPL_H
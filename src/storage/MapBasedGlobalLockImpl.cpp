@@ -1,181 +1,629 @@
 #include "MapBasedGlobalLockImpl.h"
 
-#include <iostream>
+#include <algorithm>
+#include <cstring>
 #include <mutex>
 
 namespace Afina {
 namespace Backend {
 
+// See MapBasedGlobalLockImpl.h
+MapBasedGlobalLockImpl::~MapBasedGlobalLockImpl() { _Clear(); }
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::_Clear() {
+    while (Entry *entry = _policy->Victim(nullptr)) {
+        _Remove(entry);
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::Put(const std::string &key, const std::string &value, time_t expire) {
+    // Value is compressed before the lock is taken
+    std::string packed;
+    if (_Pack(value, packed)) {
+        return _Put(key, packed, expire, true);
+    }
+    return _Put(key, value, expire, false);
+}
 
 // See MapBasedGlobalLockImpl.h
-bool MapBasedGlobalLockImpl::Put(const std::string &key, const std::string &value) {
-    mut.lock();
-    if (PutIfAbsent(key, value)) {
-        mut.unlock();
+bool MapBasedGlobalLockImpl::_Put(const std::string &key, const std::string &value, time_t expire, bool compressed) {
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    uint32_t deadline = TimerWheel::Deadline(expire);
+    size_t hash = _backend.Hash(key);
+    Entry *entry = _Find(key, hash, now);
+    if (deadline != 0 && deadline <= now) {
+        // Stored and expired right away
+        if (entry != nullptr) {
+            _Remove(entry);
+        }
         return true;
-    } else {
-        if (Set(key, value)) {
-            mut.unlock();
-            return true;
-        } else {
-            mut.unlock();
+    }
+
+    if (entry == nullptr) {
+        return _Insert(key, hash, value, deadline, compressed);
+    }
+    return _Update(entry, value, deadline, compressed);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::PutIfAbsent(const std::string &key, const std::string &value, time_t expire) {
+    std::string packed;
+    bool compressed = _Pack(value, packed);
+
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    uint32_t deadline = TimerWheel::Deadline(expire);
+    size_t hash = _backend.Hash(key);
+    if (_Find(key, hash, now) != nullptr) {
+        return false;
+    }
+    if (deadline != 0 && deadline <= now) {
+        return true;
+    }
+    return _Insert(key, hash, compressed ? packed : value, deadline, compressed);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::Set(const std::string &key, const std::string &value, time_t expire) {
+    std::string packed;
+    bool compressed = _Pack(value, packed);
+
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    uint32_t deadline = TimerWheel::Deadline(expire);
+    Entry *entry = _Find(key, _backend.Hash(key), now);
+    if (entry == nullptr) {
+        return false;
+    }
+    if (deadline != 0 && deadline <= now) {
+        _Remove(entry);
+        return true;
+    }
+    return _Update(entry, compressed ? packed : value, deadline, compressed);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::Delete(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    Entry *entry = _Find(key, _backend.Hash(key), now);
+    if (entry == nullptr) {
+        return false;
+    }
+    _Remove(entry);
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::Append(const std::string &key, const std::string &data) {
+    return _Extend(key, data, false);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::Prepend(const std::string &key, const std::string &data) {
+    return _Extend(key, data, true);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Count(key, delta, false, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Count(key, delta, true, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::Get(const std::string &key, std::string &value) const {
+    ValueRef packed;
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        size_t hash = _backend.Hash(key);
+
+        // Removal of the expired entry doesn't change what is visible, so it is fine
+        // for the const method
+        Entry *entry = const_cast<MapBasedGlobalLockImpl *>(this)->_Find(key, hash, TimerWheel::Now());
+        if (entry == nullptr) {
+            _policy->Miss(hash);
             return false;
         }
-    } 
+        _policy->Touch(entry);
+        if (!entry->_compressed) {
+            value.assign(entry->Value(), entry->_value_size);
+            return true;
+        }
+        packed = _Ref(entry);
+    }
+
+    Decompress(packed.data(), packed.size(), value);
+    return true;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool MapBasedGlobalLockImpl::PutIfAbsent(const std::string &key, const std::string &value) {
-    mut.lock();
-    size_t len;
-    len = key.size() + value.size();
-    // if key + val greater than storage then stop
-    if (len > _max_size) {
-        mut.unlock();
-        return false;
+ValueRef MapBasedGlobalLockImpl::GetRef(const std::string &key) const {
+    ValueRef packed;
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        size_t hash = _backend.Hash(key);
+
+        // See Get for why expired entries could be removed here
+        Entry *entry = const_cast<MapBasedGlobalLockImpl *>(this)->_Find(key, hash, TimerWheel::Now());
+        if (entry == nullptr) {
+            _policy->Miss(hash);
+            return ValueRef();
+        }
+        _policy->Touch(entry);
+        if (!entry->_compressed) {
+            return _Ref(entry);
+        }
+        packed = _Ref(entry);
+    }
+    return Decompress(packed.data(), packed.size());
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t MapBasedGlobalLockImpl::MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values) const {
+    return _MultiGet(keys, values, nullptr);
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t MapBasedGlobalLockImpl::Gets(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                                    std::vector<uint64_t> &versions) const {
+    versions.assign(keys.size(), 0);
+    return _MultiGet(keys, values, &versions);
+}
+
+// See MapBasedGlobalLockImpl.h
+CasResult MapBasedGlobalLockImpl::CompareAndSet(const std::string &key, const std::string &value, uint64_t version,
+                                                time_t expire) {
+    std::string packed;
+    bool compressed = _Pack(value, packed);
+
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    uint32_t deadline = TimerWheel::Deadline(expire);
+    Entry *entry = _Find(key, _backend.Hash(key), now);
+    if (entry == nullptr) {
+        return CasResult::NotFound;
     }
-    my_map::iterator got = _backend.find(key);
-    // if the key is not in the map then add new entry by that key 
-    if (got == _backend.end()) {
-        // if there's not enough space then pop tail element 
-        while (_max_size - _cur_size < len) {
-            Delete(tail->_key);
+    if (entry->_version != version) {
+        return CasResult::Exists;
+    }
+    if (deadline != 0 && deadline <= now) {
+        _Remove(entry);
+        return CasResult::Stored;
+    }
+    return _Update(entry, compressed ? packed : value, deadline, compressed) ? CasResult::Stored
+                                                                            : CasResult::NotStored;
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t MapBasedGlobalLockImpl::_MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                                         std::vector<uint64_t> *versions) const {
+    values.assign(keys.size(), ValueRef());
+
+    // Hashes don't depend on the storage state, so they are computed before the lock
+    std::vector<size_t> hashes(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = _backend.Hash(keys[i]);
+    }
+
+    // Compressed values are unpacked after the lock is released
+    std::vector<size_t> packed;
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        for (size_t i = 0; i < keys.size() && i < prefetch_distance; i++) {
+            _backend.Prefetch(hashes[i]);
         }
-        Entry *entry = new Entry(key, value, head, nullptr);
-        if (tail == nullptr) {
-            tail = entry;
+
+        // See Get for why expired entries could be removed here
+        MapBasedGlobalLockImpl *self = const_cast<MapBasedGlobalLockImpl *>(this);
+        uint32_t now = TimerWheel::Now();
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (i + prefetch_distance < keys.size()) {
+                _backend.Prefetch(hashes[i + prefetch_distance]);
+            }
+
+            Entry *entry = self->_Find(keys[i], hashes[i], now);
+            if (entry == nullptr) {
+                _policy->Miss(hashes[i]);
+                continue;
+            }
+            _policy->Touch(entry);
+            values[i] = _Ref(entry);
+            if (versions != nullptr) {
+                (*versions)[i] = entry->_version;
+            }
+            if (entry->_compressed) {
+                packed.push_back(i);
+            }
+            count++;
         }
-        head = entry;
-        if (head != tail) {
-            head->_next->_prev = head;
+    }
+
+    for (size_t i : packed) {
+        values[i] = Decompress(values[i].data(), values[i].size());
+    }
+    return count;
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t MapBasedGlobalLockImpl::Scan(size_t cursor, size_t count, std::vector<ScanItem> &items) const {
+    // Compressed values are unpacked after the lock is released
+    std::vector<size_t> packed;
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        uint32_t now = TimerWheel::Now();
+        cursor = _backend.Scan(cursor, count, [this, now, &items, &packed](Entry *entry) {
+            if (entry->Expired(now)) {
+                return;
+            }
+            if (entry->_compressed) {
+                packed.push_back(items.size());
+            }
+            items.push_back(ScanItem{entry->KeyString(), _Ref(entry), entry->_expire});
+        });
+    }
+
+    for (size_t i : packed) {
+        items[i].value = Decompress(items[i].value.data(), items[i].value.size());
+    }
+    return cursor;
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t MapBasedGlobalLockImpl::Expire(size_t max) {
+    std::lock_guard<std::mutex> lock(mut);
+    return _Expire(TimerWheel::Now(), max);
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t MapBasedGlobalLockImpl::Overhead() const {
+    std::lock_guard<std::mutex> lock(mut);
+    if (_backend.Size() == 0) {
+        return 0;
+    }
+    return (_Allocated() - _cur_size) / _backend.Size();
+}
+
+// See MapBasedGlobalLockImpl.h
+MemoryStats MapBasedGlobalLockImpl::Memory() const {
+    std::lock_guard<std::mutex> lock(mut);
+    MemoryStats stats;
+    stats.items = _backend.Size();
+    stats.payload = _cur_size;
+    stats.overhead = _Allocated() - _cur_size;
+    stats.limit = _memory_limit != 0 ? _memory_limit : _max_size;
+    return stats;
+}
+
+// See MapBasedGlobalLockImpl.h
+Entry *MapBasedGlobalLockImpl::_Find(const std::string &key, size_t hash, uint32_t now) {
+    Entry *entry = _backend.Find(key, hash);
+    if (entry != nullptr && entry->Expired(now)) {
+        _Remove(entry);
+        return nullptr;
+    }
+    return entry;
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t MapBasedGlobalLockImpl::_Expire(uint32_t now, size_t max) {
+    size_t removed = 0;
+    while (removed < max) {
+        Entry *entry = _timers.Next(now);
+        if (entry == nullptr) {
+            break;
         }
-        _backend.insert(std::pair<str_ref, Entry *>(entry->_key, entry));
-    } else {
-        mut.unlock();
+        _Remove(entry);
+        removed++;
+    }
+    return removed;
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::_SetExpire(Entry *entry, uint32_t expire) {
+    entry->_expire = expire;
+    _timers.Schedule(entry, expire);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::_Insert(const std::string &key, size_t hash, const std::string &value, uint32_t expire,
+                                     bool compressed) {
+    size_t len = key.size() + value.size();
+    size_t bytes = Entry::Footprint(len) + Entry::heap_header;
+    // if key + val greater than storage then stop
+    if (len > _max_size || len > Entry::max_size || (_memory_limit != 0 && bytes > _memory_limit)) {
+        return false;
+    }
+
+    // if there's not enough space then evict policy victims
+    _Evict(len, bytes);
+
+    Entry *entry = _NewEntry(key.data(), key.size(), hash, value.data(), value.size());
+    if (entry == nullptr) {
         return false;
     }
+    entry->_compressed = compressed;
+    entry->_version = ++_last_version;
+    _SetExpire(entry, expire);
+    _policy->Insert(entry);
+    _backend.Insert(hash, entry);
     _cur_size += len;
-    std::cout<<"HEAD:"<<head<<std::endl;
-    mut.unlock();
+    _footprint += _BlockSize(entry);
+
+    // Index could grow, so the limit is checked once more
+    _Evict(0, 0, entry);
     return true;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool MapBasedGlobalLockImpl::Set(const std::string &key, const std::string &value) {
-    mut.lock();
-    size_t len, last_value_len, key_len, value_len;
-    // more complex case when changes only the value length
-    key_len = key.size();
-    value_len = value.size();
-    len = key_len + value_len;
+bool MapBasedGlobalLockImpl::_Update(Entry *entry, const std::string &value, uint32_t expire, bool compressed) {
     // if key + val greater than storage then stop
-    if (len > _max_size) {
-        mut.unlock();
+    size_t len = entry->_key_size + value.size();
+    if (len > _max_size || len > Entry::max_size ||
+        (_memory_limit != 0 && Entry::Footprint(len) + Entry::heap_header > _memory_limit)) {
         return false;
     }
-    my_map::iterator got = _backend.find(key);
-    // if the key is already in map rewrite entry's value field
-    if (got != _backend.end()) {
-        std::cout<<"HEAD:"<<head<<std::endl;
-        // at first place the entry to the front
-        if (got->second != head) {
-            if (got->second == tail) {
-                got->second->_prev->_next = nullptr;
-                tail = got->second->_prev;
-            } else {
-                got->second->_next->_prev = got->second->_prev;
-                got->second->_prev->_next = got->second->_next;
-            }
-            got->second->_next = head;
-            head->_prev = got->second;
-            head = got->second;
-        }
-        last_value_len = got->second->_value.size();
-        // if there's not enough space for a new value then pop some entries
-        while (_max_size - _cur_size - last_value_len < value_len) {
-            Delete(tail->_key);
+
+    _policy->Touch(entry);
+
+    // value is updated in place while it fits into the block, doesn't leave too
+    // much of it unused and nobody references it, otherwise entry is replaced by
+    // the new block. Old block is freed only after the new one is allocated
+    bool reallocate = len > entry->_capacity || len < entry->_capacity / 2 ||
+                      entry->_refs.load(std::memory_order_acquire) != 1;
+    size_t last_value_len = entry->_value_size;
+    _Evict(value.size() > last_value_len ? value.size() - last_value_len : 0,
+           reallocate ? Entry::Footprint(len) + Entry::heap_header : 0, entry);
+
+    if (reallocate) {
+        Entry *replacement =
+            _NewEntry(entry->Key(), entry->_key_size, entry->_hash, value.data(), value.size(), entry);
+        if (replacement == nullptr) {
+            return false;
         }
-        got->second->_value = value;
-    } else {
-        mut.unlock();
-        return false;
+        _cur_size = _cur_size + value.size() - last_value_len;
+        _policy->Replace(entry, replacement);
+        _backend.Replace(entry->_hash, entry, replacement);
+        _timers.Replace(entry, replacement);
+        _footprint = _footprint + _BlockSize(replacement) - _BlockSize(entry);
+        _FreeEntry(entry);
+        replacement->_compressed = compressed;
+        replacement->_version = ++_last_version;
+        _SetExpire(replacement, expire);
+        return true;
     }
-    _cur_size += value_len - last_value_len;
-    mut.unlock();
+
+    std::memcpy(entry->Value(), value.data(), value.size());
+    entry->_value_size = value.size();
+    entry->_compressed = compressed;
+    entry->_version = ++_last_version;
+    _policy->Resize(entry, entry->_key_size + last_value_len);
+    _cur_size = _cur_size + value.size() - last_value_len;
+    _SetExpire(entry, expire);
     return true;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool MapBasedGlobalLockImpl::Delete(const std::string &key) {
-    mut.lock();
-    my_map::iterator got = _backend.find(key);
-    size_t len;
-    // if there's the key then remove
-    if (got != _backend.end()) {
-        len = key.size() + got->second->_value.size();
-        // in case when there's only one entry in list
-        if (head == tail) {
-            _backend.erase(got);
-            // safely free memory
-            delete got->second;
-            head = nullptr;
-            tail = nullptr;
-            _cur_size = 0;
-            mut.unlock();
-            return true;
-        }
-        if (got->second != head) {
-            got->second->_prev->_next = got->second->_next;
-        } else {
-            head = got->second->_next;
-            head->_prev = nullptr;
-        }
-        if (got->second != tail) {
-            got->second->_next->_prev = got->second->_prev;
-        } else {
-            tail = got->second->_prev;
-            tail->_next = nullptr;
+bool MapBasedGlobalLockImpl::_Extend(const std::string &key, const std::string &data, bool front) {
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    Entry *entry = _Find(key, _backend.Hash(key), now);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    if (entry->_compressed) {
+        // Compressed value can't grow in place, so it is packed once again
+        std::string value;
+        Decompress(entry->Value(), entry->_value_size, value);
+        value.insert(front ? 0 : value.size(), data);
+        std::string packed;
+        bool compressed = _Pack(value, packed);
+        return _Update(entry, compressed ? packed : value, entry->_expire, compressed);
+    }
+
+    size_t len = entry->_key_size + entry->_value_size + data.size();
+    if (len > _max_size || len > Entry::max_size ||
+        (_memory_limit != 0 && Entry::Footprint(len) + Entry::heap_header > _memory_limit)) {
+        return false;
+    }
+
+    _policy->Touch(entry);
+
+    // Value grows in place while it fits into the block and nobody references it.
+    // New heap block gets room for the value to grow by half, so a key that is
+    // appended to over and over is copied only a logarithmic number of times.
+    // Slab chunks are rounded up by size class already
+    bool reallocate = len > entry->_capacity || entry->_refs.load(std::memory_order_acquire) != 1;
+    size_t reserve = _slab == nullptr ? len + len / 2 : len;
+    if (reserve > _max_size || reserve > Entry::max_size ||
+        (_memory_limit != 0 && Entry::Footprint(reserve) + Entry::heap_header > _memory_limit)) {
+        reserve = len;
+    }
+    _Evict(data.size(), reallocate ? Entry::Footprint(reserve) + Entry::heap_header : 0, entry);
+
+    // Old value and data go into the block in the order they end up in the value
+    const char *first = front ? data.data() : entry->Value();
+    size_t first_size = front ? data.size() : entry->_value_size;
+    const char *second = front ? entry->Value() : data.data();
+    size_t second_size = front ? entry->_value_size : data.size();
+
+    if (reallocate) {
+        Entry *replacement =
+            _NewEntry(entry->Key(), entry->_key_size, entry->_hash, first, first_size, entry, reserve);
+        if (replacement == nullptr) {
+            return false;
         }
-        _backend.erase(got);
-        delete got->second;
+        std::memcpy(replacement->Value() + first_size, second, second_size);
+        replacement->_value_size += second_size;
+        replacement->_expire = entry->_expire;
+        replacement->_version = ++_last_version;
+
+        _cur_size += data.size();
+        _policy->Replace(entry, replacement);
+        _backend.Replace(entry->_hash, entry, replacement);
+        _timers.Replace(entry, replacement);
+        _footprint = _footprint + _BlockSize(replacement) - _BlockSize(entry);
+        _FreeEntry(entry);
+        return true;
+    }
+
+    size_t old_charge = entry->_key_size + entry->_value_size;
+    if (front) {
+        std::memmove(entry->Value() + data.size(), entry->Value(), entry->_value_size);
+        std::memcpy(entry->Value(), data.data(), data.size());
     } else {
-        mut.unlock();
+        std::memcpy(entry->Value() + entry->_value_size, data.data(), data.size());
+    }
+    entry->_value_size += data.size();
+    entry->_version = ++_last_version;
+    _policy->Resize(entry, old_charge);
+    _cur_size += data.size();
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::_Count(const std::string &key, uint64_t delta, bool decrement, uint64_t &value) {
+    std::lock_guard<std::mutex> lock(mut);
+    uint32_t now = TimerWheel::Now();
+    _Expire(now, expire_batch);
+
+    Entry *entry = _Find(key, _backend.Hash(key), now);
+    if (entry == nullptr) {
         return false;
     }
-    _cur_size -= len;
-    mut.unlock();
+
+    uint64_t counter;
+    bool number;
+    if (entry->_compressed) {
+        std::string current;
+        Decompress(entry->Value(), entry->_value_size, current);
+        number = ParseCounter(current.data(), current.size(), counter);
+    } else {
+        number = ParseCounter(entry->Value(), entry->_value_size, counter);
+    }
+    if (!number) {
+        throw std::invalid_argument("Value is not a number");
+    }
+    value = decrement ? counter - std::min(counter, delta) : counter + delta;
+
+    // Counter takes 20 digits at most, so the block fits it almost always
+    std::string digits = std::to_string(value);
+    size_t len = entry->_key_size + digits.size();
+    if (entry->_compressed || len > entry->_capacity || entry->_refs.load(std::memory_order_acquire) != 1) {
+        return _Update(entry, digits, entry->_expire, false);
+    }
+
+    _policy->Touch(entry);
+    if (digits.size() > entry->_value_size) {
+        _Evict(digits.size() - entry->_value_size, 0, entry);
+    }
+
+    size_t old_charge = entry->_key_size + entry->_value_size;
+    std::memcpy(entry->Value(), digits.data(), digits.size());
+    _cur_size = _cur_size + len - old_charge;
+    entry->_value_size = digits.size();
+    entry->_version = ++_last_version;
+    _policy->Resize(entry, old_charge);
     return true;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool MapBasedGlobalLockImpl::Get(const std::string &key, std::string &value) const {
-    mut.lock();
-    my_map::const_iterator got = _backend.find(key);
-    // if there's the key then place it to the front and write the value of entry to value parameter
-    if (got != _backend.end()) {
-        value = got->second->_value;
-        if (head == tail) {
-            mut.unlock();
-            return true;
-        }
-        if (got->second != head) {
-            if (got->second == tail) {
-                got->second->_prev->_next = nullptr;
-                tail = got->second->_prev;
-            } else {
-                got->second->_next->_prev = got->second->_prev;
-                got->second->_prev->_next = got->second->_next;
-            }
-            got->second->_next = head;
-            head->_prev = got->second;
-            head = got->second;
+void MapBasedGlobalLockImpl::_Remove(Entry *entry) {
+    _cur_size -= entry->_key_size + entry->_value_size;
+    _footprint -= _BlockSize(entry);
+    _policy->Remove(entry);
+    _backend.Erase(entry->_hash, entry);
+    _timers.Cancel(entry);
+    _FreeEntry(entry);
+}
+
+// See MapBasedGlobalLockImpl.h
+Entry *MapBasedGlobalLockImpl::_NewEntry(const char *key, size_t key_size, size_t hash, const char *value,
+                                         size_t value_size, Entry *keep, size_t reserve) {
+    if (_slab == nullptr) {
+        return Entry::Create(key, key_size, hash, value, value_size, reserve);
+    }
+
+    size_t need = Entry::Footprint(std::max(key_size + value_size, reserve));
+    if (_slab->chunk_size(need) == 0) {
+        return nullptr;
+    }
+
+    size_t size_class = _slab->size_class(need);
+    void *memory = _slab->try_alloc(need);
+    while (memory == nullptr) {
+        Entry *victim = _SlabVictim(size_class, keep);
+        if (victim == nullptr) {
+            return nullptr;
         }
+        _OnEvict(victim);
+        _Remove(victim);
+        memory = _slab->try_alloc(need);
+    }
+
+    // The whole chunk is available, so value could grow in place later
+    size_t capacity = _slab->chunk_size(need) - sizeof(Entry);
+    return Entry::Init(memory, capacity, key, key_size, hash, value, value_size);
+}
+
+// See MapBasedGlobalLockImpl.h
+ValueRef MapBasedGlobalLockImpl::_Ref(Entry *entry) const {
+    if (_slab == nullptr) {
+        return entry->Ref();
+    }
+    // Chunk can't outlive the storage, so the value is copied
+    return ValueRef::Copy(entry->Value(), entry->_value_size);
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::_FreeEntry(Entry *entry) {
+    if (_slab == nullptr) {
+        Entry::Unref(entry);
     } else {
-        mut.unlock();
-        return false;
+        _slab->free(entry);
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+Entry *MapBasedGlobalLockImpl::_SlabVictim(size_t size_class, Entry *keep) const {
+    // Evicting entry of the same class frees exactly the chunk needed, so policy
+    // is asked for such entry first. Empty slabs go back to the arena, so
+    // eventually any class gets memory
+    return _policy->Victim(keep, [this, size_class](const Entry *entry) {
+        return _slab->size_class(entry) == size_class;
+    });
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::_Evict(size_t len, size_t bytes, const Entry *keep) {
+    while (!_Fits(len, bytes)) {
+        Entry *victim = _policy->Victim(keep);
+        if (victim == nullptr) {
+            break;
+        }
+        _OnEvict(victim);
+        _Remove(victim);
     }
-    mut.unlock();
-    return true;
 }
 
 } // namespace Backend
@@ -1,71 +1,230 @@
 #ifndef AFINA_STORAGE_MAP_BASED_GLOBAL_LOCK_IMPL_H
 #define AFINA_STORAGE_MAP_BASED_GLOBAL_LOCK_IMPL_H
 
-#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
-#include <functional>
-#include <iostream>
+#include <vector>
 
 #include <afina/Storage.h>
+#include <afina/allocator/Slab.h>
+
+#include "Compression.h"
+#include "Entry.h"
+#include "EvictionPolicy.h"
+#include "HashIndex.h"
+#include "TimerWheel.h"
 
 namespace Afina {
 namespace Backend {
 
 /**
  * # Map based implementation with global lock
+ * Keys are indexed by the open addressing hash table, see HashIndex.h. Each item
+ * is a single memory block, see Entry.h. Order of eviction is decided by the
+ * policy, LRU by default, see EvictionPolicy.h
  *
+ * Values of at least the compression threshold are kept compressed, see
+ * Compression.h: compressed size is what counts against the limits, and value
+ * is unpacked by the reader after the lock is released.
  *
+ * Expired item is removed once it is looked up. Besides that every write operation
+ * reclaims a few expired items in order of their expiration time, see TimerWheel.h,
+ * so memory of items nobody asks for is freed without scanning the storage.
  */
-
 class MapBasedGlobalLockImpl : public Afina::Storage {
 public:
     MapBasedGlobalLockImpl(size_t max_size = 1024, size_t cur_size = 0)
-        : _max_size(max_size), _cur_size(cur_size), head(nullptr), tail(nullptr) {}
-    ~MapBasedGlobalLockImpl() {
-        for (my_map::iterator it = _backend.begin(); it != _backend.end(); it++) {
-            delete it->second;
-        }
+        : MapBasedGlobalLockImpl(max_size, EvictionPolicy::Create("lru", max_size)) {
+        _cur_size = cur_size;
     }
 
+    /**
+     * max_size limits bytes of keys and values, memory_limit limits all memory
+     * allocated for items including overhead, see Memory. Limit 0 means only
+     * max_size is checked
+     */
+    MapBasedGlobalLockImpl(size_t max_size, std::unique_ptr<EvictionPolicy> policy, size_t memory_limit = 0)
+        : _slab(nullptr), _max_size(max_size), _memory_limit(memory_limit), _compress_min(0), _cur_size(0),
+          _footprint(0), _last_version(0), _policy(std::move(policy)) {}
+    ~MapBasedGlobalLockImpl();
+
     // Implements Afina::Storage interface
-    bool Put(const std::string &key, const std::string &value) override;
+    bool Put(const std::string &key, const std::string &value, time_t expire = 0) override;
 
     // Implements Afina::Storage interface
-    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+    bool PutIfAbsent(const std::string &key, const std::string &value, time_t expire = 0) override;
 
     // Implements Afina::Storage interface
-    bool Set(const std::string &key, const std::string &value) override;
+    bool Set(const std::string &key, const std::string &value, time_t expire = 0) override;
 
     // Implements Afina::Storage interface
     bool Delete(const std::string &key) override;
 
+    // Implements Afina::Storage interface. Value grows in place while it fits
+    // into the block, see Entry.h
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, see Append
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface. Counter is rewritten in place while
+    // nobody references its value
+    bool Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface, see Increment
+    bool Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) const override;
 
+    // Implements Afina::Storage interface. Entries live in the heap are referenced
+    // directly, values of slab entries are copied
+    ValueRef GetRef(const std::string &key) const override;
+
+    // Implements Afina::Storage interface, all keys are looked up under one lock
+    size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values) const override;
+
+    // Implements Afina::Storage interface, same as MultiGet
+    size_t Gets(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                std::vector<uint64_t> &versions) const override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSet(const std::string &key, const std::string &value, uint64_t version,
+                            time_t expire = 0) override;
+
+    // Implements Afina::Storage interface, cursor is a slot of the hash index
+    size_t Scan(size_t cursor, size_t count, std::vector<ScanItem> &items) const override;
+
+    // Implements Afina::Storage interface
+    MemoryStats Memory() const override;
+
+    /**
+     * Average number of bytes each item costs in addition to its key and value:
+     * entry header, unused entry capacity and share of the hash index
+     */
+    size_t Overhead() const;
+
+    /**
+     * Removes at most max expired items, returns number of removed ones. Write
+     * operations reclaim expire_batch items each, so that is only needed to free
+     * memory of the storage nobody writes to
+     */
+    size_t Expire(size_t max = expire_batch);
+
+    /**
+     * Keeps values of at least min_value bytes compressed, 0 turns compression
+     * off, that is the default. Must be set before the storage is shared
+     */
+    void SetCompression(size_t min_value) { _compress_min = min_value; }
+
+    // Number of expired items reclaimed by each write operation
+    static const size_t expire_batch = 8;
+
+    // MultiGet prefetches index slots for keys that far ahead of the current one
+    static const size_t prefetch_distance = 8;
+
+protected:
+    // Removes all entries
+    void _Clear();
+
+    std::mutex mutable mut;
+
+    // Allocator for entries, heap is used if nullptr. Once allocator is out of
+    // memory, entries are evicted to free chunks
+    Allocator::Slab *_slab;
+
+    // Called under the lock right before entry is evicted to make space. Entries
+    // removed by delete, expiration or update are not passed here
+    virtual void _OnEvict(const Entry *entry) {}
+
+    // Stores value which is compressed already if compressed is set, see Put
+    bool _Put(const std::string &key, const std::string &value, time_t expire, bool compressed);
+
 private:
-    struct Entry;
-    using Entry = struct Entry {
-        std::string _key;
-        std::string _value;
-
-        struct Entry *_next;
-        struct Entry *_prev;
-
-        Entry(std::string key, std::string value, Entry *next = nullptr, Entry *prev = nullptr)
-            : _next(next), _prev(prev), _key(key), _value(value) {}
-        ~Entry() {}
-    };
-    using str = const std::string;
-    using str_ref = std::reference_wrapper<str>;
-    using my_map = std::map<str_ref, Entry *, std::less<str>>;
+    // Looks keys up under a single lock, versions are returned if not nullptr
+    size_t _MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                     std::vector<uint64_t> *versions) const;
+
+    // Finds live entry by the key, expired one is removed instead
+    Entry *_Find(const std::string &key, size_t hash, uint32_t now);
+
+    // Removes at most max entries expired by now
+    size_t _Expire(uint32_t now, size_t max);
+
+    // Number of bytes allocated for items: entry blocks, index and timers
+    size_t _Allocated() const { return _footprint + _backend.MemoryUsage() + _timers.MemoryUsage(); }
+
+    // Number of bytes entry block costs
+    size_t _BlockSize(const Entry *entry) const {
+        return _slab == nullptr ? entry->Footprint() + Entry::heap_header : entry->Footprint();
+    }
+
+    // Checks that len more bytes of payload and bytes more of memory fit into limits
+    bool _Fits(size_t len, size_t bytes) const {
+        return _max_size - _cur_size >= len && (_memory_limit == 0 || _Allocated() + bytes <= _memory_limit);
+    }
+
+    // Compresses value into packed if it is large enough and compresses well
+    bool _Pack(const std::string &value, std::string &packed) const {
+        return _compress_min != 0 && value.size() >= _compress_min && Compress(value.data(), value.size(), packed);
+    }
+
+    // Sets expiration time of the entry
+    void _SetExpire(Entry *entry, uint32_t expire);
+
+    // Allocates and fills new entry block. Returns nullptr if there is no memory even
+    // after eviction. Entry keep is never evicted. Block gets room for at least
+    // reserve bytes of key and value
+    Entry *_NewEntry(const char *key, size_t key_size, size_t hash, const char *value, size_t value_size,
+                     Entry *keep = nullptr, size_t reserve = 0);
+
+    // Returns reference to the entry value
+    ValueRef _Ref(Entry *entry) const;
+
+    // Releases entry block, heap one is freed once the last reference to it is gone
+    void _FreeEntry(Entry *entry);
+
+    // Finds entry to evict in order to free chunk of the given class
+    Entry *_SlabVictim(size_t size_class, Entry *keep) const;
+
+    // Creates new entry and passes it to the policy, entry must not exist yet
+    bool _Insert(const std::string &key, size_t hash, const std::string &value, uint32_t expire, bool compressed);
+
+    // Replaces value of the existing entry, that counts as access
+    bool _Update(Entry *entry, const std::string &value, uint32_t expire, bool compressed);
+
+    // Adds data before or after the value of existing key, expiration time is kept
+    bool _Extend(const std::string &key, const std::string &data, bool front);
+
+    // Adds delta to the counter or subtracts it, expiration time is kept
+    bool _Count(const std::string &key, uint64_t delta, bool decrement, uint64_t &value);
+
+    // Removes entry from the list and index and frees it
+    void _Remove(Entry *entry);
+
+    // Removes policy victims until there is enough space for len more bytes of
+    // payload and bytes more of memory, entry keep is never evicted
+    void _Evict(size_t len, size_t bytes, const Entry *keep = nullptr);
+
     size_t _max_size;
+    size_t _memory_limit;
+
+    // Values shorter than that are never compressed, 0 if compression is off
+    size_t _compress_min;
+
+    // Total number of bytes of keys and values
     size_t _cur_size;
-    my_map _backend;
-    Entry mutable *head;
-    Entry mutable *tail;
-    std::recursive_mutex mutable mut;
 
+    // Total number of bytes allocated for entry blocks
+    size_t _footprint;
+
+    // Version given to the last changed item
+    uint64_t _last_version;
+
+    HashIndex<Entry> _backend;
+    std::unique_ptr<EvictionPolicy> _policy;
+    TimerWheel _timers;
 };
 
 } // namespace Backend
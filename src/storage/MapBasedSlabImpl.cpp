@@ -0,0 +1,55 @@
+#include "MapBasedSlabImpl.h"
+
+#include <stdexcept>
+
+#include <sys/mman.h>
+
+namespace Afina {
+namespace Backend {
+
+// See MapBasedSlabImpl.h
+MapBasedSlabImpl::MapBasedSlabImpl(size_t max_size, const std::string &policy)
+    : MapBasedGlobalLockImpl(max_size, EvictionPolicy::Create(policy, max_size)), _arena(nullptr), _arena_size(max_size) {
+    if (max_size < min_arena_size) {
+        throw std::invalid_argument("Slab storage needs at least 64Kb of memory");
+    }
+
+    // Pages are reserved, but physical memory is used only once slab touches it
+    _arena = mmap(nullptr, _arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (_arena == MAP_FAILED) {
+        throw std::runtime_error("Failed to mmap slab arena");
+    }
+
+    _allocator.reset(new Allocator::Slab(_arena, _arena_size, _SlabSize(_arena_size)));
+    _slab = _allocator.get();
+}
+
+// See MapBasedSlabImpl.h
+MapBasedSlabImpl::~MapBasedSlabImpl() {
+    // Entries must go back to the allocator before arena is unmapped
+    _Clear();
+    _slab = nullptr;
+    _allocator.reset();
+    munmap(_arena, _arena_size);
+}
+
+// See MapBasedSlabImpl.h
+std::string MapBasedSlabImpl::Dump() const {
+    std::lock_guard<std::mutex> lock(mut);
+    return _allocator->dump();
+}
+
+// See MapBasedSlabImpl.h
+size_t MapBasedSlabImpl::_SlabSize(size_t arena_size) {
+    const size_t max_slab_size = 1 << 20;
+    const size_t min_slabs = 16;
+
+    size_t slab_size = max_slab_size;
+    while (slab_size * min_slabs > arena_size) {
+        slab_size /= 2;
+    }
+    return slab_size;
+}
+
+} // namespace Backend
+} // namespace Afina
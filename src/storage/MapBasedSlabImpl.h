@@ -0,0 +1,50 @@
+#ifndef AFINA_STORAGE_MAP_BASED_SLAB_IMPL_H
+#define AFINA_STORAGE_MAP_BASED_SLAB_IMPL_H
+
+#include <memory>
+#include <string>
+
+#include <afina/allocator/Slab.h>
+
+#include "MapBasedGlobalLockImpl.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Map based implementation on top of slab allocator
+ * Same as MapBasedGlobalLockImpl, but entries live in the single arena of
+ * max_size bytes mapped at start. Arena is split by the slab allocator, so the
+ * storage never touches more than max_size bytes for items and doesn't fragment
+ * the process heap.
+ *
+ * Once arena is full, entries are evicted in the policy order, preferring ones of
+ * the same size class as the new item.
+ */
+class MapBasedSlabImpl : public MapBasedGlobalLockImpl {
+public:
+    // Smallest arena that could be split into reasonable number of slabs
+    static const size_t min_arena_size = 64 * 1024;
+
+    MapBasedSlabImpl(size_t max_size = min_arena_size, const std::string &policy = "lru");
+    ~MapBasedSlabImpl();
+
+    /**
+     * Returns allocator state, see Allocator::Slab::dump
+     */
+    std::string Dump() const;
+
+private:
+    // Picks slab size for the arena: enough slabs for all size classes, but not
+    // bigger than 1Mb
+    static size_t _SlabSize(size_t arena_size);
+
+    void *_arena;
+    size_t _arena_size;
+    std::unique_ptr<Allocator::Slab> _allocator;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MAP_BASED_SLAB_IMPL_H
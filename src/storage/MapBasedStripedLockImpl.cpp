@@ -0,0 +1,176 @@
+#include "MapBasedStripedLockImpl.h"
+
+#include <functional>
+#include <stdexcept>
+
+namespace Afina {
+namespace Backend {
+
+// Shard is selected by the highest bits of the key hash, lower ones are left for
+// the per shard structures
+static const size_t shard_hash_bits = 16;
+
+// See MapBasedStripedLockImpl.h
+MapBasedStripedLockImpl::MapBasedStripedLockImpl(size_t max_size, size_t shards, const std::string &policy,
+                                                 size_t memory_limit) {
+    if (shards == 0 || (shards & (shards - 1)) != 0 || shards > (size_t(1) << shard_hash_bits)) {
+        throw std::invalid_argument("Number of shards must be a power of two not greater than 65536");
+    }
+
+    _mask = shards - 1;
+    _shards.reserve(shards);
+    for (size_t i = 0; i < shards; i++) {
+        _shards.emplace_back(new MapBasedGlobalLockImpl(
+            max_size / shards, EvictionPolicy::Create(policy, max_size / shards), memory_limit / shards));
+    }
+}
+
+// See MapBasedStripedLockImpl.h
+void MapBasedStripedLockImpl::SetCompression(size_t min_value) {
+    for (auto &shard : _shards) {
+        shard->SetCompression(min_value);
+    }
+}
+
+// See MapBasedStripedLockImpl.h
+size_t MapBasedStripedLockImpl::_ShardIndex(const std::string &key) const {
+    size_t hash = std::hash<std::string>()(key);
+    return (hash >> (sizeof(size_t) * 8 - shard_hash_bits)) & _mask;
+}
+
+// See MapBasedStripedLockImpl.h
+bool MapBasedStripedLockImpl::Put(const std::string &key, const std::string &value, time_t expire) {
+    return _Shard(key).Put(key, value, expire);
+}
+
+// See MapBasedStripedLockImpl.h
+bool MapBasedStripedLockImpl::PutIfAbsent(const std::string &key, const std::string &value, time_t expire) {
+    return _Shard(key).PutIfAbsent(key, value, expire);
+}
+
+// See MapBasedStripedLockImpl.h
+bool MapBasedStripedLockImpl::Set(const std::string &key, const std::string &value, time_t expire) {
+    return _Shard(key).Set(key, value, expire);
+}
+
+// See MapBasedStripedLockImpl.h
+bool MapBasedStripedLockImpl::Delete(const std::string &key) { return _Shard(key).Delete(key); }
+
+// See MapBasedStripedLockImpl.h
+bool MapBasedStripedLockImpl::Append(const std::string &key, const std::string &data) {
+    return _Shard(key).Append(key, data);
+}
+
+// See MapBasedStripedLockImpl.h
+bool MapBasedStripedLockImpl::Prepend(const std::string &key, const std::string &data) {
+    return _Shard(key).Prepend(key, data);
+}
+
+// See MapBasedStripedLockImpl.h
+bool MapBasedStripedLockImpl::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Shard(key).Increment(key, delta, value);
+}
+
+// See MapBasedStripedLockImpl.h
+bool MapBasedStripedLockImpl::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Shard(key).Decrement(key, delta, value);
+}
+
+// See MapBasedStripedLockImpl.h
+bool MapBasedStripedLockImpl::Get(const std::string &key, std::string &value) const {
+    return _Shard(key).Get(key, value);
+}
+
+// See MapBasedStripedLockImpl.h
+ValueRef MapBasedStripedLockImpl::GetRef(const std::string &key) const { return _Shard(key).GetRef(key); }
+
+// See MapBasedStripedLockImpl.h
+size_t MapBasedStripedLockImpl::MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values) const {
+    return _MultiGet(keys, values, nullptr);
+}
+
+// See MapBasedStripedLockImpl.h
+size_t MapBasedStripedLockImpl::Gets(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                                     std::vector<uint64_t> &versions) const {
+    versions.assign(keys.size(), 0);
+    return _MultiGet(keys, values, &versions);
+}
+
+// See MapBasedStripedLockImpl.h
+CasResult MapBasedStripedLockImpl::CompareAndSet(const std::string &key, const std::string &value, uint64_t version,
+                                                 time_t expire) {
+    return _Shard(key).CompareAndSet(key, value, version, expire);
+}
+
+// See MapBasedStripedLockImpl.h
+size_t MapBasedStripedLockImpl::_MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                                          std::vector<uint64_t> *versions) const {
+    values.assign(keys.size(), ValueRef());
+
+    // Positions of the keys grouped by shards
+    std::vector<std::vector<size_t>> positions(_shards.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        positions[_ShardIndex(keys[i])].push_back(i);
+    }
+
+    size_t count = 0;
+    std::vector<std::string> shard_keys;
+    std::vector<ValueRef> shard_values;
+    std::vector<uint64_t> shard_versions;
+    for (size_t shard = 0; shard < _shards.size(); shard++) {
+        if (positions[shard].empty()) {
+            continue;
+        }
+
+        shard_keys.clear();
+        for (size_t i : positions[shard]) {
+            shard_keys.push_back(keys[i]);
+        }
+        if (versions == nullptr) {
+            count += _shards[shard]->MultiGet(shard_keys, shard_values);
+        } else {
+            count += _shards[shard]->Gets(shard_keys, shard_values, shard_versions);
+        }
+        for (size_t j = 0; j < positions[shard].size(); j++) {
+            values[positions[shard][j]].swap(shard_values[j]);
+            if (versions != nullptr) {
+                (*versions)[positions[shard][j]] = shard_versions[j];
+            }
+        }
+    }
+    return count;
+}
+
+// See MapBasedStripedLockImpl.h
+size_t MapBasedStripedLockImpl::Scan(size_t cursor, size_t count, std::vector<ScanItem> &items) const {
+    const size_t shift = sizeof(size_t) * 8 - shard_hash_bits;
+    size_t shard = cursor >> shift;
+    size_t inner = cursor & ((size_t(1) << shift) - 1);
+    if (shard >= _shards.size()) {
+        return 0;
+    }
+
+    inner = _shards[shard]->Scan(inner, count, items);
+    if (inner == 0) {
+        // Shard is done, the next one starts from the beginning
+        shard++;
+        return shard < _shards.size() ? shard << shift : 0;
+    }
+    return (shard << shift) | inner;
+}
+
+// See MapBasedStripedLockImpl.h
+MemoryStats MapBasedStripedLockImpl::Memory() const {
+    MemoryStats stats = MemoryStats();
+    for (auto &shard : _shards) {
+        MemoryStats shard_stats = shard->Memory();
+        stats.items += shard_stats.items;
+        stats.payload += shard_stats.payload;
+        stats.overhead += shard_stats.overhead;
+        stats.limit += shard_stats.limit;
+    }
+    return stats;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,106 @@
+#ifndef AFINA_STORAGE_MAP_BASED_STRIPED_LOCK_IMPL_H
+#define AFINA_STORAGE_MAP_BASED_STRIPED_LOCK_IMPL_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "MapBasedGlobalLockImpl.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Map based implementation with striped locks
+ * Keys are hashed into a fixed number of independent shards. Each shard is a
+ * complete LRU storage with its own map, list, lock and byte budget, so
+ * operations on keys from different shards never contend.
+ *
+ * Budget of each shard is max_size / shards, so a single item bigger than
+ * one shard budget can't be stored even if it fits into max_size.
+ */
+class MapBasedStripedLockImpl : public Afina::Storage {
+public:
+    // Limits are split between shards evenly, see MapBasedGlobalLockImpl for their meaning
+    MapBasedStripedLockImpl(size_t max_size = 1024, size_t shards = 16, const std::string &policy = "lru",
+                            size_t memory_limit = 0);
+    ~MapBasedStripedLockImpl() {}
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) const override;
+
+    // Implements Afina::Storage interface
+    MemoryStats Memory() const override;
+
+    // Implements Afina::Storage interface
+    ValueRef GetRef(const std::string &key) const override;
+
+    // Implements Afina::Storage interface, keys are split by shards and each shard
+    // resolves its part of the batch at once
+    size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values) const override;
+
+    // Implements Afina::Storage interface, same as MultiGet. Each shard has its
+    // own version counter, that is fine since version is compared per item
+    size_t Gets(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                std::vector<uint64_t> &versions) const override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSet(const std::string &key, const std::string &value, uint64_t version,
+                            time_t expire = 0) override;
+
+    // Implements Afina::Storage interface, shards are scanned one by one. Upper
+    // bits of the cursor keep the shard, the rest is the cursor inside of it
+    size_t Scan(size_t cursor, size_t count, std::vector<ScanItem> &items) const override;
+
+    size_t ShardsCount() const { return _shards.size(); }
+
+    // Sets compression threshold of all shards, see MapBasedGlobalLockImpl
+    void SetCompression(size_t min_value);
+
+private:
+    // Splits keys by shards and resolves each part at once, versions are returned
+    // if not nullptr
+    size_t _MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                     std::vector<uint64_t> *versions) const;
+
+    // Returns index of the shard owning the given key
+    size_t _ShardIndex(const std::string &key) const;
+
+    // Returns shard owning the given key
+    MapBasedGlobalLockImpl &_Shard(const std::string &key) const { return *_shards[_ShardIndex(key)]; }
+
+    // Number of shards is always power of two, so mask selects shard from the hash
+    size_t _mask;
+    std::vector<std::unique_ptr<MapBasedGlobalLockImpl>> _shards;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MAP_BASED_STRIPED_LOCK_IMPL_H
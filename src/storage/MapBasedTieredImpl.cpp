@@ -0,0 +1,300 @@
+#include "MapBasedTieredImpl.h"
+
+#include <algorithm>
+
+namespace Afina {
+namespace Backend {
+
+// See MapBasedTieredImpl.h
+MapBasedTieredImpl::MapBasedTieredImpl(size_t max_size, const std::string &path, size_t spill_size,
+                                       const std::string &policy, size_t memory_limit, size_t min_value)
+    : MapBasedGlobalLockImpl(max_size, EvictionPolicy::Create(policy, max_size), memory_limit),
+      _log(path, spill_size,
+           [this](const char *key, size_t key_size, uint64_t position) {
+               // Record could be outdated already, index points to the latest one
+               auto it = _spilled.find(std::string(key, key_size));
+               if (it != _spilled.end() && it->second.position == position) {
+                   _Forget(it);
+               }
+           }),
+      _min_value(min_value), _spilled_keys(0) {}
+
+// See MapBasedTieredImpl.h
+MapBasedTieredImpl::~MapBasedTieredImpl() {}
+
+// See MapBasedTieredImpl.h
+bool MapBasedTieredImpl::Put(const std::string &key, const std::string &value, time_t expire) {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    if (!MapBasedGlobalLockImpl::Put(key, value, expire)) {
+        return false;
+    }
+
+    // Put could spill other items, so the key is looked up only after it
+    auto it = _spilled.find(key);
+    if (it != _spilled.end()) {
+        _Forget(it);
+    }
+    return true;
+}
+
+// See MapBasedTieredImpl.h
+bool MapBasedTieredImpl::PutIfAbsent(const std::string &key, const std::string &value, time_t expire) {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    if (_FindSpilled(key) != _spilled.end()) {
+        return false;
+    }
+    return MapBasedGlobalLockImpl::PutIfAbsent(key, value, expire);
+}
+
+// See MapBasedTieredImpl.h
+bool MapBasedTieredImpl::Set(const std::string &key, const std::string &value, time_t expire) {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    if (MapBasedGlobalLockImpl::Set(key, value, expire)) {
+        return true;
+    }
+    if (_FindSpilled(key) == _spilled.end() || !MapBasedGlobalLockImpl::Put(key, value, expire)) {
+        return false;
+    }
+
+    auto it = _spilled.find(key);
+    if (it != _spilled.end()) {
+        _Forget(it);
+    }
+    return true;
+}
+
+// See MapBasedTieredImpl.h
+bool MapBasedTieredImpl::Delete(const std::string &key) {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    if (MapBasedGlobalLockImpl::Delete(key)) {
+        return true;
+    }
+
+    auto it = _FindSpilled(key);
+    if (it == _spilled.end()) {
+        return false;
+    }
+    _Forget(it);
+    return true;
+}
+
+// See MapBasedTieredImpl.h
+bool MapBasedTieredImpl::Append(const std::string &key, const std::string &data) {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    auto it = _FindSpilled(key);
+    if (it != _spilled.end()) {
+        _Promote(it);
+    }
+    return MapBasedGlobalLockImpl::Append(key, data);
+}
+
+// See MapBasedTieredImpl.h
+bool MapBasedTieredImpl::Prepend(const std::string &key, const std::string &data) {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    auto it = _FindSpilled(key);
+    if (it != _spilled.end()) {
+        _Promote(it);
+    }
+    return MapBasedGlobalLockImpl::Prepend(key, data);
+}
+
+// See MapBasedTieredImpl.h
+bool MapBasedTieredImpl::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    auto it = _FindSpilled(key);
+    if (it != _spilled.end()) {
+        _Promote(it);
+    }
+    return MapBasedGlobalLockImpl::Increment(key, delta, value);
+}
+
+// See MapBasedTieredImpl.h
+bool MapBasedTieredImpl::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    auto it = _FindSpilled(key);
+    if (it != _spilled.end()) {
+        _Promote(it);
+    }
+    return MapBasedGlobalLockImpl::Decrement(key, delta, value);
+}
+
+// See MapBasedTieredImpl.h
+bool MapBasedTieredImpl::Get(const std::string &key, std::string &value) const {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+
+    // Promotion doesn't change what is visible, so it is fine for the const method
+    ValueRef ref = const_cast<MapBasedTieredImpl *>(this)->_Lookup(key);
+    if (!ref) {
+        return false;
+    }
+    value.assign(ref.data(), ref.size());
+    return true;
+}
+
+// See MapBasedTieredImpl.h
+ValueRef MapBasedTieredImpl::GetRef(const std::string &key) const {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    return const_cast<MapBasedTieredImpl *>(this)->_Lookup(key);
+}
+
+// See MapBasedTieredImpl.h
+size_t MapBasedTieredImpl::MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values) const {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    size_t count = MapBasedGlobalLockImpl::MultiGet(keys, values);
+    if (count == keys.size() || _spilled.empty()) {
+        return count;
+    }
+
+    // Batch is resolved in memory first, the rest is looked up one by one
+    MapBasedTieredImpl *self = const_cast<MapBasedTieredImpl *>(this);
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (!values[i]) {
+            values[i] = self->_Lookup(keys[i]);
+            count += values[i] ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+// See MapBasedTieredImpl.h
+size_t MapBasedTieredImpl::Gets(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                                std::vector<uint64_t> &versions) const {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    MapBasedTieredImpl *self = const_cast<MapBasedTieredImpl *>(this);
+    for (const std::string &key : keys) {
+        auto it = self->_FindSpilled(key);
+        if (it != _spilled.end()) {
+            self->_Promote(it);
+        }
+    }
+    return MapBasedGlobalLockImpl::Gets(keys, values, versions);
+}
+
+// See MapBasedTieredImpl.h
+CasResult MapBasedTieredImpl::CompareAndSet(const std::string &key, const std::string &value, uint64_t version,
+                                            time_t expire) {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    if (_FindSpilled(key) != _spilled.end()) {
+        return CasResult::Exists;
+    }
+    return MapBasedGlobalLockImpl::CompareAndSet(key, value, version, expire);
+}
+
+// See MapBasedTieredImpl.h
+size_t MapBasedTieredImpl::Scan(size_t cursor, size_t count, std::vector<ScanItem> &items) const {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    if ((cursor & scan_spilled) == 0) {
+        cursor = MapBasedGlobalLockImpl::Scan(cursor, count, items);
+        if (cursor != 0) {
+            return cursor;
+        }
+        cursor = scan_spilled | _log.Tail();
+    }
+
+    // Records dropped since the previous step are skipped
+    uint64_t position = _log.Skip(std::max<uint64_t>(cursor & ~scan_spilled, _log.Tail()));
+    uint32_t now = TimerWheel::Now();
+    for (size_t i = 0; i < count && position < _log.Head(); i++, position = _log.Next(position)) {
+        const SpillLog::Record *record = _log.Read(position);
+        std::string key(record->Key(), record->key_size);
+        auto it = _spilled.find(key);
+        if (it == _spilled.end() || it->second.position != position ||
+            (it->second.expire != 0 && it->second.expire <= now)) {
+            continue;
+        }
+        items.push_back(ScanItem{key, _Value(record), it->second.expire});
+    }
+    return position < _log.Head() ? (scan_spilled | position) : 0;
+}
+
+// See MapBasedTieredImpl.h
+MemoryStats MapBasedTieredImpl::Memory() const {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    MemoryStats stats = MapBasedGlobalLockImpl::Memory();
+    stats.items += _spilled.size();
+    stats.overhead += _spilled_keys + _spilled.size() * spilled_overhead + _spilled.bucket_count() * sizeof(void *);
+    return stats;
+}
+
+// See MapBasedTieredImpl.h
+size_t MapBasedTieredImpl::Spilled() const {
+    std::lock_guard<std::mutex> lock(_tier_mutex);
+    return _spilled.size();
+}
+
+// See MapBasedTieredImpl.h
+void MapBasedTieredImpl::_OnEvict(const Entry *entry) {
+    if (entry->_value_size < _min_value || !_log.Fits(entry->_key_size, entry->_value_size) ||
+        entry->Expired(TimerWheel::Now())) {
+        return;
+    }
+
+    // Append could drop old records, so index is changed only after it
+    uint64_t position = _log.Append(entry->Key(), entry->_key_size, entry->Value(), entry->_value_size,
+                                    entry->_expire, entry->_compressed ? spilled_compressed : 0);
+    auto result = _spilled.emplace(entry->KeyString(), SpilledItem{position, entry->_expire});
+    if (result.second) {
+        _spilled_keys += entry->_key_size;
+    } else {
+        result.first->second = SpilledItem{position, entry->_expire};
+    }
+}
+
+// See MapBasedTieredImpl.h
+MapBasedTieredImpl::SpillIndex::iterator MapBasedTieredImpl::_FindSpilled(const std::string &key) {
+    auto it = _spilled.find(key);
+    if (it != _spilled.end() && it->second.expire != 0 && it->second.expire <= TimerWheel::Now()) {
+        _Forget(it);
+        return _spilled.end();
+    }
+    return it;
+}
+
+// See MapBasedTieredImpl.h
+void MapBasedTieredImpl::_Forget(SpillIndex::iterator it) {
+    _spilled_keys -= it->first.size();
+    _spilled.erase(it);
+}
+
+// See MapBasedTieredImpl.h
+ValueRef MapBasedTieredImpl::_Promote(SpillIndex::iterator it) {
+    // Putting the item back could spill others and overwrite its record, so the
+    // value is copied out first
+    const SpillLog::Record *record = _log.Read(it->second.position);
+    std::string key = it->first;
+    std::string value(record->Value(), record->value_size);
+    bool compressed = (record->flags & spilled_compressed) != 0;
+    uint32_t expire = it->second.expire;
+    _Forget(it);
+
+    // Compressed value goes back as is, without another round of compression
+    if (_Put(key, value, expire, compressed)) {
+        ValueRef ref = MapBasedGlobalLockImpl::GetRef(key);
+        if (ref) {
+            return ref;
+        }
+    }
+    return compressed ? Decompress(value.data(), value.size()) : ValueRef::Copy(value);
+}
+
+// See MapBasedTieredImpl.h
+ValueRef MapBasedTieredImpl::_Value(const SpillLog::Record *record) {
+    if ((record->flags & spilled_compressed) != 0) {
+        return Decompress(record->Value(), record->value_size);
+    }
+    return ValueRef::Copy(record->Value(), record->value_size);
+}
+
+// See MapBasedTieredImpl.h
+ValueRef MapBasedTieredImpl::_Lookup(const std::string &key) {
+    ValueRef ref = MapBasedGlobalLockImpl::GetRef(key);
+    if (ref) {
+        return ref;
+    }
+
+    auto it = _FindSpilled(key);
+    return it == _spilled.end() ? ValueRef() : _Promote(it);
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,152 @@
+#ifndef AFINA_STORAGE_MAP_BASED_TIERED_IMPL_H
+#define AFINA_STORAGE_MAP_BASED_TIERED_IMPL_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MapBasedGlobalLockImpl.h"
+#include "SpillLog.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Map based implementation with values spilled to disk
+ * Same as MapBasedGlobalLockImpl for items in memory, but once the policy evicts
+ * item with a large value, the value is moved into the spill file instead of
+ * being dropped, see SpillLog.h. Key and position of the spilled value stay in
+ * memory, so lookup of the spilled item never touches disk and read of its value
+ * costs a single page fault. Small values are dropped as usual: their keys would
+ * take almost as much memory as they do.
+ *
+ * Compressed value is spilled as is and stays compressed once it is back.
+ *
+ * Spilled item that is read again moves back into memory, which could push other
+ * items out. Once the spill file is full, the oldest spilled values are dropped.
+ *
+ * All operations are serialized by the storage lock.
+ */
+class MapBasedTieredImpl : public MapBasedGlobalLockImpl {
+public:
+    /**
+     * max_size and memory_limit bound items in memory, see MapBasedGlobalLockImpl.
+     * Spill file of spill_size bytes is created at path, values of at least
+     * min_value bytes are moved there
+     */
+    MapBasedTieredImpl(size_t max_size, const std::string &path, size_t spill_size,
+                       const std::string &policy = "lru", size_t memory_limit = 0,
+                       size_t min_value = default_min_value);
+    ~MapBasedTieredImpl();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface, spilled item is moved back into memory
+    // first
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, see Append
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, see Append
+    bool Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface, see Append
+    bool Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) const override;
+
+    // Implements Afina::Storage interface
+    ValueRef GetRef(const std::string &key) const override;
+
+    // Implements Afina::Storage interface
+    size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values) const override;
+
+    // Implements Afina::Storage interface. Spilled items are moved back into
+    // memory first and get new versions then
+    size_t Gets(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                std::vector<uint64_t> &versions) const override;
+
+    // Implements Afina::Storage interface. Version of the spilled item is never
+    // the one read before it was spilled, so the call fails with Exists
+    CasResult CompareAndSet(const std::string &key, const std::string &value, uint64_t version,
+                            time_t expire = 0) override;
+
+    // Implements Afina::Storage interface. Items in memory are scanned first, then
+    // the spill file from the oldest record
+    size_t Scan(size_t cursor, size_t count, std::vector<ScanItem> &items) const override;
+
+    // Implements Afina::Storage interface. Spilled items are counted, their keys
+    // and index are overhead
+    MemoryStats Memory() const override;
+
+    // Number of items with the value in the spill file
+    size_t Spilled() const;
+
+    // Values shorter than that are never spilled by default
+    static const size_t default_min_value = 256;
+
+protected:
+    // Moves value of the large entry into the spill file
+    void _OnEvict(const Entry *entry) override;
+
+private:
+    // Position of the spilled value
+    struct SpilledItem {
+        uint64_t position;
+        uint32_t expire;
+    };
+
+    using SpillIndex = std::unordered_map<std::string, SpilledItem>;
+
+    // Approximate memory cost of an index node besides the key bytes
+    static const size_t spilled_overhead = sizeof(SpillIndex::value_type) + 2 * sizeof(void *);
+
+    // Flag of the spill record with the compressed value
+    static const uint32_t spilled_compressed = 1;
+
+    // Returns value of the spill record, unpacked if needed
+    static ValueRef _Value(const SpillLog::Record *record);
+
+    // Upper bit of the scan cursor is set while spill file is scanned
+    static const size_t scan_spilled = size_t(1) << (sizeof(size_t) * 8 - 1);
+
+    // Finds live spilled item by the key, expired one is removed instead
+    SpillIndex::iterator _FindSpilled(const std::string &key);
+
+    // Removes item from the spill index, its record stays until the file wraps
+    void _Forget(SpillIndex::iterator it);
+
+    // Moves spilled item back into memory and returns reference to its value
+    ValueRef _Promote(SpillIndex::iterator it);
+
+    // Looks key up in memory, then in the spill file
+    ValueRef _Lookup(const std::string &key);
+
+    mutable std::mutex _tier_mutex;
+    SpillLog _log;
+    size_t _min_value;
+
+    SpillIndex _spilled;
+
+    // Bytes of the keys of spilled items
+    size_t _spilled_keys;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MAP_BASED_TIERED_IMPL_H
@@ -0,0 +1,71 @@
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+// See MappedFile.h
+MappedFile::~MappedFile() {
+    if (_data != nullptr) {
+        munmap(_data, _size);
+    }
+}
+
+// See MappedFile.h
+bool MappedFile::Open(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return false;
+        }
+        throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error("Failed to open " + path + ": " + std::strerror(error));
+    }
+
+    _size = st.st_size;
+    if (_size != 0) {
+        void *data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            throw std::runtime_error("Failed to map " + path + ": " + std::strerror(error));
+        }
+        _data = data;
+        madvise(_data, _size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    return true;
+}
+
+// See MappedFile.h
+void SyncDirectory(const std::string &path) {
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open directory " + dir + ": " + std::strerror(errno));
+    }
+    if (fsync(fd) != 0) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error("Failed to sync directory " + dir + ": " + std::strerror(error));
+    }
+    close(fd);
+}
+
+} // namespace Backend
+} // namespace Afina
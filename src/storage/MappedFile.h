@@ -0,0 +1,46 @@
+#ifndef AFINA_STORAGE_MAPPED_FILE_H
+#define AFINA_STORAGE_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Read only mapping of the whole file
+ * Files written by storage are read sequentially once on start, so they are
+ * mapped instead of copied into buffers. Mapping is released by destructor
+ */
+class MappedFile {
+public:
+    MappedFile() : _data(nullptr), _size(0) {}
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * Maps file at the given path. Returns false if there is no such file,
+     * throws std::runtime_error on other errors
+     */
+    bool Open(const std::string &path);
+
+    const char *Data() const { return static_cast<const char *>(_data); }
+    size_t Size() const { return _size; }
+
+private:
+    void *_data;
+    size_t _size;
+};
+
+/**
+ * Syncs directory of the file at the given path, so the file renamed into it
+ * survives a crash. Throws std::runtime_error on errors
+ */
+void SyncDirectory(const std::string &path);
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MAPPED_FILE_H
@@ -0,0 +1,49 @@
+#include "SegmentedLRUPolicy.h"
+
+namespace Afina {
+namespace Backend {
+
+// See SegmentedLRUPolicy.h
+SegmentedLRUPolicy::SegmentedLRUPolicy(size_t max_size, double protected_share)
+    : _max_protected(size_t(max_size * protected_share)) {}
+
+// See SegmentedLRUPolicy.h
+void SegmentedLRUPolicy::Insert(Entry *entry) {
+    entry->_segment = probation;
+    _probation.PushFront(entry);
+}
+
+// See SegmentedLRUPolicy.h
+void SegmentedLRUPolicy::Touch(Entry *entry) {
+    if (entry->_segment == protection) {
+        _protected.MoveToFront(entry);
+        return;
+    }
+
+    _probation.Unlink(entry);
+    entry->_segment = protection;
+    _protected.PushFront(entry);
+    _Shrink();
+}
+
+// See SegmentedLRUPolicy.h
+void SegmentedLRUPolicy::Resize(Entry *entry, size_t old_charge) {
+    _List(entry).Resize(entry, old_charge);
+    if (entry->_segment == protection) {
+        _Shrink();
+    }
+}
+
+// See SegmentedLRUPolicy.h
+void SegmentedLRUPolicy::_Shrink() {
+    // The most recent protected entry always stays, even if it is bigger than limit
+    while (_protected.Bytes() > _max_protected && _protected.Count() > 1) {
+        Entry *entry = _protected.Tail();
+        _protected.Unlink(entry);
+        entry->_segment = probation;
+        _probation.PushFront(entry);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,67 @@
+#ifndef AFINA_STORAGE_SEGMENTED_LRU_POLICY_H
+#define AFINA_STORAGE_SEGMENTED_LRU_POLICY_H
+
+#include "EvictionPolicy.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Segmented LRU
+ * Two LRU lists: new entries get into probation one, entry accessed while in
+ * probation is promoted into protected one. Protected segment is limited by the
+ * share of capacity, its overflow is demoted back to the probation head. Victims
+ * are taken from probation first, so entries seen once are evicted before ones
+ * seen at least twice.
+ */
+class SegmentedLRUPolicy : public EvictionPolicy {
+public:
+    // Values of Entry::_segment
+    static const uint8_t probation = 0;
+    static const uint8_t protection = 1;
+
+    /**
+     * @param max_size storage capacity in bytes
+     * @param protected_share part of capacity protected segment could take
+     */
+    SegmentedLRUPolicy(size_t max_size, double protected_share = 0.8);
+
+    // Implements EvictionPolicy interface
+    void Insert(Entry *entry) override;
+
+    // Implements EvictionPolicy interface
+    void Touch(Entry *entry) override;
+
+    // Implements EvictionPolicy interface
+    void Remove(Entry *entry) override { _List(entry).Unlink(entry); }
+
+    // Implements EvictionPolicy interface
+    void Replace(Entry *old_entry, Entry *new_entry) override { _List(old_entry).Replace(old_entry, new_entry); }
+
+    // Implements EvictionPolicy interface
+    void Resize(Entry *entry, size_t old_charge) override;
+
+    // Implements EvictionPolicy interface
+    Entry *Victim(const Entry *keep, const Preference &prefer = nullptr) override {
+        return _Pick({&_probation, &_protected}, keep, prefer);
+    }
+
+    // Number of bytes in each segment
+    size_t ProbationBytes() const { return _probation.Bytes(); }
+    size_t ProtectedBytes() const { return _protected.Bytes(); }
+
+private:
+    EntryList &_List(const Entry *entry) { return entry->_segment == protection ? _protected : _probation; }
+
+    // Demotes protected entries while the segment is over its limit
+    void _Shrink();
+
+    size_t _max_protected;
+    EntryList _probation;
+    EntryList _protected;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SEGMENTED_LRU_POLICY_H
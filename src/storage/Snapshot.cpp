@@ -0,0 +1,253 @@
+#include "Snapshot.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+
+#include "Checksum.h"
+#include "MappedFile.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char magic[8] = {'A', 'F', 'I', 'N', 'A', 'S', 'N', 'P'};
+const uint32_t version = 1;
+const uint32_t footer_mark = UINT32_MAX;
+
+const size_t header_size = sizeof(magic) + 2 * sizeof(uint32_t);
+const size_t record_header_size = 3 * sizeof(uint32_t);
+const size_t footer_size = sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+std::runtime_error Error(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+// Buffered writer of the snapshot file that checksums records on the way
+class Writer {
+public:
+    explicit Writer(const std::string &path) : _path(path), _checksum(fnv_offset) {
+        _file = std::fopen(path.c_str(), "wb");
+        if (_file == nullptr) {
+            throw Error("Failed to create snapshot", path);
+        }
+        std::setvbuf(_file, nullptr, _IOFBF, 1 << 20);
+    }
+
+    ~Writer() {
+        if (_file != nullptr) {
+            std::fclose(_file);
+            unlink(_path.c_str());
+        }
+    }
+
+    void Raw(const void *data, size_t size) {
+        if (size != 0 && std::fwrite(data, 1, size, _file) != size) {
+            throw Error("Failed to write snapshot", _path);
+        }
+    }
+
+    void Record(const ScanItem &item) {
+        uint32_t header[3] = {static_cast<uint32_t>(item.key.size()), static_cast<uint32_t>(item.value.size()),
+                              static_cast<uint32_t>(item.expire)};
+        _Checksummed(header, sizeof(header));
+        _Checksummed(item.key.data(), item.key.size());
+        _Checksummed(item.value.data(), item.value.size());
+    }
+
+    uint64_t Checksum() const { return _checksum; }
+
+    // Makes file durable, after that it is not removed by destructor
+    void Close() {
+        if (std::fflush(_file) != 0 || fsync(fileno(_file)) != 0) {
+            throw Error("Failed to write snapshot", _path);
+        }
+        int result = std::fclose(_file);
+        _file = nullptr;
+        if (result != 0) {
+            unlink(_path.c_str());
+            throw Error("Failed to write snapshot", _path);
+        }
+    }
+
+private:
+    void _Checksummed(const void *data, size_t size) {
+        _checksum = Fnv(_checksum, static_cast<const char *>(data), size);
+        Raw(data, size);
+    }
+
+    std::string _path;
+    std::FILE *_file;
+    uint64_t _checksum;
+};
+
+template <typename T> T Read(const char *data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+} // namespace
+
+const size_t Snapshot::default_interval;
+const size_t Snapshot::scan_batch;
+
+// See Snapshot.h
+Snapshot::Snapshot(std::shared_ptr<Storage> storage, const std::string &path, std::chrono::seconds interval)
+    : _storage(std::move(storage)), _path(path), _interval(interval), _running(false) {}
+
+// See Snapshot.h
+Snapshot::~Snapshot() { Stop(); }
+
+// See Snapshot.h
+void Snapshot::Start() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running) {
+        return;
+    }
+    _running = true;
+    _thread = std::thread(&Snapshot::_Run, this);
+}
+
+// See Snapshot.h
+void Snapshot::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _stop_cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+// See Snapshot.h
+size_t Snapshot::Save(const Storage &storage, const std::string &path, size_t batch) {
+    std::string tmp_path = path + ".tmp";
+    Writer writer(tmp_path);
+
+    uint32_t header[2] = {version, 0};
+    writer.Raw(magic, sizeof(magic));
+    writer.Raw(header, sizeof(header));
+
+    // Each step holds storage for a short time, items are written outside of it
+    uint64_t records = 0;
+    std::vector<ScanItem> items;
+    size_t cursor = 0;
+    do {
+        items.clear();
+        cursor = storage.Scan(cursor, batch, items);
+        for (const ScanItem &item : items) {
+            writer.Record(item);
+            records++;
+        }
+    } while (cursor != 0);
+
+    uint64_t checksum = writer.Checksum();
+    writer.Raw(&footer_mark, sizeof(footer_mark));
+    writer.Raw(&records, sizeof(records));
+    writer.Raw(&checksum, sizeof(checksum));
+    writer.Close();
+
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        throw Error("Failed to replace snapshot", path);
+    }
+    SyncDirectory(path);
+    return records;
+}
+
+// See Snapshot.h
+size_t Snapshot::Load(Storage &storage, const std::string &path) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        return 0;
+    }
+
+    const char *data = file.Data();
+    size_t size = file.Size();
+    if (size < header_size + footer_size || std::memcmp(data, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a snapshot file: " + path);
+    }
+    if (Read<uint32_t>(data + sizeof(magic)) != version) {
+        throw std::runtime_error("Unsupported snapshot version: " + path);
+    }
+
+    // Whole file is checked first, so broken one doesn't leave storage half loaded
+    size_t end = size - footer_size;
+    uint64_t records = 0;
+    size_t pos = header_size;
+    while (pos < end) {
+        if (end - pos < record_header_size) {
+            break;
+        }
+        size_t len = size_t(Read<uint32_t>(data + pos)) + Read<uint32_t>(data + pos + sizeof(uint32_t));
+        if (end - pos - record_header_size < len) {
+            break;
+        }
+        pos += record_header_size + len;
+        records++;
+    }
+
+    if (pos != end || Read<uint32_t>(data + end) != footer_mark ||
+        Read<uint64_t>(data + end + sizeof(uint32_t)) != records ||
+        Read<uint64_t>(data + end + sizeof(uint32_t) + sizeof(uint64_t)) !=
+            Fnv(fnv_offset, data + header_size, end - header_size)) {
+        throw std::runtime_error("Snapshot file is broken: " + path);
+    }
+
+    time_t now = std::time(nullptr);
+    size_t loaded = 0;
+    std::string key, value;
+    for (pos = header_size; pos < end;) {
+        uint32_t key_size = Read<uint32_t>(data + pos);
+        uint32_t value_size = Read<uint32_t>(data + pos + sizeof(uint32_t));
+        time_t expire = Read<uint32_t>(data + pos + 2 * sizeof(uint32_t));
+        pos += record_header_size;
+
+        key.assign(data + pos, key_size);
+        value.assign(data + pos + key_size, value_size);
+        pos += key_size + value_size;
+
+        if (expire != 0 && expire <= now) {
+            continue;
+        }
+        if (storage.Put(key, value, expire)) {
+            loaded++;
+        }
+    }
+    return loaded;
+}
+
+// See Snapshot.h
+void Snapshot::_Run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    bool stop = false;
+    while (!stop) {
+        // Last snapshot is written once thread is asked to stop
+        _stop_cv.wait_for(lock, _interval, [this] { return !_running; });
+        stop = !_running;
+
+        // Snapshot is written without the lock, so Stop doesn't wait for it to be
+        // able to ask thread to exit
+        lock.unlock();
+        try {
+            size_t items = Save(*_storage, _path);
+            std::cout << "Snapshot of " << items << " items saved to " << _path << std::endl;
+        } catch (std::exception &e) {
+            std::cerr << "Snapshot failed: " << e.what() << std::endl;
+        }
+        lock.lock();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
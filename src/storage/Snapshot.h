@@ -0,0 +1,92 @@
+#ifndef AFINA_STORAGE_SNAPSHOT_H
+#define AFINA_STORAGE_SNAPSHOT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage snapshot on disk
+ * Keeps copy of the storage items in a binary file, so the server restarts with
+ * a warm cache. File is written by a background thread that walks the storage
+ * with Storage::Scan: each step holds storage lock for a small batch only and
+ * values are referenced, not copied, so there is no fork and no long pause.
+ * Items changed while snapshot is written could be missed or written twice,
+ * that is fine for a cache.
+ *
+ * File is a header followed by records and a footer:
+ *
+ *     header: "AFINASNP" <version:u32> <reserved:u32>
+ *     record: <key size:u32> <value size:u32> <expire:u32> <key> <value>
+ *     footer: <0xFFFFFFFF:u32> <records:u64> <checksum:u64>
+ *
+ * Numbers are in the host byte order, checksum is FNV-1a of all records. New
+ * snapshot is written aside and renamed over the old one, so the file is always
+ * either the old or the new snapshot. Directory is synced after the rename, so
+ * the new snapshot survives a crash once Save returns. Loader maps the file into
+ * memory and checks the whole file before the first item is stored.
+ */
+class Snapshot {
+public:
+    /**
+     * Snapshot of the storage into the file at path, written every interval and
+     * once more on Stop
+     */
+    Snapshot(std::shared_ptr<Storage> storage, const std::string &path,
+             std::chrono::seconds interval = std::chrono::seconds(default_interval));
+    ~Snapshot();
+
+    // Starts background thread writing snapshots
+    void Start();
+
+    // Stops background thread, last snapshot is written before it exits
+    void Stop();
+
+    /**
+     * Writes snapshot of the storage into the file, returns number of written
+     * items. Throws std::runtime_error on IO errors, old file is left untouched
+     */
+    static size_t Save(const Storage &storage, const std::string &path, size_t batch = scan_batch);
+
+    /**
+     * Puts items of the snapshot file into the storage, expired ones are skipped.
+     * Returns number of stored items, 0 if file doesn't exist. Throws
+     * std::runtime_error if file is broken, nothing is stored then
+     */
+    static size_t Load(Storage &storage, const std::string &path);
+
+    // Puts items of the snapshot file into the storage it is taken of
+    size_t Load() { return Load(*_storage, _path); }
+
+    // Seconds between snapshots written by the background thread
+    static const size_t default_interval = 60;
+
+    // Amount of work done by a single scan step, see Storage::Scan
+    static const size_t scan_batch = 256;
+
+private:
+    void _Run();
+
+    std::shared_ptr<Storage> _storage;
+    std::string _path;
+    std::chrono::seconds _interval;
+
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _stop_cv;
+    bool _running;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SNAPSHOT_H
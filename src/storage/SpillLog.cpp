@@ -0,0 +1,118 @@
+#include "SpillLog.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+// Key size of the record that marks the rest of the file as skipped
+static const uint32_t skip_mark = UINT32_MAX;
+
+// See SpillLog.h
+SpillLog::SpillLog(const std::string &path, size_t capacity, Drop drop)
+    : _data(nullptr), _capacity(capacity & ~size_t(7)), _drop(std::move(drop)), _head(0), _tail(0) {
+    if (_capacity < sizeof(Record)) {
+        throw std::invalid_argument("Spill file is too small");
+    }
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create spill file " + path + ": " + std::strerror(errno));
+    }
+    if (ftruncate(fd, _capacity) != 0) {
+        int error = errno;
+        close(fd);
+        unlink(path.c_str());
+        throw std::runtime_error("Failed to allocate spill file " + path + ": " + std::strerror(error));
+    }
+
+    void *data = mmap(nullptr, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+    unlink(path.c_str());
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Failed to map spill file " + path + ": " + std::strerror(error));
+    }
+
+    // Records are read one by one at random, so readahead would only waste IO
+    madvise(data, _capacity, MADV_RANDOM);
+    _data = static_cast<char *>(data);
+}
+
+// See SpillLog.h
+SpillLog::~SpillLog() { munmap(_data, _capacity); }
+
+// See SpillLog.h
+uint64_t SpillLog::Append(const char *key, size_t key_size, const char *value, size_t value_size, uint32_t expire,
+                          uint32_t flags) {
+    size_t size = _Size(key_size, value_size);
+
+    size_t rest = _capacity - _head % _capacity;
+    if (rest < size) {
+        // Record doesn't fit before the end of the file, the rest is skipped
+        while (_tail + _capacity < _head + rest) {
+            _DropTail();
+        }
+        if (rest >= sizeof(Record)) {
+            reinterpret_cast<Record *>(_data + _head % _capacity)->key_size = skip_mark;
+        }
+        _head += rest;
+    }
+
+    while (_tail + _capacity < _head + size) {
+        _DropTail();
+    }
+
+    uint64_t position = _head;
+    Record *record = reinterpret_cast<Record *>(_data + position % _capacity);
+    record->key_size = key_size;
+    record->value_size = value_size;
+    record->expire = expire;
+    record->flags = flags;
+    std::memcpy(record + 1, key, key_size);
+    std::memcpy(reinterpret_cast<char *>(record + 1) + key_size, value, value_size);
+    _head += size;
+    return position;
+}
+
+// See SpillLog.h
+uint64_t SpillLog::Next(uint64_t position) const {
+    const Record *record = Read(position);
+    return Skip(position + _Size(record->key_size, record->value_size));
+}
+
+// See SpillLog.h
+uint64_t SpillLog::Skip(uint64_t position) const {
+    if (position >= _head) {
+        return position;
+    }
+
+    size_t rest = _capacity - position % _capacity;
+    if (rest < sizeof(Record) || Read(position)->key_size == skip_mark) {
+        return position + rest;
+    }
+    return position;
+}
+
+// See SpillLog.h
+void SpillLog::_DropTail() {
+    uint64_t position = Skip(_tail);
+    if (position != _tail) {
+        // Skipped end of the file is free already
+        _tail = position;
+        return;
+    }
+
+    const Record *record = Read(position);
+    _drop(record->Key(), record->key_size, position);
+    _tail = position + _Size(record->key_size, record->value_size);
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,114 @@
+#ifndef AFINA_STORAGE_SPILL_LOG_H
+#define AFINA_STORAGE_SPILL_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Circular log of values on disk
+ * File of fixed size mapped into memory. Records are appended at the head and
+ * once the file is full the oldest ones are dropped from the tail to make room,
+ * so it is FIFO of records which never needs compaction. Owner keeps index of
+ * live records and is told about each dropped one.
+ *
+ * Record positions are offsets in the endless log, position modulo file size is
+ * the place in the file. Record never wraps around the end of the file: if it
+ * doesn't fit, the rest of the file is skipped.
+ *
+ * Each record is
+ *
+ *     <key size:u32> <value size:u32> <expire:u32> <flags:u32> <key> <value>
+ *
+ * aligned to 8 bytes. Flags are kept for the owner. Reading record costs a page
+ * fault if its pages are not in memory, that is the whole IO of the read.
+ *
+ * File is removed right after it is created, so it goes away with the process.
+ * Log is not thread safe.
+ */
+class SpillLog {
+public:
+    // Called for each record dropped from the tail with its key and position
+    using Drop = std::function<void(const char *key, size_t key_size, uint64_t position)>;
+
+    struct Record {
+        uint32_t key_size;
+        uint32_t value_size;
+        uint32_t expire;
+        uint32_t flags;
+
+        const char *Key() const { return reinterpret_cast<const char *>(this + 1); }
+        const char *Value() const { return Key() + key_size; }
+    };
+
+    /**
+     * Creates file of the given size at the path. Throws std::runtime_error if
+     * file can't be created or mapped
+     */
+    SpillLog(const std::string &path, size_t capacity, Drop drop);
+    ~SpillLog();
+
+    SpillLog(const SpillLog &) = delete;
+    SpillLog &operator=(const SpillLog &) = delete;
+
+    // Checks that record of the given key and value sizes could ever be appended
+    bool Fits(size_t key_size, size_t value_size) const { return _Size(key_size, value_size) <= _capacity; }
+
+    /**
+     * Appends record and returns its position. Old records are dropped if there
+     * is not enough space. Record must fit, see Fits
+     */
+    uint64_t Append(const char *key, size_t key_size, const char *value, size_t value_size, uint32_t expire,
+                    uint32_t flags = 0);
+
+    // Returns record at the given position, it must not be dropped yet
+    const Record *Read(uint64_t position) const {
+        return reinterpret_cast<const Record *>(_data + position % _capacity);
+    }
+
+    /**
+     * Returns position of the record that follows the given one, skipping the end
+     * of the file. Position of the oldest record is Tail
+     */
+    uint64_t Next(uint64_t position) const;
+
+    // Position of the oldest record
+    uint64_t Tail() const { return Skip(_tail); }
+
+    /**
+     * Returns position of the first record at or after the given one: moves
+     * position to the start of the file if there is no room for a record at its
+     * place, or the place is marked as skipped
+     */
+    uint64_t Skip(uint64_t position) const;
+
+    // Position the next record is appended at, no records are at or after it
+    uint64_t Head() const { return _head; }
+
+    size_t Capacity() const { return _capacity; }
+
+private:
+    // Number of bytes record takes in the file
+    static size_t _Size(size_t key_size, size_t value_size) {
+        return (sizeof(Record) + key_size + value_size + 7) & ~size_t(7);
+    }
+
+    // Drops the oldest record
+    void _DropTail();
+
+    char *_data;
+    size_t _capacity;
+    Drop _drop;
+
+    uint64_t _head;
+    uint64_t _tail;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SPILL_LOG_H
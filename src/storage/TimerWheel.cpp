@@ -0,0 +1,151 @@
+#include "TimerWheel.h"
+
+#include <cstring>
+
+namespace Afina {
+namespace Backend {
+
+// See TimerWheel.h
+TimerWheel::TimerWheel(uint32_t now) : _clock(now), _free(0), _size(0) { std::memset(_slots, 0, sizeof(_slots)); }
+
+// See TimerWheel.h
+void TimerWheel::Schedule(Entry *entry, uint32_t expire) {
+    if (expire == 0) {
+        Cancel(entry);
+        return;
+    }
+
+    uint32_t handle = entry->_timer;
+    if (handle != 0) {
+        _Unlink(handle);
+    } else if (_free != 0) {
+        handle = _free;
+        _free = _Node(handle).next;
+        _size++;
+    } else {
+        _nodes.emplace_back();
+        handle = _nodes.size();
+        _size++;
+    }
+
+    Node &node = _Node(handle);
+    node.entry = entry;
+    node.expire = expire;
+    entry->_timer = handle;
+    _Place(handle);
+}
+
+// See TimerWheel.h
+void TimerWheel::Cancel(Entry *entry) {
+    uint32_t handle = entry->_timer;
+    if (handle == 0) {
+        return;
+    }
+
+    _Unlink(handle);
+    Node &node = _Node(handle);
+    node.entry = nullptr;
+    node.next = _free;
+    _free = handle;
+    entry->_timer = 0;
+    _size--;
+}
+
+// See TimerWheel.h
+void TimerWheel::Replace(Entry *old_entry, Entry *new_entry) {
+    new_entry->_timer = old_entry->_timer;
+    if (new_entry->_timer != 0) {
+        _Node(new_entry->_timer).entry = new_entry;
+    }
+    old_entry->_timer = 0;
+}
+
+// See TimerWheel.h
+Entry *TimerWheel::Next(uint32_t now) {
+    while (true) {
+        // All timers in the current slot of the first level are due by the clock
+        uint32_t handle = _slots[_clock & (slots - 1)];
+        if (handle != 0) {
+            Entry *entry = _Node(handle).entry;
+            if (_Node(handle).expire > now) {
+                // Clock is ahead of the caller
+                return nullptr;
+            }
+            Cancel(entry);
+            return entry;
+        }
+
+        if (_clock >= now) {
+            return nullptr;
+        }
+        if (_size == 0) {
+            // Nothing to move down, so clock could jump right away
+            _clock = now;
+            return nullptr;
+        }
+        _Tick();
+    }
+}
+
+// See TimerWheel.h
+void TimerWheel::_Place(uint32_t handle) {
+    Node &node = _Node(handle);
+    uint32_t delta = node.expire > _clock ? node.expire - _clock : 0;
+    if (delta > max_delta) {
+        delta = max_delta;
+    }
+
+    size_t level = 0;
+    while (level + 1 < levels && delta >= (uint32_t(1) << (slot_bits * (level + 1)))) {
+        level++;
+    }
+
+    uint32_t when = _clock + delta;
+    node.slot = level * slots + ((when >> (slot_bits * level)) & (slots - 1));
+    node.prev = 0;
+    node.next = _slots[node.slot];
+    if (node.next != 0) {
+        _Node(node.next).prev = handle;
+    }
+    _slots[node.slot] = handle;
+}
+
+// See TimerWheel.h
+void TimerWheel::_Unlink(uint32_t handle) {
+    Node &node = _Node(handle);
+    if (node.prev != 0) {
+        _Node(node.prev).next = node.next;
+    } else {
+        _slots[node.slot] = node.next;
+    }
+    if (node.next != 0) {
+        _Node(node.next).prev = node.prev;
+    }
+}
+
+// See TimerWheel.h
+void TimerWheel::_Tick() {
+    _clock++;
+
+    // Once lower bits of the clock wrap, the next slot of the upper level starts
+    for (size_t level = 1; level < levels; level++) {
+        if ((_clock & ((uint32_t(1) << (slot_bits * level)) - 1)) != 0) {
+            break;
+        }
+        _Cascade(level * slots + ((_clock >> (slot_bits * level)) & (slots - 1)));
+    }
+}
+
+// See TimerWheel.h
+void TimerWheel::_Cascade(uint32_t slot) {
+    uint32_t handle = _slots[slot];
+    _slots[slot] = 0;
+    while (handle != 0) {
+        uint32_t next = _Node(handle).next;
+        _Place(handle);
+        handle = next;
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,121 @@
+#ifndef AFINA_STORAGE_TIMER_WHEEL_H
+#define AFINA_STORAGE_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+#include "Entry.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hierarchical timer wheel
+ * Tracks expiration time of entries with one second resolution. There are
+ * several levels of 64 slots each: slot of the first level covers one second,
+ * slot of the next level covers the whole previous level. Entry is put into the
+ * level that covers its expiration time, and once the clock passes into slot of
+ * upper level, entries of the slot are moved down to the exact position. So
+ * schedule, cancel and expire of an entry are O(1), and only entries that are
+ * due are ever looked at, the rest of the storage isn't scanned.
+ *
+ * Timers are kept outside of entries, entry stores handle of its timer only,
+ * so entries without expiration time cost nothing besides the handle.
+ *
+ * Wheel is not thread safe, storage calls it under its lock.
+ */
+class TimerWheel {
+public:
+    TimerWheel(uint32_t now = Now());
+
+    // Current unix time in seconds
+    static uint32_t Now() { return static_cast<uint32_t>(std::time(nullptr)); }
+
+    // Converts expiration time of the storage interface to the wheel one
+    static uint32_t Deadline(time_t expire) {
+        if (expire < 0) {
+            return 1;
+        }
+        return expire > time_t(UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(expire);
+    }
+
+    /**
+     * Sets expiration time of the entry, timer is rescheduled if entry has one
+     * already. Time 0 cancels the timer
+     */
+    void Schedule(Entry *entry, uint32_t expire);
+
+    // Removes timer of the entry if any
+    void Cancel(Entry *entry);
+
+    // Entry block is reallocated, timer of the old one moves to the new one
+    void Replace(Entry *old_entry, Entry *new_entry);
+
+    /**
+     * Returns entry which timer is due by the given time, or nullptr if there is
+     * no such entries. Timer of the returned entry is removed. Each call does
+     * O(1) work besides moving clock forward, so caller decides how many entries
+     * to reclaim at once
+     */
+    Entry *Next(uint32_t now);
+
+    // Number of scheduled timers
+    size_t Size() const { return _size; }
+
+    // Number of bytes used by the timers, slots of the wheel itself are not counted
+    size_t MemoryUsage() const { return _nodes.capacity() * sizeof(Node); }
+
+private:
+    static const size_t slot_bits = 6;
+    static const size_t slots = size_t(1) << slot_bits;
+    static const size_t levels = 4;
+
+    // Timers due later than this are parked in the last slot of the last level
+    static const uint32_t max_delta = (uint32_t(1) << (slot_bits * levels)) - 1;
+
+    struct Node {
+        Entry *entry;
+        uint32_t expire;
+
+        // Handles of the siblings in the slot
+        uint32_t next;
+        uint32_t prev;
+
+        // Index of the slot node belongs to
+        uint32_t slot;
+    };
+
+    Node &_Node(uint32_t handle) { return _nodes[handle - 1]; }
+
+    // Puts node into the slot according to its expiration time and current clock
+    void _Place(uint32_t handle);
+
+    // Unlinks node from its slot
+    void _Unlink(uint32_t handle);
+
+    // Moves clock forward by one second, slots of upper levels are moved down
+    // when clock enters them
+    void _Tick();
+
+    // Moves all nodes of the slot to the proper position for the current clock
+    void _Cascade(uint32_t slot);
+
+    // Time all timers before which are already fired
+    uint32_t _clock;
+
+    // Heads of the slot lists, level by level
+    uint32_t _slots[slots * levels];
+
+    // Storage of nodes, unused ones are linked by next starting from _free
+    std::vector<Node> _nodes;
+    uint32_t _free;
+
+    size_t _size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TIMER_WHEEL_H
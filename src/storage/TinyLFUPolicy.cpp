@@ -0,0 +1,159 @@
+#include "TinyLFUPolicy.h"
+
+#include <algorithm>
+
+namespace Afina {
+namespace Backend {
+
+// Odd multipliers give independent row indexes from the same hash
+static const uint64_t sketch_seeds[] = {0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL,
+                                        0xD6E8FEB86659FD93ULL};
+
+// See TinyLFUPolicy.h
+FrequencySketch::FrequencySketch(size_t width) : _mask(0), _records(0) { Resize(width); }
+
+// See TinyLFUPolicy.h
+void FrequencySketch::Resize(size_t width) {
+    size_t capacity = 1;
+    while (capacity < width) {
+        capacity *= 2;
+    }
+    _mask = capacity - 1;
+    _records = 0;
+    _counters.assign(capacity * rows, 0);
+}
+
+// See TinyLFUPolicy.h
+void FrequencySketch::Record(size_t hash) {
+    for (size_t row = 0; row < rows; row++) {
+        uint8_t &counter = _counters[_Index(hash, row)];
+        if (counter < max_count) {
+            counter++;
+        }
+    }
+    if (++_records >= 10 * Width()) {
+        _Age();
+    }
+}
+
+// See TinyLFUPolicy.h
+uint8_t FrequencySketch::Estimate(size_t hash) const {
+    uint8_t result = max_count;
+    for (size_t row = 0; row < rows; row++) {
+        result = std::min(result, _counters[_Index(hash, row)]);
+    }
+    return result;
+}
+
+size_t FrequencySketch::_Index(size_t hash, size_t row) const {
+    uint64_t x = uint64_t(hash) * sketch_seeds[row];
+    return size_t(x ^ (x >> 32)) & _mask;
+}
+
+void FrequencySketch::_Age() {
+    for (uint8_t &counter : _counters) {
+        counter /= 2;
+    }
+    _records /= 2;
+}
+
+// See TinyLFUPolicy.h
+TinyLFUPolicy::TinyLFUPolicy(size_t max_size, double window_share)
+    : _max_window(size_t(max_size * window_share)), _max_main(max_size - _max_window), _main(_max_main),
+      _main_count(0), _sketch(min_sketch_width) {}
+
+// See TinyLFUPolicy.h
+void TinyLFUPolicy::Insert(Entry *entry) {
+    _sketch.Record(entry->_hash);
+    entry->_segment = window;
+    _window.PushFront(entry);
+    _Drain();
+
+    // Sketch should have a few counters per entry to keep collisions rare
+    size_t count = _window.Count() + _main_count;
+    if (count * 2 > _sketch.Width() && _sketch.Width() < max_sketch_width) {
+        _sketch.Resize(_sketch.Width() * 2);
+    }
+}
+
+// See TinyLFUPolicy.h
+void TinyLFUPolicy::Touch(Entry *entry) {
+    _sketch.Record(entry->_hash);
+    if (entry->_segment == window) {
+        _window.MoveToFront(entry);
+    } else {
+        _main.Touch(entry);
+    }
+}
+
+// See TinyLFUPolicy.h
+void TinyLFUPolicy::Remove(Entry *entry) {
+    if (entry->_segment == window) {
+        _window.Unlink(entry);
+    } else {
+        _main.Remove(entry);
+        _main_count--;
+    }
+}
+
+// See TinyLFUPolicy.h
+void TinyLFUPolicy::Replace(Entry *old_entry, Entry *new_entry) {
+    if (old_entry->_segment == window) {
+        _window.Replace(old_entry, new_entry);
+    } else {
+        _main.Replace(old_entry, new_entry);
+    }
+}
+
+// See TinyLFUPolicy.h
+void TinyLFUPolicy::Resize(Entry *entry, size_t old_charge) {
+    if (entry->_segment == window) {
+        _window.Resize(entry, old_charge);
+    } else {
+        _main.Resize(entry, old_charge);
+    }
+}
+
+// See TinyLFUPolicy.h
+Entry *TinyLFUPolicy::Victim(const Entry *keep, const Preference &prefer) {
+    _Drain();
+
+    Entry *candidate = nullptr;
+    if (_window.Bytes() > _max_window) {
+        candidate = _Pick({&_window}, keep, nullptr);
+    }
+
+    Entry *victim = _main.Victim(keep, prefer);
+    if (candidate == nullptr) {
+        return victim != nullptr ? victim : _Pick({&_window}, keep, prefer);
+    }
+    if (victim == nullptr) {
+        return candidate;
+    }
+
+    // Admission: candidate replaces main victim only if it is more popular
+    if (_sketch.Estimate(candidate->_hash) > _sketch.Estimate(victim->_hash)) {
+        _Admit(candidate);
+        return victim;
+    }
+    return candidate;
+}
+
+void TinyLFUPolicy::_Drain() {
+    while (_window.Bytes() > _max_window) {
+        Entry *entry = _window.Tail();
+        if (_main.ProbationBytes() + _main.ProtectedBytes() + EntryList::Charge(entry) > _max_main) {
+            return;
+        }
+        _Admit(entry);
+    }
+}
+
+void TinyLFUPolicy::_Admit(Entry *entry) {
+    _window.Unlink(entry);
+    _main.Insert(entry);
+    _main_count++;
+}
+
+} // namespace Backend
+} // namespace Afina
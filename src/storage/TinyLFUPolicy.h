@@ -0,0 +1,105 @@
+#ifndef AFINA_STORAGE_TINY_LFU_POLICY_H
+#define AFINA_STORAGE_TINY_LFU_POLICY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "EvictionPolicy.h"
+#include "SegmentedLRUPolicy.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Frequency sketch
+ * Count-min sketch of 4 rows with saturating 8 bit counters. Estimates how many
+ * times the key hash was recorded recently: once number of records reaches
+ * 10 * width all counters are halved, so old popularity fades away.
+ */
+class FrequencySketch {
+public:
+    explicit FrequencySketch(size_t width);
+
+    void Record(size_t hash);
+    uint8_t Estimate(size_t hash) const;
+
+    // Rebuilds sketch with the new width, estimates are lost
+    void Resize(size_t width);
+    size_t Width() const { return _mask + 1; }
+
+private:
+    static const size_t rows = 4;
+    static const uint8_t max_count = 15;
+
+    size_t _Index(size_t hash, size_t row) const;
+    void _Age();
+
+    size_t _mask;
+    size_t _records;
+    std::vector<uint8_t> _counters;
+};
+
+/**
+ * # W-TinyLFU
+ * New entries get into the small LRU window first. Main part is segmented LRU
+ * which takes the rest of the capacity. Window overflow moves to the main part
+ * while there is space, once main part is full window victim competes with the
+ * main victim: candidate is admitted into main part
+ * only if the sketch says it is accessed more often, otherwise it is evicted
+ * itself. So one-hit wonders and scans pass through the window only.
+ */
+class TinyLFUPolicy : public EvictionPolicy {
+public:
+    // Value of Entry::_segment for the window entries
+    static const uint8_t window = 2;
+
+    /**
+     * @param max_size storage capacity in bytes
+     * @param window_share part of capacity window could take
+     */
+    TinyLFUPolicy(size_t max_size, double window_share = 0.01);
+
+    // Implements EvictionPolicy interface
+    void Insert(Entry *entry) override;
+
+    // Implements EvictionPolicy interface
+    void Touch(Entry *entry) override;
+
+    // Implements EvictionPolicy interface
+    void Miss(size_t hash) override { _sketch.Record(hash); }
+
+    // Implements EvictionPolicy interface
+    void Remove(Entry *entry) override;
+
+    // Implements EvictionPolicy interface
+    void Replace(Entry *old_entry, Entry *new_entry) override;
+
+    // Implements EvictionPolicy interface
+    void Resize(Entry *entry, size_t old_charge) override;
+
+    // Implements EvictionPolicy interface
+    Entry *Victim(const Entry *keep, const Preference &prefer = nullptr) override;
+
+private:
+    // Sketch width limits, it grows with number of entries
+    static const size_t min_sketch_width = 256;
+    static const size_t max_sketch_width = 1 << 22;
+
+    // Moves window overflow to the main part while it has free space
+    void _Drain();
+
+    // Moves entry from the window to the main part
+    void _Admit(Entry *entry);
+
+    size_t _max_window;
+    size_t _max_main;
+    EntryList _window;
+    SegmentedLRUPolicy _main;
+    size_t _main_count;
+    FrequencySketch _sketch;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TINY_LFU_POLICY_H
@@ -0,0 +1,378 @@
+#include "WriteAheadLog.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Checksum.h"
+#include "MappedFile.h"
+#include "Snapshot.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char magic[8] = {'A', 'F', 'I', 'N', 'A', 'W', 'A', 'L'};
+const uint32_t version = 1;
+
+const size_t header_size = sizeof(magic) + 2 * sizeof(uint32_t);
+const size_t record_header_size = 3 * sizeof(uint32_t) + sizeof(uint8_t);
+
+// Compaction writes file by chunks of about this size
+const size_t compact_chunk = 1 << 20;
+
+std::runtime_error Error(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+template <typename T> T Read(const char *data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+template <typename T> void AppendRaw(std::string &out, T value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void WriteAll(int fd, const char *data, size_t size, const std::string &path) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw Error("Failed to write log", path);
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+} // namespace
+
+// See WriteAheadLog.h
+WriteAheadLog::WriteAheadLog(std::shared_ptr<Storage> storage, const std::string &path, const std::string &snapshot)
+    : _storage(std::move(storage)), _path(path), _snapshot(snapshot), _fd(-1), _loaded(0), _replayed(0), _appended(0),
+      _durable(0), _syncing(false), _syncs(0) {}
+
+// See WriteAheadLog.h
+WriteAheadLog::~WriteAheadLog() {
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+// See WriteAheadLog.h
+void WriteAheadLog::Start() {
+    _storage->Start();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _loaded = 0;
+    if (!_snapshot.empty() && access(_path.c_str(), F_OK) != 0) {
+        _loaded = Snapshot::Load(*_storage, _snapshot);
+    }
+    _replayed = _Replay();
+    _Compact();
+
+    _fd = open(_path.c_str(), O_WRONLY | O_APPEND);
+    if (_fd < 0) {
+        throw Error("Failed to open log", _path);
+    }
+    _error.clear();
+    _syncs = 0;
+}
+
+// See WriteAheadLog.h
+void WriteAheadLog::Stop() {
+    {
+        // Waits for the running sync, all acknowledged records are on disk already
+        std::unique_lock<std::mutex> lock(_mutex);
+        _synced.wait(lock, [this] { return !_syncing; });
+        if (_fd >= 0) {
+            close(_fd);
+            _fd = -1;
+        }
+    }
+    _storage->Stop();
+}
+
+// See WriteAheadLog.h
+bool WriteAheadLog::Put(const std::string &key, const std::string &value, time_t expire) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_storage->Put(key, value, expire)) {
+        return false;
+    }
+    _Commit(_Append(Op::Put, key, value, expire), lock);
+    return true;
+}
+
+// See WriteAheadLog.h
+bool WriteAheadLog::PutIfAbsent(const std::string &key, const std::string &value, time_t expire) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_storage->PutIfAbsent(key, value, expire)) {
+        return false;
+    }
+    _Commit(_Append(Op::Put, key, value, expire), lock);
+    return true;
+}
+
+// See WriteAheadLog.h
+bool WriteAheadLog::Set(const std::string &key, const std::string &value, time_t expire) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_storage->Set(key, value, expire)) {
+        return false;
+    }
+
+    // Key exists at this point of the log, so replay of Put gives the same
+    _Commit(_Append(Op::Put, key, value, expire), lock);
+    return true;
+}
+
+// See WriteAheadLog.h
+bool WriteAheadLog::Delete(const std::string &key) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_storage->Delete(key)) {
+        return false;
+    }
+    _Commit(_Append(Op::Delete, key, std::string(), 0), lock);
+    return true;
+}
+
+// See WriteAheadLog.h
+bool WriteAheadLog::Append(const std::string &key, const std::string &data) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_storage->Append(key, data)) {
+        return false;
+    }
+    _Commit(_Append(Op::Append, key, data, 0), lock);
+    return true;
+}
+
+// See WriteAheadLog.h
+bool WriteAheadLog::Prepend(const std::string &key, const std::string &data) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_storage->Prepend(key, data)) {
+        return false;
+    }
+    _Commit(_Append(Op::Prepend, key, data, 0), lock);
+    return true;
+}
+
+// See WriteAheadLog.h
+bool WriteAheadLog::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_storage->Increment(key, delta, value)) {
+        return false;
+    }
+    _Commit(_Append(Op::Increment, key, std::to_string(delta), 0), lock);
+    return true;
+}
+
+// See WriteAheadLog.h
+bool WriteAheadLog::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_storage->Decrement(key, delta, value)) {
+        return false;
+    }
+    _Commit(_Append(Op::Decrement, key, std::to_string(delta), 0), lock);
+    return true;
+}
+
+// See WriteAheadLog.h
+CasResult WriteAheadLog::CompareAndSet(const std::string &key, const std::string &value, uint64_t version,
+                                       time_t expire) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    CasResult result = _storage->CompareAndSet(key, value, version, expire);
+    if (result == CasResult::Stored) {
+        _Commit(_Append(Op::Put, key, value, expire), lock);
+    }
+    return result;
+}
+
+// See WriteAheadLog.h
+size_t WriteAheadLog::Syncs() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _syncs;
+}
+
+// See WriteAheadLog.h
+void WriteAheadLog::_Encode(std::string &out, Op op, const std::string &key, const std::string &value,
+                            time_t expire) {
+    size_t start = out.size();
+    AppendRaw<uint32_t>(out, key.size());
+    AppendRaw<uint32_t>(out, value.size());
+    AppendRaw<uint32_t>(out, expire);
+    AppendRaw<uint8_t>(out, static_cast<uint8_t>(op));
+    out.append(key);
+    out.append(value);
+    AppendRaw<uint64_t>(out, Fnv(fnv_offset, out.data() + start, out.size() - start));
+}
+
+// See WriteAheadLog.h
+size_t WriteAheadLog::_Replay() {
+    MappedFile file;
+    if (!file.Open(_path)) {
+        return 0;
+    }
+
+    const char *data = file.Data();
+    size_t size = file.Size();
+    if (size < header_size || std::memcmp(data, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a log file: " + _path);
+    }
+    if (Read<uint32_t>(data + sizeof(magic)) != version) {
+        throw std::runtime_error("Unsupported log version: " + _path);
+    }
+
+    // Records are applied until the end of the file or the first broken one, that
+    // could only be the one torn by a crash
+    size_t records = 0;
+    std::string key, value;
+    for (size_t pos = header_size; size - pos >= record_header_size + sizeof(uint64_t);) {
+        size_t key_size = Read<uint32_t>(data + pos);
+        size_t value_size = Read<uint32_t>(data + pos + sizeof(uint32_t));
+        time_t expire = Read<uint32_t>(data + pos + 2 * sizeof(uint32_t));
+        uint8_t op = Read<uint8_t>(data + pos + 3 * sizeof(uint32_t));
+
+        size_t len = record_header_size + key_size + value_size;
+        if (size - pos - sizeof(uint64_t) < len ||
+            Read<uint64_t>(data + pos + len) != Fnv(fnv_offset, data + pos, len)) {
+            break;
+        }
+
+        key.assign(data + pos + record_header_size, key_size);
+        value.assign(data + pos + record_header_size + key_size, value_size);
+        if (op == static_cast<uint8_t>(Op::Put)) {
+            _storage->Put(key, value, expire);
+        } else if (op == static_cast<uint8_t>(Op::Delete)) {
+            _storage->Delete(key);
+        } else if (op == static_cast<uint8_t>(Op::Append)) {
+            _storage->Append(key, value);
+        } else if (op == static_cast<uint8_t>(Op::Prepend)) {
+            _storage->Prepend(key, value);
+        } else if (op == static_cast<uint8_t>(Op::Increment) || op == static_cast<uint8_t>(Op::Decrement)) {
+            // Value was a counter when the record was written, so it is one now
+            uint64_t delta, counter;
+            if (!ParseCounter(value.data(), value.size(), delta)) {
+                break;
+            }
+            if (op == static_cast<uint8_t>(Op::Increment)) {
+                _storage->Increment(key, delta, counter);
+            } else {
+                _storage->Decrement(key, delta, counter);
+            }
+        } else {
+            break;
+        }
+        pos += len + sizeof(uint64_t);
+        records++;
+    }
+    return records;
+}
+
+// See WriteAheadLog.h
+void WriteAheadLog::_Compact() {
+    std::string tmp_path = _path + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw Error("Failed to create log", tmp_path);
+    }
+
+    try {
+        std::string chunk(magic, sizeof(magic));
+        AppendRaw<uint32_t>(chunk, version);
+        AppendRaw<uint32_t>(chunk, 0);
+
+        std::vector<ScanItem> items;
+        size_t cursor = 0;
+        do {
+            items.clear();
+            cursor = _storage->Scan(cursor, compact_chunk / 1024, items);
+            for (const ScanItem &item : items) {
+                _Encode(chunk, Op::Put, item.key, item.value.str(), item.expire);
+            }
+            if (chunk.size() >= compact_chunk || cursor == 0) {
+                WriteAll(fd, chunk.data(), chunk.size(), tmp_path);
+                chunk.clear();
+            }
+        } while (cursor != 0);
+
+        if (fdatasync(fd) != 0) {
+            throw Error("Failed to sync log", tmp_path);
+        }
+    } catch (...) {
+        close(fd);
+        unlink(tmp_path.c_str());
+        throw;
+    }
+    close(fd);
+
+    if (std::rename(tmp_path.c_str(), _path.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        throw Error("Failed to replace log", _path);
+    }
+    SyncDirectory(_path);
+}
+
+// See WriteAheadLog.h
+uint64_t WriteAheadLog::_Append(Op op, const std::string &key, const std::string &value, time_t expire) {
+    _Encode(_pending, op, key, value, expire);
+    return ++_appended;
+}
+
+// See WriteAheadLog.h
+void WriteAheadLog::_Commit(uint64_t lsn, std::unique_lock<std::mutex> &lock) {
+    while (_durable < lsn) {
+        if (!_error.empty()) {
+            throw std::runtime_error(_error);
+        }
+        if (_syncing) {
+            _synced.wait(lock);
+            continue;
+        }
+
+        // Become the leader: everything queued so far goes with one sync, new
+        // records are queued for the next one meanwhile
+        _syncing = true;
+        std::string batch;
+        batch.swap(_pending);
+        uint64_t last = _appended;
+        lock.unlock();
+
+        std::string error;
+        try {
+            _Write(batch);
+        } catch (std::exception &e) {
+            error = e.what();
+        }
+
+        lock.lock();
+        _syncing = false;
+        if (error.empty()) {
+            _durable = last;
+            _syncs++;
+        } else {
+            _error = error;
+        }
+        _synced.notify_all();
+    }
+}
+
+// See WriteAheadLog.h
+void WriteAheadLog::_Write(const std::string &data) {
+    if (_fd < 0) {
+        throw std::logic_error("Log is not started");
+    }
+    WriteAll(_fd, data.data(), data.size(), _path);
+    if (fdatasync(_fd) != 0) {
+        throw Error("Failed to sync log", _path);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
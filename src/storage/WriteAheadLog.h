@@ -0,0 +1,180 @@
+#ifndef AFINA_STORAGE_WRITE_AHEAD_LOG_H
+#define AFINA_STORAGE_WRITE_AHEAD_LOG_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage decorator that logs changes ahead
+ * Every successful Put, PutIfAbsent, Set, Delete, Append, Prepend, Increment,
+ * Decrement and CompareAndSet is appended to the log file and call returns only
+ * once the record is on disk, so acknowledged changes survive a crash. Reads go
+ * to the decorated storage directly and could see changes that are not durable
+ * yet.
+ *
+ * Writes are group committed: change is applied and its record is queued under
+ * the log lock, then the first writer that finds no sync running becomes leader,
+ * writes all queued records with a single write and fdatasync, and wakes up the
+ * rest. Writers that arrive meanwhile queue their records for the next sync, so
+ * with many concurrent writers one fsync covers a whole batch. Once log write
+ * fails the change stays in memory, but the call and all later writes throw
+ * std::runtime_error until the next Start.
+ *
+ * On Start log is replayed into the decorated storage and compacted: it is
+ * rewritten with a single record per live item. Torn record at the end of the
+ * log left by a crash is dropped. So once log exists it is a full image of the
+ * storage, and snapshot given to the log is loaded only if there is no log yet.
+ * Snapshot loaded under a compacted log would bring back items deleted since it
+ * was written, their Delete records are gone. Each record is
+ *
+ *     <key size:u32> <value size:u32> <expire:u32> <op:u8> <key> <value> <checksum:u64>
+ *
+ * where checksum is FNV-1a of the rest of the record. Records of Append and
+ * Prepend keep only the added data, so their cost doesn't depend on the value
+ * size. Records of Increment and Decrement keep the delta in decimal. File
+ * starts with
+ * "AFINAWAL" <version:u32> <reserved:u32>
+ */
+class WriteAheadLog : public Storage {
+public:
+    /**
+     * Log of changes of the storage at path. If snapshot path is given, the
+     * storage starts from that snapshot as long as the log doesn't exist
+     */
+    WriteAheadLog(std::shared_ptr<Storage> storage, const std::string &path,
+                  const std::string &snapshot = std::string());
+    ~WriteAheadLog();
+
+    // Loads snapshot if there is no log, replays and compacts the log, then
+    // opens it for writes
+    void Start() override;
+
+    // Closes the log
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface, only the added data is logged
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, only the added data is logged
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface, only the delta is logged
+    bool Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface, only the delta is logged
+    bool Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) const override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    ValueRef GetRef(const std::string &key) const override { return _storage->GetRef(key); }
+
+    // Implements Afina::Storage interface
+    size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueRef> &values) const override {
+        return _storage->MultiGet(keys, values);
+    }
+
+    // Implements Afina::Storage interface. Versions are not logged, they start
+    // over once the log is replayed
+    size_t Gets(const std::vector<std::string> &keys, std::vector<ValueRef> &values,
+                std::vector<uint64_t> &versions) const override {
+        return _storage->Gets(keys, values, versions);
+    }
+
+    // Implements Afina::Storage interface, stored value is logged as Put
+    CasResult CompareAndSet(const std::string &key, const std::string &value, uint64_t version,
+                            time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    size_t Scan(size_t cursor, size_t count, std::vector<ScanItem> &items) const override {
+        return _storage->Scan(cursor, count, items);
+    }
+
+    // Implements Afina::Storage interface
+    MemoryStats Memory() const override { return _storage->Memory(); }
+
+    // Number of items loaded from the snapshot by the last Start
+    size_t Loaded() const { return _loaded; }
+
+    // Number of records replayed by the last Start
+    size_t Replayed() const { return _replayed; }
+
+    // Number of fdatasync calls done since Start
+    size_t Syncs() const;
+
+private:
+    enum class Op : uint8_t { Put = 1, Delete = 2, Append = 3, Prepend = 4, Increment = 5, Decrement = 6 };
+
+    // Appends encoded record to the buffer
+    static void _Encode(std::string &out, Op op, const std::string &key, const std::string &value, time_t expire);
+
+    // Applies records of the log to the decorated storage, returns their number
+    size_t _Replay();
+
+    // Rewrites log with a single record per live item of the storage
+    void _Compact();
+
+    /**
+     * Queues record of the change that is just applied, must be called under
+     * the log lock. Returns sequence number of the record
+     */
+    uint64_t _Append(Op op, const std::string &key, const std::string &value, time_t expire);
+
+    // Waits until record with the given number is durable, syncs the log itself
+    // if nobody else does
+    void _Commit(uint64_t lsn, std::unique_lock<std::mutex> &lock);
+
+    // Writes all the data to the log and syncs it
+    void _Write(const std::string &data);
+
+    std::shared_ptr<Storage> _storage;
+    std::string _path;
+    std::string _snapshot;
+    int _fd;
+    size_t _loaded;
+    size_t _replayed;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _synced;
+
+    // Records queued for the next sync
+    std::string _pending;
+
+    // Sequence number of the last queued and the last durable records
+    uint64_t _appended;
+    uint64_t _durable;
+
+    // True while leader writes the log
+    bool _syncing;
+    size_t _syncs;
+
+    // Set once write to the log fails, all later writes fail as well
+    std::string _error;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_WRITE_AHEAD_LOG_H
@@ -1,5 +1,7 @@
 #include "gtest/gtest.h"
+#include <chrono>
 #include <iostream>
+#include <random>
 #include <set>
 #include <vector>
 
@@ -322,3 +324,101 @@ TEST(SimpleTest, ReallocGrow) {
     a.free(p);
     a.free(p2);
 }
+
+TEST(SimpleTest, FreeInvalid) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p = a.alloc(100);
+    Pointer copy = p;
+    a.free(p);
+    EXPECT_EQ(p.get(), nullptr);
+
+    try {
+        a.free(copy);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+}
+
+// Random churn of blocks of different sizes until allocator can't serve a request,
+// then checks how much of the area was actually used and that defrag recovers it
+TEST(SimpleTest, FragmentationBench) {
+    Simple a(buf, sizeof(buf));
+    std::mt19937 rnd(42);
+    std::uniform_int_distribution<size_t> sizes(16, 1024);
+
+    vector<pair<Pointer, size_t>> live;
+    size_t live_bytes = 0, failed_size = 0;
+    for (int i = 0; i < 100000 && failed_size == 0; i++) {
+        // keep most of the area used, so holes appear all over it
+        if (live_bytes > sizeof(buf) * 3 / 4 && !live.empty()) {
+            size_t victim = rnd() % live.size();
+            live_bytes -= live[victim].second;
+            a.free(live[victim].first);
+            live[victim] = live.back();
+            live.pop_back();
+            continue;
+        }
+
+        size_t size = sizes(rnd);
+        try {
+            live.emplace_back(a.alloc(size), size);
+            writeTo(live.back().first, size);
+            live_bytes += size;
+        } catch (AllocError &) {
+            failed_size = size;
+        }
+    }
+
+    cout << "fragmentation: " << live.size() << " blocks, " << live_bytes << " of " << sizeof(buf)
+         << " bytes used" << (failed_size ? " when allocation failed" : "") << endl;
+
+    a.defrag();
+
+    for (auto &block : live) {
+        EXPECT_TRUE(isDataOk(block.first, block.second));
+    }
+
+    // after defrag the whole rest is contiguous
+    Pointer rest = a.alloc(sizeof(buf) / 8);
+    writeTo(rest, sizeof(buf) / 8);
+    a.free(rest);
+
+    for (auto &block : live) {
+        EXPECT_TRUE(isDataOk(block.first, block.second));
+        a.free(block.first);
+    }
+}
+
+TEST(SimpleTest, ThroughputBench) {
+    Simple a(buf, sizeof(buf));
+    std::mt19937 rnd(42);
+
+    const size_t n_blocks = 128, n_ops = 1000000;
+    vector<Pointer> ptrs(n_blocks);
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < n_ops; i++) {
+        Pointer &p = ptrs[rnd() % n_blocks];
+        if (p.get() != nullptr) {
+            a.free(p);
+        } else {
+            p = a.alloc(16 + rnd() % 240);
+        }
+    }
+    auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "alloc/free: " << size_t(n_ops / elapsed) << " ops/s" << endl;
+
+    start = chrono::steady_clock::now();
+    const size_t n_defrags = 1000;
+    for (size_t i = 0; i < n_defrags; i++) {
+        a.defrag();
+    }
+    elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "defrag: " << size_t(n_defrags / elapsed) << " ops/s" << endl;
+
+    for (Pointer &p : ptrs) {
+        a.free(p);
+    }
+}
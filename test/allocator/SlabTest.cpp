@@ -0,0 +1,129 @@
+#include "gtest/gtest.h"
+#include <set>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Slab.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+// 16 slabs of 4Kb
+static char arena[65536];
+const size_t slab_size = 4096;
+
+TEST(SlabTest, AllocInRange) {
+    Slab a(arena, sizeof(arena), slab_size);
+
+    size_t size = 500;
+    char *v = static_cast<char *>(a.alloc(size));
+
+    EXPECT_GE(v, arena);
+    EXPECT_LE(v + size, arena + sizeof(arena));
+    EXPECT_GE(a.chunk_size(size), size);
+
+    a.free(v);
+    EXPECT_EQ(0, a.used());
+}
+
+TEST(SlabTest, SizeClasses) {
+    Slab a(arena, sizeof(arena), slab_size);
+
+    EXPECT_EQ(64, a.chunk_size(1));
+    EXPECT_EQ(64, a.chunk_size(64));
+    EXPECT_LT(a.chunk_size(65), 65 * 1.25 + 8);
+    EXPECT_EQ(slab_size, a.chunk_size(slab_size));
+    EXPECT_EQ(0, a.chunk_size(slab_size + 1));
+
+    void *small = a.alloc(10);
+    void *big = a.alloc(1000);
+    EXPECT_EQ(a.size_class(10), a.size_class(small));
+    EXPECT_EQ(a.size_class(1000), a.size_class(big));
+    EXPECT_NE(a.size_class(small), a.size_class(big));
+
+    a.free(small);
+    a.free(big);
+}
+
+TEST(SlabTest, AllocReuse) {
+    Slab a(arena, sizeof(arena), slab_size);
+
+    vector<void *> ptrs;
+    for (int i = 0; i < 10; i++) {
+        ptrs.push_back(a.alloc(100));
+    }
+
+    void *freed = ptrs[3];
+    a.free(freed);
+    ptrs[3] = a.alloc(100);
+    EXPECT_EQ(freed, ptrs[3]);
+
+    set<void *> unique(ptrs.begin(), ptrs.end());
+    EXPECT_EQ(ptrs.size(), unique.size());
+
+    for (void *p : ptrs) {
+        a.free(p);
+    }
+}
+
+TEST(SlabTest, AllocNoMem) {
+    Slab a(arena, sizeof(arena), slab_size);
+
+    vector<void *> ptrs;
+    try {
+        for (size_t i = 0; i <= sizeof(arena) / slab_size; i++) {
+            ptrs.push_back(a.alloc(slab_size));
+        }
+
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::NoMemory);
+    }
+    EXPECT_EQ(nullptr, a.try_alloc(1));
+
+    for (void *p : ptrs) {
+        a.free(p);
+    }
+}
+
+TEST(SlabTest, InvalidFree) {
+    Slab a(arena, sizeof(arena), slab_size);
+    char *p = static_cast<char *>(a.alloc(100));
+
+    try {
+        a.free(p + 1);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+
+    char outside;
+    try {
+        a.free(&outside);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+
+    a.free(p);
+}
+
+TEST(SlabTest, SlabReturnsToArena) {
+    Slab a(arena, sizeof(arena), slab_size);
+    size_t total = a.free_slabs();
+
+    // fill the whole arena with small chunks
+    vector<void *> ptrs;
+    for (void *p = a.try_alloc(64); p != nullptr; p = a.try_alloc(64)) {
+        ptrs.push_back(p);
+    }
+    EXPECT_EQ(0, a.free_slabs());
+    EXPECT_EQ(a.capacity(), a.used());
+
+    // once small chunks are gone, memory could be used by other class
+    for (void *p : ptrs) {
+        a.free(p);
+    }
+    EXPECT_EQ(total, a.free_slabs());
+    EXPECT_NE(nullptr, a.try_alloc(slab_size));
+}
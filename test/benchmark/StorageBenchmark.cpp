@@ -0,0 +1,387 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include <afina/Storage.h>
+#include <afina/lockfree/applier.h>
+#include <storage/MapBasedEpochImpl.h>
+#include <storage/MapBasedGlobalLockImpl.h>
+#include <storage/MapBasedSlabImpl.h>
+#include <storage/MapBasedStripedLockImpl.h>
+#include <storage/MapBasedTieredImpl.h>
+
+/**
+ * # Storage benchmark
+ * Drives storage from 1, 2, 4 and so on up to the given number of threads. Storage
+ * is created and filled with all keys before each run, then every thread picks keys
+ * from the distribution and reads or writes them until time is out. Throughput and
+ * percentiles of a single operation latency are printed for each number of threads.
+ */
+
+namespace {
+
+/**
+ * # Latency histogram
+ * Values are grouped by their highest bit and each group is split into
+ * sub_buckets linear buckets, so percentile is off by 1/sub_buckets at most
+ * while the whole histogram takes a few kilobytes
+ */
+class Histogram {
+public:
+    static const size_t sub_bits = 4;
+    static const size_t sub_buckets = size_t(1) << sub_bits;
+
+    Histogram() : _counts((64 - sub_bits + 1) * sub_buckets, 0), _total(0) {}
+
+    void Add(uint64_t value) {
+        _counts[_Bucket(value)]++;
+        _total++;
+    }
+
+    void Merge(const Histogram &other) {
+        for (size_t i = 0; i < _counts.size(); i++) {
+            _counts[i] += other._counts[i];
+        }
+        _total += other._total;
+    }
+
+    uint64_t Count() const { return _total; }
+
+    // Value that fraction of samples don't exceed, 0 if there are no samples
+    uint64_t Percentile(double fraction) const {
+        uint64_t rank = std::max<uint64_t>(1, std::ceil(fraction * _total));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < _counts.size(); i++) {
+            seen += _counts[i];
+            if (seen >= rank) {
+                return _Upper(i);
+            }
+        }
+        return 0;
+    }
+
+private:
+    // Values below 2 * sub_buckets get a bucket each
+    static size_t _Bucket(uint64_t value) {
+        if (value < sub_buckets) {
+            return value;
+        }
+        size_t shift = 63 - __builtin_clzll(value) - sub_bits;
+        return ((shift + 1) << sub_bits) + ((value >> shift) & (sub_buckets - 1));
+    }
+
+    // Largest value of the bucket
+    static uint64_t _Upper(size_t bucket) {
+        if (bucket < 2 * sub_buckets) {
+            return bucket;
+        }
+        size_t shift = (bucket >> sub_bits) - 1;
+        uint64_t mantissa = (bucket & (sub_buckets - 1)) | sub_buckets;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    std::vector<uint64_t> _counts;
+    uint64_t _total;
+};
+
+/**
+ * # Zipfian key ranks
+ * Rank 0 is the most popular one. Ranks are generated in constant time by the
+ * method of Gray et al, "Quickly generating billion-record synthetic databases",
+ * as YCSB does; zeta is computed once in O(n)
+ */
+class Zipf {
+public:
+    Zipf(size_t n, double theta) : _n(n), _theta(theta) {
+        if (theta <= 0 || theta >= 1) {
+            throw std::invalid_argument("Zipf skew must be between 0 and 1");
+        }
+        _zetan = _Zeta(n, theta);
+        _alpha = 1 / (1 - theta);
+        _eta = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - _Zeta(2, theta) / _zetan);
+        _half = 1 + std::pow(0.5, theta);
+    }
+
+    size_t operator()(std::mt19937_64 &rng) {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        double uz = u * _zetan;
+        if (uz < 1) {
+            return 0;
+        }
+        if (uz < _half) {
+            return 1;
+        }
+        return std::min<size_t>(_n - 1, _n * std::pow(_eta * u - _eta + 1, _alpha));
+    }
+
+private:
+    static double _Zeta(size_t n, double theta) {
+        double sum = 0;
+        for (size_t i = 1; i <= n; i++) {
+            sum += 1 / std::pow(i, theta);
+        }
+        return sum;
+    }
+
+    size_t _n;
+    double _theta;
+    double _zetan;
+    double _alpha;
+    double _eta;
+    double _half;
+};
+
+// Parameters of the run
+struct Workload {
+    std::string storage;
+    std::string eviction;
+    size_t memory;
+    bool flat_combine;
+
+    size_t keys;
+    std::string distribution;
+    double skew;
+    size_t value_min;
+    size_t value_max;
+    size_t reads;
+    std::chrono::milliseconds duration;
+};
+
+// Result of the run
+struct Result {
+    Histogram latency;
+    uint64_t reads;
+    uint64_t hits;
+    double seconds;
+};
+
+// Number of distinct values written, sizes are spread between the bounds
+const size_t value_pool = 64;
+
+std::shared_ptr<Afina::Storage> CreateStorage(const Workload &workload) {
+    using namespace Afina::Backend;
+
+    std::shared_ptr<Afina::Storage> storage;
+    if (workload.storage == "map_global") {
+        storage = std::make_shared<MapBasedGlobalLockImpl>(
+            workload.memory, EvictionPolicy::Create(workload.eviction, workload.memory), workload.memory);
+    } else if (workload.storage == "striped_lru") {
+        storage = std::make_shared<MapBasedStripedLockImpl>(workload.memory, 16, workload.eviction, workload.memory);
+    } else if (workload.storage == "map_slab") {
+        storage = std::make_shared<MapBasedSlabImpl>(workload.memory, workload.eviction);
+    } else if (workload.storage == "epoch_lru") {
+        storage = std::make_shared<MapBasedEpochImpl>(workload.memory, workload.memory);
+    } else if (workload.storage == "map_tiered") {
+        storage = std::make_shared<MapBasedTieredImpl>(workload.memory, "afina_benchmark.spill", workload.memory,
+                                                       workload.eviction, workload.memory);
+    } else {
+        throw std::runtime_error("Unknown storage type");
+    }
+
+    if (workload.flat_combine) {
+        storage = std::make_shared<Afina::LockFree::Applier>(storage);
+    }
+    return storage;
+}
+
+Result Run(const Workload &workload, size_t n_threads) {
+    std::shared_ptr<Afina::Storage> storage = CreateStorage(workload);
+    storage->Start();
+
+    std::vector<std::string> keys(workload.keys);
+    for (size_t i = 0; i < keys.size(); i++) {
+        keys[i] = "key_" + std::to_string(i);
+    }
+
+    std::mt19937_64 seed_rng(42);
+    std::vector<std::string> values(value_pool);
+    for (auto &value : values) {
+        size_t size = std::uniform_int_distribution<size_t>(workload.value_min, workload.value_max)(seed_rng);
+        value.assign(size, 'a' + seed_rng() % 26);
+    }
+    for (size_t i = 0; i < keys.size(); i++) {
+        storage->Put(keys[i], values[i % values.size()]);
+    }
+
+    std::atomic<bool> started(false);
+    std::atomic<bool> stopped(false);
+    std::vector<Result> results(n_threads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < n_threads; t++) {
+        threads.emplace_back([&, t]() {
+            std::mt19937_64 rng(t + 1);
+            std::uniform_int_distribution<size_t> uniform(0, workload.keys - 1);
+            std::uniform_int_distribution<size_t> percent(0, 99);
+            std::unique_ptr<Zipf> zipf;
+            if (workload.distribution == "zipf") {
+                zipf.reset(new Zipf(workload.keys, workload.skew));
+            }
+
+            Result &result = results[t];
+            result.reads = 0;
+            result.hits = 0;
+            std::string value;
+            while (!started.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+
+            while (!stopped.load(std::memory_order_relaxed)) {
+                const std::string &key = keys[zipf ? (*zipf)(rng) : uniform(rng)];
+                bool read = percent(rng) < workload.reads;
+
+                auto start = std::chrono::steady_clock::now();
+                if (read) {
+                    result.hits += storage->Get(key, value) ? 1 : 0;
+                } else {
+                    storage->Put(key, values[rng() % values.size()]);
+                }
+                auto elapsed = std::chrono::steady_clock::now() - start;
+
+                result.latency.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+                result.reads += read ? 1 : 0;
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    started.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(workload.duration);
+    stopped.store(true, std::memory_order_relaxed);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    Result total;
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    total.reads = 0;
+    total.hits = 0;
+    for (auto &result : results) {
+        total.latency.Merge(result.latency);
+        total.reads += result.reads;
+        total.hits += result.hits;
+    }
+
+    storage->Stop();
+    return total;
+}
+
+// Thread counts of the runs: powers of two below max and max itself
+std::vector<size_t> ThreadCounts(size_t max) {
+    std::vector<size_t> counts;
+    for (size_t n = 1; n < max; n *= 2) {
+        counts.push_back(n);
+    }
+    counts.push_back(max);
+    return counts;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("runStorageBenchmark", "Storage throughput and latency benchmark");
+    try {
+        options.add_options()("s,storage", "map_global, striped_lru, map_slab, epoch_lru or map_tiered",
+                              cxxopts::value<std::string>()->default_value("map_global"));
+        options.add_options()("e,eviction", "Eviction policy: lru, clock, slru or tinylfu",
+                              cxxopts::value<std::string>()->default_value("lru"));
+        options.add_options()("m,memory", "Memory limit of the storage in megabytes",
+                              cxxopts::value<size_t>()->default_value("256"));
+        options.add_options()("f,flat-combine", "Apply storage operations in batches by flat combining");
+        std::string cores = std::to_string(std::thread::hardware_concurrency());
+        options.add_options()("t,threads", "Maximum number of threads", cxxopts::value<size_t>()->default_value(cores));
+        options.add_options()("k,keys", "Number of keys", cxxopts::value<size_t>()->default_value("100000"));
+        options.add_options()("d,distribution", "Key distribution: uniform or zipf",
+                              cxxopts::value<std::string>()->default_value("zipf"));
+        options.add_options()("skew", "Skew of the zipf distribution, between 0 and 1",
+                              cxxopts::value<double>()->default_value("0.99"));
+        options.add_options()("value-size", "Value size in bytes", cxxopts::value<size_t>()->default_value("100"));
+        options.add_options()("value-max", "Values sizes are spread up to that many bytes",
+                              cxxopts::value<size_t>());
+        options.add_options()("r,reads", "Percent of reads, the rest are writes",
+                              cxxopts::value<size_t>()->default_value("90"));
+        options.add_options()("duration", "Duration of the run for each number of threads in milliseconds",
+                              cxxopts::value<size_t>()->default_value("2000"));
+        options.add_options()("h,help", "Print usage info");
+        options.parse(argc, argv);
+
+        if (options.count("help") > 0) {
+            std::cerr << options.help() << std::endl;
+            return 0;
+        }
+    } catch (cxxopts::OptionParseException &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    Workload workload;
+    workload.storage = options["storage"].as<std::string>();
+    workload.eviction = options["eviction"].as<std::string>();
+    workload.memory = options["memory"].as<size_t>() * 1024 * 1024;
+    workload.flat_combine = options.count("flat-combine") > 0;
+    workload.keys = std::max<size_t>(2, options["keys"].as<size_t>());
+    workload.distribution = options["distribution"].as<std::string>();
+    workload.skew = options["skew"].as<double>();
+    workload.value_min = options["value-size"].as<size_t>();
+    workload.value_max = options.count("value-max") > 0 ? options["value-max"].as<size_t>() : workload.value_min;
+    workload.reads = std::min<size_t>(100, options["reads"].as<size_t>());
+    workload.duration = std::chrono::milliseconds(options["duration"].as<size_t>());
+
+    if (workload.distribution != "uniform" && workload.distribution != "zipf") {
+        std::cerr << "Error: unknown key distribution " << workload.distribution << std::endl;
+        return 1;
+    }
+    if (workload.distribution == "zipf" && (workload.skew <= 0 || workload.skew >= 1)) {
+        std::cerr << "Error: skew must be between 0 and 1" << std::endl;
+        return 1;
+    }
+    if (workload.value_max < workload.value_min) {
+        std::cerr << "Error: value-max is less than value-size" << std::endl;
+        return 1;
+    }
+
+    std::stringstream distribution;
+    distribution << workload.distribution;
+    if (workload.distribution == "zipf") {
+        distribution << "(" << workload.skew << ")";
+    }
+    std::cout << "storage: " << workload.storage << (workload.flat_combine ? " with flat combining" : "")
+              << ", eviction: " << workload.eviction << ", keys: " << workload.keys << " " << distribution.str()
+              << ", values: " << workload.value_min << "-" << workload.value_max << " bytes"
+              << ", reads: " << workload.reads << "%" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "ops/s" << std::setw(10) << "hits" << std::setw(10)
+              << "p50 ns" << std::setw(10) << "p99 ns" << std::setw(10) << "p999 ns" << std::endl;
+
+    size_t max_threads = std::max<size_t>(1, options["threads"].as<size_t>());
+    try {
+        for (size_t n_threads : ThreadCounts(max_threads)) {
+            Result result = Run(workload, n_threads);
+
+            std::stringstream hits;
+            if (result.reads != 0) {
+                hits << std::fixed << std::setprecision(1) << 100.0 * result.hits / result.reads << "%";
+            } else {
+                hits << "-";
+            }
+            std::cout << std::setw(8) << n_threads << std::setw(14) << size_t(result.latency.Count() / result.seconds)
+                      << std::setw(10) << hits.str() << std::setw(10) << result.latency.Percentile(0.5)
+                      << std::setw(10) << result.latency.Percentile(0.99) << std::setw(10)
+                      << result.latency.Percentile(0.999) << std::endl;
+        }
+    } catch (std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <core/ReadBuffer.h>
+#include <protocol/Executor.h>
+#include <storage/MapBasedGlobalLockImpl.h>
+
+using namespace Afina;
+
+// Verify that consumed data is dropped from the front and the rest is kept in one piece
+TEST(ReadBufferTest, ConsumeAndReserve) {
+    Core::ReadBuffer buffer(8);
+
+    buffer.Append("abcdef", 6);
+    buffer.Consume(4);
+    ASSERT_EQ("ef", std::string(buffer.Data(), buffer.Size()));
+
+    // Two bytes left take less space than four consumed, so they are moved to the front
+    char *free_space = buffer.Reserve(6);
+    ASSERT_EQ(buffer.Data() + 2, free_space);
+    ASSERT_LE(6, buffer.Free());
+    std::memcpy(free_space, "ghijkl", 6);
+    buffer.Commit(6);
+    ASSERT_EQ("efghijkl", std::string(buffer.Data(), buffer.Size()));
+
+    // Buffer grows once there is no room
+    buffer.Append("mnop", 4);
+    ASSERT_EQ("efghijklmnop", std::string(buffer.Data(), buffer.Size()));
+
+    buffer.Consume(buffer.Size());
+    ASSERT_TRUE(buffer.Empty());
+}
+
+// Verify that pipelined commands are executed whatever pieces they come in
+TEST(ExecutorTest, PipelinedInPieces) {
+    std::string input;
+    std::string expected;
+    for (int i = 0; i < 100; i++) {
+        std::string key = "key" + std::to_string(i);
+        std::string value = std::string(i + 1, 'x');
+        input += "set " + key + " 0 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\nget " + key + "\r\n";
+        expected += "STORED\r\nVALUE " + key + " 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\nEND\r\n";
+    }
+
+    for (size_t piece : {size_t(1), size_t(7), size_t(1000), input.size()}) {
+        Protocol::Executor executor(std::make_shared<Backend::MapBasedGlobalLockImpl>(1024 * 1024));
+        for (size_t offset = 0; offset < input.size(); offset += piece) {
+            size_t size = std::min(piece, input.size() - offset);
+
+            // Half of the pieces are received right into the input buffer
+            if (offset / piece % 2 == 0) {
+                executor.AppendAndTryExecute(input.data() + offset, size);
+            } else {
+                Core::ReadBuffer &buffer = executor.GetInput();
+                std::memcpy(buffer.Reserve(size), input.data() + offset, size);
+                buffer.Commit(size);
+                executor.TryExecute();
+            }
+        }
+        ASSERT_EQ(expected, executor.GetWholeOutputAsString()) << "piece " << piece;
+        ASSERT_TRUE(executor.GetInput().Empty());
+    }
+}
+
+// Verify that responses to pipelined commands are coalesced and only big values are referenced
+TEST(ExecutorTest, CoalescedOutput) {
+    auto storage = std::make_shared<Backend::MapBasedGlobalLockImpl>(1024 * 1024);
+    storage->Put("small", "value");
+    storage->Put("big", std::string(Protocol::Executor::max_copied_chunk + 1, 'x'));
+
+    Protocol::Executor executor(storage);
+    std::string input;
+    for (int i = 0; i < 100; i++) {
+        input += "get small\r\n";
+    }
+    executor.AppendAndTryExecute(input);
+    ASSERT_EQ(1, executor.GetQueueSize());
+
+    // Value is sent right from the storage, the lines around it are copied
+    executor.AppendAndTryExecute("get big\r\nget small\r\n");
+    ASSERT_EQ(3, executor.GetQueueSize());
+
+    // Partially sent block keeps collecting output
+    executor.RemoveFromOutput(executor.GetOutputAsIovec()[0].iov_len - 1);
+    executor.RemoveFromOutput(executor.GetOutputAsIovec()[0].iov_len + executor.GetOutputAsIovec()[1].iov_len);
+    executor.RemoveFromOutput(executor.GetOutputAsIovec()[0].iov_len - 3);
+    executor.AppendAndTryExecute("get small\r\n");
+    ASSERT_EQ(1, executor.GetQueueSize());
+    ASSERT_EQ("D\r\nVALUE small 0 5\r\nvalue\r\nEND\r\n", executor.GetWholeOutputAsString(true));
+
+    // Block is gone once it is sent, output starts in a new one
+    executor.AppendAndTryExecute("get small\r\n");
+    ASSERT_EQ("VALUE small 0 5\r\nvalue\r\nEND\r\n", executor.GetWholeOutputAsString());
+}
@@ -4,7 +4,11 @@
 #include <string>
 
 #include <afina/execute/Add.h>
+#include <afina/execute/Cas.h>
+#include <afina/execute/Decr.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Gets.h>
+#include <afina/execute/Incr.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
 
@@ -58,6 +62,25 @@ TEST(MemcachedParserTest, SimpleAdd) {
     ASSERT_EQ(-1, tmp->expire());
 }
 
+// Verify expire time of several digits in both signs
+TEST(MemcachedParserTest, ExpireTime) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("set foo 0 3600 1\r\n", consumed));
+    uint32_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_EQ(3600, reinterpret_cast<Execute::Set *>(cmd.get())->expire());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("set foo 0 -120 1\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_EQ(-120, reinterpret_cast<Execute::Set *>(cmd.get())->expire());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("set foo 0 99999999999 1\r\n", consumed), std::runtime_error);
+}
+
 // Verify simple get command passed in a single string
 TEST(MemcachedParserTest, SimpleGet) {
     Protocol::Parser parser;
@@ -81,6 +104,67 @@ TEST(MemcachedParserTest, SimpleGet) {
     ASSERT_EQ("super_long_key", keys[2]);
 }
 
+// Verify cas command with the version after the bytes field
+TEST(MemcachedParserTest, Cas) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("cas foo 1 0 3 18446744073709551615\r\nbar\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(36, consumed);
+    ASSERT_EQ("cas", parser.Name());
+
+    uint32_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(3, value_size);
+
+    Execute::Cas *tmp = reinterpret_cast<Execute::Cas *>(cmd.get());
+    ASSERT_EQ("foo", tmp->key());
+    ASSERT_EQ(1, tmp->flags());
+    ASSERT_EQ(UINT64_MAX, tmp->version());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("cas foo 1 0 3 18446744073709551616\r\n", consumed), std::runtime_error);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("gets foo bar\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_FALSE(dynamic_cast<Execute::Gets *>(cmd.get()) == nullptr);
+    ASSERT_EQ(2, reinterpret_cast<Execute::Gets *>(cmd.get())->keys().size());
+}
+
+// Verify incr and decr commands, which have no data block
+TEST(MemcachedParserTest, IncrDecr) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("incr counter 42\r\n", consumed));
+    ASSERT_EQ(17, consumed);
+    ASSERT_EQ("incr", parser.Name());
+
+    uint32_t value_size = 1;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0, value_size);
+
+    Execute::Incr *incr = reinterpret_cast<Execute::Incr *>(cmd.get());
+    ASSERT_EQ("counter", incr->key());
+    ASSERT_EQ(42, incr->delta());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("decr counter 18446744073709551615\r\n", consumed));
+    cmd = parser.Build(value_size);
+    Execute::Decr *decr = reinterpret_cast<Execute::Decr *>(cmd.get());
+    ASSERT_EQ("counter", decr->key());
+    ASSERT_EQ(UINT64_MAX, decr->delta());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr counter 18446744073709551616\r\n", consumed), std::runtime_error);
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr counter -1\r\n", consumed), std::runtime_error);
+}
+
 TEST(MemcachedParserTest, Stats) {
     Protocol::Parser parser;
 
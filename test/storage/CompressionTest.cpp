@@ -0,0 +1,218 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <storage/Compression.h>
+#include <storage/Lzf.h>
+#include <storage/MapBasedGlobalLockImpl.h>
+#include <storage/MapBasedSlabImpl.h>
+#include <storage/MapBasedTieredImpl.h>
+
+using namespace Afina;
+using namespace Afina::Backend;
+using namespace std;
+
+// JSON like value that compresses several times
+std::string JsonValue(size_t i, size_t size = 4096) {
+    std::string value = "[";
+    while (value.size() < size) {
+        value += "{\"id\":" + std::to_string(i++) + ",\"name\":\"item\",\"tags\":[\"cache\",\"json\"],\"active\":true},";
+    }
+    value.resize(size);
+    return value;
+}
+
+std::string RandomValue(size_t size, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::string value(size, 0);
+    for (auto &c : value) {
+        c = static_cast<char>(gen());
+    }
+    return value;
+}
+
+TEST(CompressionTest, LzfRoundTrip) {
+    std::vector<std::string> inputs = {"a", "abc", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+                                       JsonValue(0, 100000), RandomValue(10000, 1)};
+    // Repeats far apart are out of the window and longer than the longest reference
+    inputs.push_back(RandomValue(1000, 2) + std::string(10000, 'x') + RandomValue(1000, 2));
+
+    for (auto &input : inputs) {
+        std::vector<char> packed(input.size() + input.size() / 16 + 64);
+        size_t size = LzfCompress(input.data(), input.size(), packed.data(), packed.size());
+        ASSERT_NE(0, size);
+
+        std::string output(input.size(), 0);
+        ASSERT_EQ(input.size(), LzfDecompress(packed.data(), size, &output[0], output.size()));
+        EXPECT_EQ(input, output);
+
+        // Output buffer that is one byte short is detected
+        if (input.size() > 1) {
+            EXPECT_EQ(0, LzfDecompress(packed.data(), size, &output[0], output.size() - 1));
+        }
+    }
+}
+
+TEST(CompressionTest, LzfTruncatedStream) {
+    std::string input = JsonValue(0, 10000);
+    std::vector<char> packed(input.size());
+    size_t size = LzfCompress(input.data(), input.size(), packed.data(), packed.size());
+    ASSERT_NE(0, size);
+
+    // Stream cut anywhere either fails or gives a prefix of the input, never more.
+    // Copy of the stream is exactly as long as the cut, so sanitizers catch reads
+    // behind it
+    std::string output(input.size(), 0);
+    for (size_t cut = 1; cut < size; cut++) {
+        std::vector<char> truncated(packed.begin(), packed.begin() + cut);
+        size_t written = LzfDecompress(truncated.data(), cut, &output[0], output.size());
+        ASSERT_LT(written, input.size()) << "cut at " << cut;
+        EXPECT_EQ(input.substr(0, written), output.substr(0, written)) << "cut at " << cut;
+    }
+}
+
+TEST(CompressionTest, LzfMalformedStream) {
+    char output[64];
+
+    // Literal run is longer than the rest of the stream
+    EXPECT_EQ(0, LzfDecompress("\x05" "abc", 4, output, sizeof(output)));
+
+    // Back reference before the start of the output
+    EXPECT_EQ(0, LzfDecompress("\x20\x00", 2, output, sizeof(output)));
+    EXPECT_EQ(0, LzfDecompress("\x02" "abc" "\x20\x03", 6, output, sizeof(output)));
+
+    // Back reference without its offset or length byte
+    EXPECT_EQ(0, LzfDecompress("\x02" "abc" "\x20", 5, output, sizeof(output)));
+    EXPECT_EQ(0, LzfDecompress("\x02" "abc" "\xe0", 5, output, sizeof(output)));
+    EXPECT_EQ(0, LzfDecompress("\x02" "abc" "\xe0\x00", 6, output, sizeof(output)));
+
+    // Back reference that runs past the end of the output
+    EXPECT_EQ(0, LzfDecompress("\x02" "abc" "\xe0\xff\x02", 7, output, sizeof(output)));
+
+    // Valid stream for comparison: three literals and an overlapping copy of 10
+    ASSERT_EQ(13, LzfDecompress("\x02" "abc" "\xe0\x01\x02", 7, output, sizeof(output)));
+    EXPECT_EQ("abcabcabcabca", std::string(output, 13));
+}
+
+TEST(CompressionTest, LzfRandomStream) {
+    // Garbage never makes decoder write out of the buffer, guard bytes behind the
+    // output stay untouched
+    const size_t out_size = 4096, guard = 64;
+    std::vector<char> output(out_size + guard);
+    for (unsigned seed = 0; seed < 1000; seed++) {
+        std::string garbage = RandomValue(1 + seed % 256, seed);
+        std::fill(output.begin(), output.end(), '\x5a');
+        size_t written = LzfDecompress(garbage.data(), garbage.size(), output.data(), out_size);
+        ASSERT_LE(written, out_size);
+        for (size_t i = out_size; i < output.size(); i++) {
+            ASSERT_EQ('\x5a', output[i]) << "seed " << seed;
+        }
+    }
+}
+
+TEST(CompressionTest, PacksOnlyCompressible) {
+    std::string value = JsonValue(0);
+    std::string packed;
+    ASSERT_TRUE(Compress(value.data(), value.size(), packed));
+    EXPECT_LT(packed.size() * 3, value.size());
+
+    std::string unpacked;
+    Decompress(packed.data(), packed.size(), unpacked);
+    EXPECT_EQ(value, unpacked);
+    EXPECT_EQ(value, Decompress(packed.data(), packed.size()).str());
+
+    std::string random = RandomValue(4096, 3);
+    EXPECT_FALSE(Compress(random.data(), random.size(), packed));
+    EXPECT_THROW(Decompress("\xff\xff", 2, unpacked), std::runtime_error);
+}
+
+TEST(CompressionTest, StorageReturnsOriginalValues) {
+    MapBasedGlobalLockImpl storage(1 << 20);
+    storage.SetCompression(256);
+
+    ASSERT_TRUE(storage.Put("json", JsonValue(1)));
+    ASSERT_TRUE(storage.Put("small", "value"));
+    ASSERT_TRUE(storage.Put("random", RandomValue(4096, 4)));
+    ASSERT_TRUE(storage.PutIfAbsent("absent", JsonValue(2)));
+    ASSERT_TRUE(storage.Set("small", JsonValue(3)));
+
+    std::string value;
+    ASSERT_TRUE(storage.Get("json", value));
+    EXPECT_EQ(JsonValue(1), value);
+    EXPECT_EQ(JsonValue(2), storage.GetRef("absent").str());
+    EXPECT_EQ(RandomValue(4096, 4), storage.GetRef("random").str());
+
+    std::vector<ValueRef> values;
+    EXPECT_EQ(3, storage.MultiGet({"small", "missing", "json", "random"}, values));
+    EXPECT_EQ(JsonValue(3), values[0].str());
+    EXPECT_FALSE(values[1]);
+    EXPECT_EQ(JsonValue(1), values[2].str());
+
+    std::vector<ScanItem> items;
+    size_t cursor = 0;
+    do {
+        cursor = storage.Scan(cursor, 2, items);
+    } while (cursor != 0);
+    ASSERT_EQ(4, items.size());
+    for (auto &item : items) {
+        ASSERT_TRUE(storage.Get(item.key, value));
+        EXPECT_EQ(value, item.value.str());
+    }
+
+    // Value updated in place switches between compressed and plain
+    ASSERT_TRUE(storage.Put("json", "short"));
+    ASSERT_TRUE(storage.Get("json", value));
+    EXPECT_EQ("short", value);
+}
+
+TEST(CompressionTest, CompressedSizeIsCharged) {
+    const size_t max_size = 256 * 1024;
+    const size_t n_items = 200;
+
+    MapBasedGlobalLockImpl plain(max_size);
+    MapBasedGlobalLockImpl compressed(max_size);
+    compressed.SetCompression(1024);
+    for (size_t i = 0; i < n_items; i++) {
+        plain.Put("key_" + std::to_string(i), JsonValue(i));
+        compressed.Put("key_" + std::to_string(i), JsonValue(i));
+    }
+
+    // Plain storage keeps about 64 items, compressed one keeps all of them
+    EXPECT_LT(plain.Memory().items, n_items / 3);
+    EXPECT_EQ(n_items, compressed.Memory().items);
+    EXPECT_LE(compressed.Memory().payload, max_size);
+    for (size_t i = 0; i < n_items; i++) {
+        std::string value;
+        ASSERT_TRUE(compressed.Get("key_" + std::to_string(i), value));
+        EXPECT_EQ(JsonValue(i), value);
+    }
+}
+
+TEST(CompressionTest, SlabEntries) {
+    MapBasedSlabImpl storage(1 << 20);
+    storage.SetCompression(256);
+    ASSERT_TRUE(storage.Put("json", JsonValue(5)));
+    EXPECT_EQ(JsonValue(5), storage.GetRef("json").str());
+}
+
+TEST(CompressionTest, SpilledStayCompressed) {
+    std::string path = "afina_compressed_spill_test_" + std::to_string(getpid());
+    MapBasedTieredImpl storage(64 * 1024, path, 1 << 20);
+    storage.SetCompression(1024);
+
+    const size_t n_items = 200;
+    for (size_t i = 0; i < n_items; i++) {
+        ASSERT_TRUE(storage.Put("key_" + std::to_string(i), JsonValue(i, 16384)));
+    }
+    EXPECT_GT(storage.Spilled(), 0);
+
+    for (size_t i = 0; i < n_items; i++) {
+        std::string value;
+        ASSERT_TRUE(storage.Get("key_" + std::to_string(i), value));
+        EXPECT_EQ(JsonValue(i, 16384), value);
+    }
+}
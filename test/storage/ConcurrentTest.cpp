@@ -0,0 +1,539 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/lockfree/applier.h>
+#include <storage/EpochManager.h>
+#include <storage/MapBasedEpochImpl.h>
+#include <storage/MapBasedGlobalLockImpl.h>
+#include <storage/MapBasedStripedLockImpl.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+const size_t ConcurrentStorageSize = 64 * 1024 * 1024;
+const size_t ConcurrentKeysPerThread = 2000;
+const size_t ConcurrentRounds = 10;
+
+// Each thread works with its own set of keys, so results are deterministic and could be checked
+// even if storage shares state between threads. Returns number of operations per second.
+double RunThroughput(Afina::Storage &storage, size_t n_threads, size_t rounds = ConcurrentRounds) {
+    std::atomic<size_t> failures(0);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < n_threads; t++) {
+        threads.emplace_back([&storage, &failures, t, rounds]() {
+            std::string value;
+            for (size_t round = 0; round < rounds; round++) {
+                for (size_t i = 0; i < ConcurrentKeysPerThread; i++) {
+                    std::string key = "key_" + std::to_string(t) + "_" + std::to_string(i);
+                    std::string expected = "value_" + std::to_string(round) + "_" + std::to_string(i);
+                    storage.Put(key, expected);
+                    // three reads per write, caches are read mostly
+                    for (int r = 0; r < 3; r++) {
+                        if (!storage.Get(key, value) || value != expected) {
+                            failures++;
+                        }
+                    }
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(0, failures.load());
+    return (n_threads * rounds * ConcurrentKeysPerThread * 4) / elapsed;
+}
+
+TEST(ConcurrentStorageTest, StripedMatchesGlobal) {
+    MapBasedStripedLockImpl storage(ConcurrentStorageSize);
+
+    storage.Put("KEY1", "val1");
+    storage.Put("KEY2", "val2");
+    EXPECT_TRUE(storage.PutIfAbsent("KEY3", "val3"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val3"));
+    EXPECT_TRUE(storage.Set("KEY2", "val22"));
+    EXPECT_FALSE(storage.Set("KEY4", "val4"));
+    EXPECT_TRUE(storage.Delete("KEY3"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("val22", value);
+    EXPECT_FALSE(storage.Get("KEY3", value));
+}
+
+TEST(ConcurrentStorageTest, StripedBadShardsCount) {
+    EXPECT_THROW(MapBasedStripedLockImpl(1024, 3), std::invalid_argument);
+    EXPECT_THROW(MapBasedStripedLockImpl(1024, 0), std::invalid_argument);
+}
+
+TEST(ConcurrentStorageTest, EpochMatchesGlobal) {
+    MapBasedEpochImpl storage(ConcurrentStorageSize);
+
+    storage.Put("KEY1", "val1");
+    storage.Put("KEY2", "val2");
+    EXPECT_TRUE(storage.PutIfAbsent("KEY3", "val3"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val3"));
+    EXPECT_TRUE(storage.Set("KEY2", "val22"));
+    EXPECT_FALSE(storage.Set("KEY4", "val4"));
+    EXPECT_TRUE(storage.Delete("KEY3"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("val22", value);
+    EXPECT_FALSE(storage.Get("KEY3", value));
+}
+
+TEST(ConcurrentStorageTest, EpochSecondChance) {
+    // room for two items only
+    MapBasedEpochImpl storage(16);
+
+    storage.Put("KEY1", "val1");
+    storage.Put("KEY2", "val2");
+
+    // KEY1 is the least recent, but read since then
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    storage.Put("KEY3", "val3");
+
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+}
+
+TEST(ConcurrentStorageTest, EpochExpire) {
+    MapBasedEpochImpl storage;
+    time_t now = time(nullptr);
+
+    storage.Put("KEY1", "val1", now - 1);
+    storage.Put("KEY2", "val2", now + 3600);
+    storage.Put("KEY3", "val3", now + 3600);
+    storage.Put("KEY3", "val4");
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val5"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val5", value);
+
+    // Update of KEY3 dropped its timer
+    EXPECT_EQ(0, storage.Expire(100));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_EQ("val4", value);
+}
+
+TEST(ConcurrentStorageTest, EpochDelaysReclaim) {
+    EpochManager epoch;
+    std::atomic<int> freed(0);
+    static std::atomic<int> *counter;
+    counter = &freed;
+
+    std::atomic<bool> entered(false), leave(false);
+    std::thread reader([&]() {
+        EpochManager::Guard guard(epoch);
+        entered = true;
+        while (!leave) {
+            std::this_thread::yield();
+        }
+    });
+    while (!entered) {
+        std::this_thread::yield();
+    }
+
+    // reader may still see the object, so it must survive any number of attempts
+    epoch.Retire(nullptr, [](void *) { (*counter)++; });
+    for (int i = 0; i < 10; i++) {
+        epoch.Reclaim();
+    }
+    EXPECT_EQ(0, freed.load());
+
+    leave = true;
+    reader.join();
+    for (int i = 0; i < 3; i++) {
+        epoch.Reclaim();
+    }
+    EXPECT_EQ(1, freed.load());
+    EXPECT_EQ(0, epoch.Pending());
+}
+
+// Readers run without locks while writer keeps replacing and deleting their keys,
+// every value read must be one of the values ever written for the key
+TEST(ConcurrentStorageTest, EpochReadersWithWriter) {
+    MapBasedEpochImpl storage(64 * 1024);
+    const size_t n_keys = 1000, n_readers = 4;
+
+    std::atomic<bool> done(false);
+    std::atomic<size_t> corrupted(0);
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < n_readers; t++) {
+        readers.emplace_back([&]() {
+            std::string value;
+            while (!done) {
+                for (size_t i = 0; i < n_keys; i++) {
+                    std::string key = "key_" + std::to_string(i);
+                    if (storage.Get(key, value) && value.compare(0, key.size(), key) != 0) {
+                        corrupted++;
+                    }
+                }
+            }
+        });
+    }
+
+    for (size_t round = 0; round < 50; round++) {
+        for (size_t i = 0; i < n_keys; i++) {
+            std::string key = "key_" + std::to_string(i);
+            if ((i + round) % 7 == 0) {
+                storage.Delete(key);
+            } else {
+                storage.Put(key, key + std::string(round % 13 * 10, 'x'));
+            }
+        }
+    }
+    done = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(0, corrupted.load());
+}
+
+TEST(ConcurrentStorageTest, Throughput) {
+    for (size_t n_threads : {1, 2, 4, 8}) {
+        MapBasedGlobalLockImpl global(ConcurrentStorageSize);
+        MapBasedStripedLockImpl striped(ConcurrentStorageSize);
+        MapBasedEpochImpl epoch(ConcurrentStorageSize);
+
+        double global_ops = RunThroughput(global, n_threads);
+        double striped_ops = RunThroughput(striped, n_threads);
+        double epoch_ops = RunThroughput(epoch, n_threads);
+        std::cout << "threads: " << n_threads << " map_global: " << size_t(global_ops)
+                  << " ops/s striped_lru: " << size_t(striped_ops) << " ops/s epoch_lru: " << size_t(epoch_ops)
+                  << " ops/s" << std::endl;
+    }
+}
+
+TEST(ConcurrentStorageTest, FlatCombineMatchesGlobal) {
+    Afina::LockFree::Applier storage(std::make_shared<MapBasedGlobalLockImpl>(ConcurrentStorageSize));
+
+    storage.Put("KEY1", "val1");
+    storage.Put("KEY2", "val2");
+    EXPECT_TRUE(storage.PutIfAbsent("KEY3", "val3"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val3"));
+    EXPECT_TRUE(storage.Set("KEY2", "val22"));
+    EXPECT_FALSE(storage.Set("KEY4", "val4"));
+    EXPECT_TRUE(storage.Delete("KEY3"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("val22", value);
+    EXPECT_FALSE(storage.Get("KEY3", value));
+}
+
+// Storage that fails to put some keys
+class FailingStorage : public MapBasedGlobalLockImpl {
+public:
+    FailingStorage() : MapBasedGlobalLockImpl(ConcurrentStorageSize) {}
+
+    bool Put(const std::string &key, const std::string &value, time_t expire = 0) override {
+        if (key.compare(0, 3, "bad") == 0) {
+            throw std::runtime_error("Put failed");
+        }
+        return MapBasedGlobalLockImpl::Put(key, value, expire);
+    }
+};
+
+// Exception of a request goes to its own thread, combiner goes on with the rest of the batch
+TEST(ConcurrentStorageTest, FlatCombineFailure) {
+    Afina::LockFree::Applier storage(std::make_shared<FailingStorage>());
+
+    const size_t n_threads = 8;
+    std::atomic<size_t> failures(0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < n_threads; t++) {
+        threads.emplace_back([&storage, &failures, t]() {
+            for (size_t i = 0; i < ConcurrentKeysPerThread; i++) {
+                std::string key = (i % 2 == 0 ? "key_" : "bad_") + std::to_string(t) + "_" + std::to_string(i);
+                try {
+                    storage.Put(key, "value");
+                } catch (std::runtime_error &) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(n_threads * ConcurrentKeysPerThread / 2, failures.load());
+    std::string value;
+    for (size_t t = 0; t < n_threads; t++) {
+        for (size_t i = 0; i < ConcurrentKeysPerThread; i += 2) {
+            EXPECT_TRUE(storage.Get("key_" + std::to_string(t) + "_" + std::to_string(i), value));
+        }
+    }
+}
+
+TEST(ConcurrentStorageTest, FlatCombineThroughput) {
+    for (size_t n_threads : {8, 16, 32}) {
+        MapBasedGlobalLockImpl global(ConcurrentStorageSize);
+        Afina::LockFree::Applier combined(std::make_shared<MapBasedGlobalLockImpl>(ConcurrentStorageSize));
+
+        double global_ops = RunThroughput(global, n_threads, 2);
+        double combined_ops = RunThroughput(combined, n_threads, 2);
+        std::cout << "threads: " << n_threads << " map_global: " << size_t(global_ops)
+                  << " ops/s flat_combine: " << size_t(combined_ops) << " ops/s" << std::endl;
+    }
+}
+
+// MultiGet of every storage gives the same as Get of each key
+void CheckMultiGet(Afina::Storage &storage) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < 300; i++) {
+        keys.push_back("key_" + std::to_string(i));
+        if (i % 3 != 0) {
+            storage.Put(keys.back(), "value_" + std::to_string(i));
+        }
+    }
+    keys.push_back("key_1");
+
+    std::vector<Afina::ValueRef> values;
+    EXPECT_EQ(200 + 1, storage.MultiGet(keys, values));
+    ASSERT_EQ(keys.size(), values.size());
+
+    std::string value;
+    for (size_t i = 0; i < keys.size(); i++) {
+        bool exists = storage.Get(keys[i], value);
+        EXPECT_EQ(exists, static_cast<bool>(values[i])) << keys[i];
+        EXPECT_EQ(exists, static_cast<bool>(storage.GetRef(keys[i]))) << keys[i];
+        if (exists) {
+            EXPECT_EQ(value, values[i].str()) << keys[i];
+        }
+    }
+}
+
+TEST(ConcurrentStorageTest, MultiGetMatchesGet) {
+    MapBasedGlobalLockImpl global(ConcurrentStorageSize);
+    CheckMultiGet(global);
+
+    MapBasedStripedLockImpl striped(ConcurrentStorageSize);
+    CheckMultiGet(striped);
+
+    MapBasedEpochImpl epoch(ConcurrentStorageSize);
+    CheckMultiGet(epoch);
+
+    Afina::LockFree::Applier combined(std::make_shared<MapBasedGlobalLockImpl>(ConcurrentStorageSize));
+    CheckMultiGet(combined);
+}
+
+TEST(ConcurrentStorageTest, MultiGetThroughput) {
+    const size_t n_keys = 100000;
+    const size_t batch = 100;
+    MapBasedGlobalLockImpl storage(ConcurrentStorageSize);
+    for (size_t i = 0; i < n_keys; i++) {
+        storage.Put("key_" + std::to_string(i), "value_" + std::to_string(i));
+    }
+
+    std::vector<std::vector<std::string>> batches(n_keys / batch);
+    for (size_t i = 0; i < n_keys; i++) {
+        batches[(i * 7919) % batches.size()].push_back("key_" + std::to_string((i * 104729) % n_keys));
+    }
+
+    std::string value;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &keys : batches) {
+        for (auto &key : keys) {
+            EXPECT_TRUE(storage.Get(key, value));
+        }
+    }
+    double single = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<Afina::ValueRef> values;
+    start = std::chrono::steady_clock::now();
+    for (auto &keys : batches) {
+        EXPECT_EQ(keys.size(), storage.MultiGet(keys, values));
+    }
+    double multi = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "batch: " << batch << " get: " << size_t(n_keys / single) << " keys/s multiget: "
+              << size_t(n_keys / multi) << " keys/s" << std::endl;
+}
+
+// Threads append to the same keys, none of the appends is lost
+void CheckConcurrentAppend(Afina::Storage &storage) {
+    const size_t n_threads = 4;
+    const size_t n_appends = 500;
+    storage.Put("KEY1", "");
+    storage.Put("KEY2", "");
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < n_threads; t++) {
+        threads.emplace_back([&storage, t]() {
+            std::string data(1, 'a' + t);
+            for (size_t i = 0; i < n_appends; i++) {
+                EXPECT_TRUE(storage.Append("KEY1", data));
+                EXPECT_TRUE(storage.Prepend("KEY2", data));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::string value;
+    for (auto key : {"KEY1", "KEY2"}) {
+        ASSERT_TRUE(storage.Get(key, value));
+        EXPECT_EQ(n_threads * n_appends, value.size());
+        for (size_t t = 0; t < n_threads; t++) {
+            EXPECT_EQ(n_appends, std::count(value.begin(), value.end(), 'a' + t));
+        }
+    }
+}
+
+TEST(ConcurrentStorageTest, AppendIsAtomic) {
+    MapBasedGlobalLockImpl global(ConcurrentStorageSize);
+    CheckConcurrentAppend(global);
+
+    MapBasedStripedLockImpl striped(ConcurrentStorageSize);
+    CheckConcurrentAppend(striped);
+
+    MapBasedEpochImpl epoch(ConcurrentStorageSize);
+    CheckConcurrentAppend(epoch);
+
+    Afina::LockFree::Applier combined(std::make_shared<MapBasedGlobalLockImpl>(ConcurrentStorageSize));
+    CheckConcurrentAppend(combined);
+}
+
+// Each change gets new version, cas wins only against the version it read
+void CheckVersions(Afina::Storage &storage) {
+    std::vector<Afina::ValueRef> values;
+    std::vector<uint64_t> versions;
+    EXPECT_EQ(Afina::CasResult::NotFound, storage.CompareAndSet("KEY1", "val", 0));
+    EXPECT_EQ(0, storage.Gets({"KEY1"}, values, versions));
+    ASSERT_EQ(1, values.size());
+    EXPECT_FALSE(values[0]);
+
+    std::vector<uint64_t> seen;
+    storage.Put("KEY1", "val1");
+    storage.Gets({"KEY1"}, values, versions);
+    seen.push_back(versions[0]);
+    storage.Set("KEY1", "val2");
+    storage.Gets({"KEY1"}, values, versions);
+    seen.push_back(versions[0]);
+    storage.Append("KEY1", "_tail");
+    storage.Gets({"KEY1"}, values, versions);
+    seen.push_back(versions[0]);
+    EXPECT_EQ("val2_tail", values[0].str());
+    EXPECT_NE(seen[0], seen[1]);
+    EXPECT_NE(seen[1], seen[2]);
+
+    EXPECT_EQ(Afina::CasResult::Exists, storage.CompareAndSet("KEY1", "val3", seen[1]));
+    EXPECT_EQ(Afina::CasResult::Stored, storage.CompareAndSet("KEY1", "val3", seen[2]));
+    EXPECT_EQ(Afina::CasResult::Exists, storage.CompareAndSet("KEY1", "val4", seen[2]));
+    std::string value;
+    ASSERT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val3", value);
+
+    // Counter is incremented by cas loops, none of the increments is lost
+    const size_t n_threads = 4;
+    const size_t n_increments = 500;
+    storage.Put("COUNTER", "0");
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < n_threads; t++) {
+        threads.emplace_back([&storage]() {
+            std::vector<Afina::ValueRef> values;
+            std::vector<uint64_t> versions;
+            for (size_t i = 0; i < n_increments; i++) {
+                Afina::CasResult result;
+                do {
+                    storage.Gets({"COUNTER"}, values, versions);
+                    std::string next = std::to_string(std::stoul(values[0].str()) + 1);
+                    result = storage.CompareAndSet("COUNTER", next, versions[0]);
+                } while (result == Afina::CasResult::Exists);
+                EXPECT_EQ(Afina::CasResult::Stored, result);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    ASSERT_TRUE(storage.Get("COUNTER", value));
+    EXPECT_EQ(std::to_string(n_threads * n_increments), value);
+}
+
+TEST(ConcurrentStorageTest, CompareAndSet) {
+    MapBasedGlobalLockImpl global(ConcurrentStorageSize);
+    CheckVersions(global);
+
+    MapBasedStripedLockImpl striped(ConcurrentStorageSize);
+    CheckVersions(striped);
+
+    MapBasedEpochImpl epoch(ConcurrentStorageSize);
+    CheckVersions(epoch);
+
+    Afina::LockFree::Applier combined(std::make_shared<MapBasedGlobalLockImpl>(ConcurrentStorageSize));
+    CheckVersions(combined);
+}
+
+// Threads bump the same counter, none of the increments is lost
+void CheckConcurrentCounter(Afina::Storage &storage) {
+    const size_t n_threads = 4;
+    const size_t n_increments = 1000;
+    storage.Put("COUNTER", "0");
+    storage.Put("TEXT", "text");
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < n_threads; t++) {
+        threads.emplace_back([&storage]() {
+            uint64_t value;
+            for (size_t i = 0; i < n_increments; i++) {
+                EXPECT_TRUE(storage.Increment("COUNTER", 3, value));
+                EXPECT_TRUE(storage.Decrement("COUNTER", 1, value));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::string value;
+    ASSERT_TRUE(storage.Get("COUNTER", value));
+    EXPECT_EQ(std::to_string(2 * n_threads * n_increments), value);
+
+    uint64_t counter;
+    EXPECT_FALSE(storage.Increment("NONE", 1, counter));
+    EXPECT_THROW(storage.Increment("TEXT", 1, counter), std::invalid_argument);
+}
+
+TEST(ConcurrentStorageTest, CounterIsAtomic) {
+    MapBasedGlobalLockImpl global(ConcurrentStorageSize);
+    CheckConcurrentCounter(global);
+
+    MapBasedStripedLockImpl striped(ConcurrentStorageSize);
+    CheckConcurrentCounter(striped);
+
+    MapBasedEpochImpl epoch(ConcurrentStorageSize);
+    CheckConcurrentCounter(epoch);
+
+    Afina::LockFree::Applier combined(std::make_shared<MapBasedGlobalLockImpl>(ConcurrentStorageSize));
+    CheckConcurrentCounter(combined);
+}
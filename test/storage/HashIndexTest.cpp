@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+#include <storage/HashIndex.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+struct TestEntry {
+    std::string key;
+
+    bool Matches(const std::string &other) const { return key == other; }
+};
+
+const size_t HashIndexTestSize = 100000;
+
+TEST(HashIndexTest, InsertFind) {
+    HashIndex<TestEntry> index;
+    std::vector<TestEntry> entries(HashIndexTestSize);
+
+    for (size_t i = 0; i < HashIndexTestSize; i++) {
+        entries[i].key = "key" + std::to_string(i);
+        index.Insert(index.Hash(entries[i].key), &entries[i]);
+    }
+    EXPECT_EQ(HashIndexTestSize, index.Size());
+    EXPECT_GE(index.Capacity(), HashIndexTestSize);
+
+    for (size_t i = 0; i < HashIndexTestSize; i++) {
+        EXPECT_EQ(&entries[i], index.Find(entries[i].key, index.Hash(entries[i].key)));
+    }
+    EXPECT_EQ(nullptr, index.Find("absent", index.Hash("absent")));
+}
+
+TEST(HashIndexTest, EraseKeepsOthers) {
+    HashIndex<TestEntry> index;
+    std::vector<TestEntry> entries(HashIndexTestSize);
+
+    for (size_t i = 0; i < HashIndexTestSize; i++) {
+        entries[i].key = "key" + std::to_string(i);
+        index.Insert(index.Hash(entries[i].key), &entries[i]);
+    }
+    for (size_t i = 0; i < HashIndexTestSize; i += 2) {
+        EXPECT_TRUE(index.Erase(index.Hash(entries[i].key), &entries[i]));
+    }
+    EXPECT_FALSE(index.Erase(index.Hash(entries[0].key), &entries[0]));
+    EXPECT_EQ(HashIndexTestSize / 2, index.Size());
+
+    for (size_t i = 0; i < HashIndexTestSize; i++) {
+        TestEntry *expected = (i % 2 == 0) ? nullptr : &entries[i];
+        EXPECT_EQ(expected, index.Find(entries[i].key, index.Hash(entries[i].key)));
+    }
+}
+
+TEST(HashIndexTest, Collisions) {
+    HashIndex<TestEntry> index;
+    std::vector<TestEntry> entries(64);
+
+    // All entries share the same hash, so lookup has to compare keys
+    for (size_t i = 0; i < entries.size(); i++) {
+        entries[i].key = "key" + std::to_string(i);
+        index.Insert(42, &entries[i]);
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        EXPECT_EQ(&entries[i], index.Find(entries[i].key, 42));
+    }
+
+    TestEntry replacement = {entries[10].key};
+    index.Replace(42, &entries[10], &replacement);
+    EXPECT_EQ(&replacement, index.Find(entries[10].key, 42));
+
+    EXPECT_TRUE(index.Erase(42, &entries[0]));
+    for (size_t i = 1; i < entries.size(); i++) {
+        EXPECT_NE(nullptr, index.Find(entries[i].key, 42));
+    }
+}
@@ -0,0 +1,175 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <storage/EvictionPolicy.h>
+#include <storage/MapBasedGlobalLockImpl.h>
+#include <storage/MapBasedSlabImpl.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+// Item is key + value of 8 bytes each, so storage of n * 16 bytes holds n items
+const size_t PolicyItemSize = 16;
+
+static string Key(size_t i) {
+    string key = "k" + to_string(i);
+    return key + string(8 - key.size(), '_');
+}
+
+static bool Has(MapBasedGlobalLockImpl &storage, const string &key) {
+    string value;
+    return storage.Get(key, value);
+}
+
+TEST(PolicyTest, UnknownPolicy) { EXPECT_THROW(EvictionPolicy::Create("fifo", 1024), invalid_argument); }
+
+TEST(PolicyTest, ClockSecondChance) {
+    MapBasedGlobalLockImpl storage(2 * PolicyItemSize, EvictionPolicy::Create("clock", 2 * PolicyItemSize));
+    storage.Put(Key(1), "value__1");
+    storage.Put(Key(2), "value__2");
+
+    // Key 1 is the oldest, but it was read, so Key 2 goes first
+    EXPECT_TRUE(Has(storage, Key(1)));
+    storage.Put(Key(3), "value__3");
+
+    EXPECT_TRUE(Has(storage, Key(1)));
+    EXPECT_FALSE(Has(storage, Key(2)));
+    EXPECT_TRUE(Has(storage, Key(3)));
+}
+
+TEST(PolicyTest, SegmentedLRUScanResistant) {
+    MapBasedGlobalLockImpl storage(10 * PolicyItemSize, EvictionPolicy::Create("slru", 10 * PolicyItemSize));
+    for (size_t i = 0; i < 5; i++) {
+        storage.Put(Key(i), "value___");
+        EXPECT_TRUE(Has(storage, Key(i)));
+    }
+
+    // single pass over many keys doesn't flush keys seen twice
+    for (size_t i = 100; i < 200; i++) {
+        storage.Put(Key(i), "value___");
+    }
+    for (size_t i = 0; i < 5; i++) {
+        EXPECT_TRUE(Has(storage, Key(i)));
+    }
+    EXPECT_FALSE(Has(storage, Key(100)));
+}
+
+TEST(PolicyTest, TinyLFUKeepsFrequent) {
+    MapBasedGlobalLockImpl storage(10 * PolicyItemSize, EvictionPolicy::Create("tinylfu", 10 * PolicyItemSize));
+    for (size_t round = 0; round < 5; round++) {
+        for (size_t i = 0; i < 5; i++) {
+            if (!Has(storage, Key(i))) {
+                storage.Put(Key(i), "value___");
+            }
+        }
+    }
+
+    for (size_t i = 100; i < 200; i++) {
+        storage.Put(Key(i), "value___");
+    }
+    for (size_t i = 0; i < 5; i++) {
+        EXPECT_TRUE(Has(storage, Key(i)));
+    }
+}
+
+TEST(PolicyTest, UpdateInEverySegment) {
+    for (const string &policy : {"lru", "clock", "slru", "tinylfu"}) {
+        MapBasedGlobalLockImpl storage(4 * PolicyItemSize, EvictionPolicy::Create(policy, 4 * PolicyItemSize));
+        storage.Put(Key(1), "value__1");
+        storage.Put(Key(2), "value__2");
+        Has(storage, Key(1));
+
+        // grows block, shrinks it back and deletes, policy must follow entry
+        storage.Put(Key(1), string(40, 'x'));
+        storage.Put(Key(1), "v");
+        storage.Put(Key(2), "value__3");
+        EXPECT_TRUE(storage.Delete(Key(1))) << policy;
+
+        string value;
+        EXPECT_TRUE(storage.Get(Key(2), value)) << policy;
+        EXPECT_EQ("value__3", value) << policy;
+    }
+}
+
+TEST(PolicyTest, SlabWithPolicies) {
+    for (const string &policy : {"lru", "clock", "slru", "tinylfu"}) {
+        MapBasedSlabImpl storage(MapBasedSlabImpl::min_arena_size, policy);
+        for (size_t i = 0; i < 5000; i++) {
+            EXPECT_TRUE(storage.Put(Key(i), string(i % 7 * 30 + 10, 'v'))) << policy;
+        }
+        EXPECT_TRUE(Has(storage, Key(4999))) << policy;
+    }
+}
+
+// Trace is a sequence of key ids. If AFINA_TRACE is set, keys are read from that
+// file one per line, otherwise Zipf distributed keys are generated with a scan
+// of unique keys inserted every 100000 requests
+static vector<string> LoadTrace() {
+    vector<string> trace;
+    const char *path = getenv("AFINA_TRACE");
+    if (path != nullptr) {
+        ifstream in(path);
+        string key;
+        while (getline(in, key)) {
+            trace.push_back(key);
+        }
+        return trace;
+    }
+
+    const size_t keys = 100000, length = 500000, scan = 20000;
+    vector<double> cdf(keys);
+    double sum = 0;
+    for (size_t i = 0; i < keys; i++) {
+        sum += 1.0 / pow(double(i + 1), 0.99);
+        cdf[i] = sum;
+    }
+
+    mt19937 rnd(42);
+    uniform_real_distribution<double> uniform(0, sum);
+    size_t scanned = keys;
+    for (size_t i = 0; i < length; i++) {
+        if (i % 100000 == 50000) {
+            for (size_t j = 0; j < scan; j++) {
+                trace.push_back(Key(scanned++));
+            }
+        }
+        trace.push_back(Key(lower_bound(cdf.begin(), cdf.end(), uniform(rnd)) - cdf.begin()));
+    }
+    return trace;
+}
+
+// Replays trace as a look-aside cache: get, and set on miss
+TEST(PolicyTest, HitRatioBench) {
+    vector<string> trace = LoadTrace();
+    const string value(48, 'v');
+
+    for (size_t items : {1000, 10000}) {
+        for (const string &policy : {"lru", "clock", "slru", "tinylfu"}) {
+            size_t max_size = items * (Key(0).size() + value.size());
+            MapBasedGlobalLockImpl storage(max_size, EvictionPolicy::Create(policy, max_size));
+
+            size_t hits = 0;
+            string result;
+            auto start = chrono::steady_clock::now();
+            for (const string &key : trace) {
+                if (storage.Get(key, result)) {
+                    hits++;
+                } else {
+                    storage.Put(key, value);
+                }
+            }
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            cout << "items: " << items << " policy: " << policy << " hit ratio: " << double(hits) / trace.size()
+                 << " throughput: " << size_t(trace.size() / elapsed) << " ops/s" << endl;
+        }
+    }
+}
@@ -0,0 +1,152 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <afina/lockfree/applier.h>
+#include <storage/MapBasedEpochImpl.h>
+#include <storage/MapBasedGlobalLockImpl.h>
+#include <storage/MapBasedStripedLockImpl.h>
+#include <storage/Snapshot.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+const size_t SnapshotStorageSize = 1 << 20;
+
+// Unique file name removed once test is done
+class TempPath {
+public:
+    TempPath() : _path("afina_snapshot_test_" + std::to_string(getpid()) + "_" + std::to_string(_counter++)) {}
+    ~TempPath() { std::remove(_path.c_str()); }
+
+    const std::string &str() const { return _path; }
+
+private:
+    static size_t _counter;
+    std::string _path;
+};
+
+size_t TempPath::_counter = 0;
+
+// Scan of the storage returns each item exactly once
+void CheckScan(Afina::Storage &storage) {
+    for (size_t i = 0; i < 1000; i++) {
+        storage.Put("key_" + std::to_string(i), "value_" + std::to_string(i));
+    }
+
+    std::set<std::string> keys;
+    std::vector<Afina::ScanItem> items;
+    size_t cursor = 0;
+    do {
+        cursor = storage.Scan(cursor, 16, items);
+    } while (cursor != 0);
+
+    EXPECT_EQ(1000, items.size());
+    for (auto &item : items) {
+        EXPECT_TRUE(keys.insert(item.key).second) << item.key;
+        EXPECT_EQ("value_" + item.key.substr(4), item.value.str());
+    }
+}
+
+TEST(SnapshotTest, ScanVisitsAllItems) {
+    MapBasedGlobalLockImpl global(SnapshotStorageSize);
+    CheckScan(global);
+
+    MapBasedStripedLockImpl striped(SnapshotStorageSize);
+    CheckScan(striped);
+
+    MapBasedEpochImpl epoch(SnapshotStorageSize);
+    CheckScan(epoch);
+
+    Afina::LockFree::Applier combined(std::make_shared<MapBasedGlobalLockImpl>(SnapshotStorageSize));
+    CheckScan(combined);
+}
+
+TEST(SnapshotTest, SaveLoad) {
+    TempPath path;
+    time_t later = std::time(nullptr) + 3600;
+
+    MapBasedGlobalLockImpl source(SnapshotStorageSize);
+    for (size_t i = 0; i < 1000; i++) {
+        source.Put("key_" + std::to_string(i), std::string(i, 'x'), i % 2 == 0 ? 0 : later);
+    }
+    source.Put("gone", "value", std::time(nullptr) - 1);
+    EXPECT_EQ(1000, Snapshot::Save(source, path.str()));
+
+    // Snapshot could be loaded into a storage of another type
+    MapBasedEpochImpl target(SnapshotStorageSize);
+    EXPECT_EQ(1000, Snapshot::Load(target, path.str()));
+
+    std::string value;
+    for (size_t i = 0; i < 1000; i++) {
+        ASSERT_TRUE(target.Get("key_" + std::to_string(i), value));
+        EXPECT_EQ(std::string(i, 'x'), value);
+    }
+    EXPECT_FALSE(target.Get("gone", value));
+
+    std::vector<Afina::ScanItem> items;
+    size_t cursor = 0;
+    do {
+        cursor = target.Scan(cursor, 64, items);
+    } while (cursor != 0);
+    for (auto &item : items) {
+        size_t i = std::stoul(item.key.substr(4));
+        EXPECT_EQ(i % 2 == 0 ? 0 : later, item.expire) << item.key;
+    }
+}
+
+TEST(SnapshotTest, MissingFile) {
+    MapBasedGlobalLockImpl storage(SnapshotStorageSize);
+    EXPECT_EQ(0, Snapshot::Load(storage, "afina_snapshot_test_missing"));
+}
+
+TEST(SnapshotTest, BrokenFile) {
+    TempPath path;
+    MapBasedGlobalLockImpl source(SnapshotStorageSize);
+    source.Put("KEY1", "val1");
+    source.Put("KEY2", "val2");
+    ASSERT_EQ(2, Snapshot::Save(source, path.str()));
+
+    std::string content;
+    {
+        std::ifstream in(path.str(), std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Flipped byte of a value
+    std::string broken = content;
+    broken[content.find("val")] = 'V';
+    std::ofstream(path.str(), std::ios::binary | std::ios::trunc) << broken;
+    MapBasedGlobalLockImpl target(SnapshotStorageSize);
+    EXPECT_THROW(Snapshot::Load(target, path.str()), std::runtime_error);
+
+    // Truncated file
+    std::ofstream(path.str(), std::ios::binary | std::ios::trunc) << content.substr(0, content.size() - 10);
+    EXPECT_THROW(Snapshot::Load(target, path.str()), std::runtime_error);
+
+    std::string value;
+    EXPECT_FALSE(target.Get("KEY1", value));
+}
+
+TEST(SnapshotTest, BackgroundSave) {
+    TempPath path;
+    auto storage = std::make_shared<MapBasedGlobalLockImpl>(SnapshotStorageSize);
+    storage->Put("KEY1", "val1");
+    {
+        Snapshot snapshot(storage, path.str(), std::chrono::seconds(3600));
+        snapshot.Start();
+        storage->Put("KEY2", "val2");
+        snapshot.Stop();
+    }
+
+    MapBasedGlobalLockImpl target(SnapshotStorageSize);
+    EXPECT_EQ(2, Snapshot::Load(target, path.str()));
+}
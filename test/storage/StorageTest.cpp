@@ -1,15 +1,25 @@
 #include "gtest/gtest.h"
+#include <chrono>
+#include <ctime>
 #include <iostream>
 #include <set>
+#include <thread>
 #include <vector>
 #include <utility>
 
 #include <storage/MapBasedGlobalLockImpl.h>
+#include <storage/MapBasedSlabImpl.h>
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
+#include <afina/execute/Cas.h>
+#include <afina/execute/Decr.h>
 #include <afina/execute/Delete.h>
+#include <afina/execute/Gets.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Stats.h>
 
 using namespace Afina::Backend;
 using namespace Afina::Execute;
@@ -141,3 +151,353 @@ TEST(StorageTest, OverheadTest) {
     CheckRange(storage, OverheadSize, sum_size, sum_size, len);
     CheckRange(storage, 0, OverheadSize, sum_size, false, len);
 }
+
+TEST(StorageTest, ValueResize) {
+    MapBasedGlobalLockImpl storage;
+
+    storage.Put("KEY1", "val1");
+    storage.Put("KEY2", std::string(100, 'a'));
+    CheckKeyValuePair(storage, "KEY2", std::string(100, 'a'));
+
+    storage.Put("KEY2", std::string(80, 'b')); // fits into the same block
+    CheckKeyValuePair(storage, "KEY2", std::string(80, 'b'));
+
+    storage.Put("KEY2", "c"); // shrinks the block
+    CheckKeyValuePair(storage, "KEY2", "c");
+
+    storage.Put("KEY2", std::string(200, 'd')); // grows the block
+    CheckKeyValuePair(storage, "KEY2", std::string(200, 'd'));
+    CheckKeyValuePair(storage, "KEY1", "val1");
+}
+
+TEST(StorageTest, OverheadReport) {
+    MapBasedGlobalLockImpl storage;
+    EXPECT_EQ(0, storage.Overhead());
+
+    storage.Put("KEY1", "val1");
+    storage.Put("KEY2", "val2");
+
+    // at least entry header, but not more than header plus the whole index
+    EXPECT_GE(storage.Overhead(), sizeof(Entry));
+    EXPECT_LE(storage.Overhead(), sizeof(Entry) + 16 * 16);
+}
+
+TEST(StorageTest, SlabPutGet) {
+    MapBasedSlabImpl storage(MapBasedSlabImpl::min_arena_size);
+
+    storage.Put("KEY1", "val1");
+    storage.Put("KEY2", std::string(1000, 'a'));
+    CheckKeyValuePair(storage, "KEY1", "val1");
+    CheckKeyValuePair(storage, "KEY2", std::string(1000, 'a'));
+
+    storage.Put("KEY2", "b");
+    CheckKeyValuePair(storage, "KEY2", "b");
+    EXPECT_TRUE(storage.Delete("KEY1"));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(StorageTest, SlabEvict) {
+    MapBasedSlabImpl storage(MapBasedSlabImpl::min_arena_size);
+
+    // many more items than arena could hold, the latest must survive. Keys are of
+    // the same width, so all items get into the same size class
+    const size_t count = 10000;
+    const std::string filler(50, 'v');
+    for (size_t i = count; i < 2 * count; i++) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), filler + std::to_string(i)));
+    }
+    CheckKeyValuePair(storage, "Key " + std::to_string(2 * count - 1), filler + std::to_string(2 * count - 1));
+    CheckKeyValuePair(storage, "Key " + std::to_string(count), filler + std::to_string(count), false);
+
+    // values of other size classes still get memory
+    EXPECT_TRUE(storage.Put("big", std::string(2000, 'x')));
+    CheckKeyValuePair(storage, "big", std::string(2000, 'x'));
+    CheckKeyValuePair(storage, "Key " + std::to_string(2 * count - 1), filler + std::to_string(2 * count - 1));
+}
+
+TEST(StorageTest, SlabTooSmall) { EXPECT_THROW(MapBasedSlabImpl storage(1024), std::invalid_argument); }
+
+TEST(StorageTest, ExpiredOnGet) {
+    MapBasedGlobalLockImpl storage;
+    time_t now = time(nullptr);
+
+    storage.Put("KEY1", "val1", now - 1);
+    storage.Put("KEY2", "val2", now + 3600);
+    storage.Put("KEY3", "val3");
+    CheckKeyValuePair(storage, "KEY1", "", false);
+    CheckKeyValuePair(storage, "KEY2", "val2");
+    CheckKeyValuePair(storage, "KEY3", "val3");
+
+    // Expired in the past means deleted
+    EXPECT_TRUE(storage.Set("KEY3", "val4", now - 1));
+    CheckKeyValuePair(storage, "KEY3", "", false);
+    EXPECT_FALSE(storage.Set("KEY3", "val4"));
+
+    // Update drops expiration time
+    storage.Put("KEY2", "val5");
+    EXPECT_EQ(0, storage.Expire(100));
+    CheckKeyValuePair(storage, "KEY2", "val5");
+}
+
+TEST(StorageTest, ExpireInBatches) {
+    MapBasedGlobalLockImpl storage(100000);
+    time_t expire = time(nullptr) + 1;
+    for (size_t i = 0; i < 100; i++) {
+        storage.Put("KEY" + std::to_string(i), "val", expire);
+    }
+    storage.Put("KEEP", "val");
+    EXPECT_EQ(0, storage.Expire(100));
+
+    while (time(nullptr) < expire) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    // Each write reclaims a few items without looking them up
+    storage.Put("KEEP", "val2");
+    EXPECT_EQ(10, storage.Expire(10));
+    EXPECT_EQ(100 - 10 - MapBasedGlobalLockImpl::expire_batch, storage.Expire(1000));
+    CheckKeyValuePair(storage, "KEY0", "", false);
+    CheckKeyValuePair(storage, "KEEP", "val2");
+}
+
+TEST(StorageTest, ExpireCommand) {
+    MapBasedGlobalLockImpl storage;
+
+    std::string out;
+    Set("KEY1", 0, -1).Execute(storage, "val1", out);
+    EXPECT_EQ("STORED", out);
+    CheckKeyValuePair(storage, "KEY1", "", false);
+
+    Set("KEY2", 0, 3600).Execute(storage, "val2", out);
+    EXPECT_EQ("STORED", out);
+    CheckKeyValuePair(storage, "KEY2", "val2");
+}
+
+TEST(StorageTest, MemoryLimit) {
+    const size_t limit = 64 * 1024;
+    MapBasedGlobalLockImpl storage(limit, EvictionPolicy::Create("lru", limit), limit);
+
+    // small items cost much more than their keys and values
+    for (size_t i = 0; i < 10000; i++) {
+        EXPECT_TRUE(storage.Put("k" + std::to_string(i), "v"));
+        Afina::MemoryStats stats = storage.Memory();
+        ASSERT_LE(stats.payload + stats.overhead, limit);
+    }
+
+    Afina::MemoryStats stats = storage.Memory();
+    EXPECT_EQ(limit, stats.limit);
+    EXPECT_GT(stats.overhead, stats.payload);
+    EXPECT_GE(stats.overhead, stats.items * (sizeof(Entry) - 4));
+    EXPECT_GT(stats.payload + stats.overhead, limit / 2);
+    CheckKeyValuePair(storage, "k9999", "v");
+    CheckKeyValuePair(storage, "k0", "", false);
+
+    // item that could never fit
+    EXPECT_FALSE(storage.Put("big", std::string(limit, 'x')));
+}
+
+TEST(StorageTest, StatsCommand) {
+    MapBasedGlobalLockImpl storage(1024, EvictionPolicy::Create("lru", 1024), 4096);
+    storage.Put("KEY1", "val1");
+    storage.Put("KEY2", "val2");
+
+    std::string out;
+    Stats().Execute(storage, "", out);
+    EXPECT_NE(std::string::npos, out.find("STAT curr_items 2\r\n"));
+    EXPECT_NE(std::string::npos, out.find("STAT bytes 16\r\n"));
+    EXPECT_NE(std::string::npos, out.find("STAT bytes_overhead "));
+    EXPECT_NE(std::string::npos, out.find("STAT limit_maxbytes 4096\r\n"));
+    EXPECT_EQ("END", out.substr(out.size() - 3));
+}
+
+TEST(StorageTest, ValueRefCopies) {
+    Afina::ValueRef empty;
+    EXPECT_FALSE(empty);
+
+    Afina::ValueRef ref = Afina::ValueRef::Copy("value");
+    Afina::ValueRef copy = ref;
+    EXPECT_EQ(ref.data(), copy.data());
+    ref = Afina::ValueRef();
+    EXPECT_EQ("value", copy.str());
+
+    static const char literal[] = "literal";
+    Afina::ValueRef fixed = Afina::ValueRef::Static(literal, sizeof(literal) - 1);
+    EXPECT_EQ(literal, fixed.data());
+    EXPECT_EQ("literal", fixed.str());
+}
+
+TEST(StorageTest, RefOutlivesEntry) {
+    MapBasedGlobalLockImpl storage(1024);
+    storage.Put("KEY1", "value_1");
+    storage.Put("KEY2", "value_2");
+
+    Afina::ValueRef deleted = storage.GetRef("KEY1");
+    Afina::ValueRef replaced = storage.GetRef("KEY2");
+    EXPECT_FALSE(storage.GetRef("KEY3"));
+
+    // Value of the same size is updated in place unless it is referenced
+    storage.Delete("KEY1");
+    storage.Put("KEY2", "VALUE_2");
+    EXPECT_EQ("value_1", deleted.str());
+    EXPECT_EQ("value_2", replaced.str());
+    EXPECT_EQ("VALUE_2", storage.GetRef("KEY2").str());
+}
+
+TEST(StorageTest, GetChunksReferenceValues) {
+    MapBasedGlobalLockImpl storage(1024);
+    storage.Put("KEY1", "val1");
+
+    std::vector<Afina::ValueRef> chunks;
+    Get({"KEY1", "KEY2"}).Execute(storage, "", chunks);
+    Afina::ValueRef value = storage.GetRef("KEY1");
+    ASSERT_EQ(4, chunks.size());
+    EXPECT_EQ(value.data(), chunks[1].data());
+
+    std::string out;
+    Get({"KEY1", "KEY2"}).Execute(storage, "", out);
+    EXPECT_EQ("VALUE KEY1 0 4\r\nval1\r\nEND", out);
+}
+
+TEST(StorageTest, AppendPrepend) {
+    MapBasedGlobalLockImpl storage(1024);
+    time_t now = time(nullptr);
+
+    EXPECT_FALSE(storage.Append("KEY1", "tail"));
+    EXPECT_FALSE(storage.Prepend("KEY1", "head"));
+    storage.Put("KEY1", "val1", now + 3600);
+    EXPECT_TRUE(storage.Append("KEY1", "_tail"));
+    EXPECT_TRUE(storage.Prepend("KEY1", "head_"));
+    CheckKeyValuePair(storage, "KEY1", "head_val1_tail");
+
+    // Referenced value is never changed, new block takes its place
+    Afina::ValueRef ref = storage.GetRef("KEY1");
+    EXPECT_TRUE(storage.Append("KEY1", "!"));
+    EXPECT_EQ("head_val1_tail", ref.str());
+    CheckKeyValuePair(storage, "KEY1", "head_val1_tail!");
+
+    // Expiration time is kept
+    storage.Put("KEY2", "val2", now - 1);
+    EXPECT_FALSE(storage.Append("KEY2", "tail"));
+    EXPECT_EQ(0, storage.Expire(100));
+
+    std::string out;
+    Append("KEY1", 0, 0).Execute(storage, "?", out);
+    EXPECT_EQ("STORED", out);
+    Prepend("KEY3", 0, 0).Execute(storage, "?", out);
+    EXPECT_EQ("NOT_STORED", out);
+    CheckKeyValuePair(storage, "KEY1", "head_val1_tail!?");
+}
+
+TEST(StorageTest, AppendGrowsInPlace) {
+    MapBasedGlobalLockImpl storage(1 << 20);
+    storage.Put("LOG", "");
+
+    // Block grows by half each time it is reallocated, so most appends fit
+    std::string expected;
+    size_t reallocations = 0;
+    const char *data = nullptr;
+    for (size_t i = 0; i < 1000; i++) {
+        std::string line = "line " + std::to_string(i) + "\n";
+        ASSERT_TRUE(storage.Append("LOG", line));
+        expected += line;
+
+        // Reference is dropped right away, so it doesn't force a new block
+        const char *current = storage.GetRef("LOG").data();
+        reallocations += current != data ? 1 : 0;
+        data = current;
+    }
+    CheckKeyValuePair(storage, "LOG", expected);
+    EXPECT_LT(reallocations, 50);
+    EXPECT_EQ(expected.size() + 3, storage.Memory().payload);
+
+    // Payload budget is charged by the appended bytes
+    MapBasedGlobalLockImpl small(16);
+    small.Put("KEY", "val");
+    EXPECT_TRUE(small.Append("KEY", "1234567890"));
+    EXPECT_FALSE(small.Append("KEY", "1234"));
+    CheckKeyValuePair(small, "KEY", "val1234567890");
+}
+
+TEST(StorageTest, SlabAppend) {
+    MapBasedSlabImpl storage(MapBasedSlabImpl::min_arena_size * 4);
+    storage.Put("KEY1", "val1");
+    for (size_t i = 0; i < 100; i++) {
+        ASSERT_TRUE(storage.Append("KEY1", "0123456789"));
+    }
+    ASSERT_TRUE(storage.Prepend("KEY1", ">"));
+
+    std::string value;
+    ASSERT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(1005, value.size());
+    EXPECT_EQ(">val10123456789", value.substr(0, 15));
+}
+
+TEST(StorageTest, GetsAndCas) {
+    MapBasedGlobalLockImpl storage(1024);
+    storage.Put("KEY1", "val1");
+
+    std::vector<Afina::ValueRef> values;
+    std::vector<uint64_t> versions;
+    storage.Gets({"KEY1"}, values, versions);
+    uint64_t version = versions[0];
+
+    std::string out;
+    Gets({"KEY1", "KEY2"}).Execute(storage, "", out);
+    EXPECT_EQ("VALUE KEY1 0 4 " + std::to_string(version) + "\r\nval1\r\nEND", out);
+
+    Cas("KEY1", 0, 0, version + 1).Execute(storage, "val2", out);
+    EXPECT_EQ("EXISTS", out);
+    Cas("KEY2", 0, 0, version).Execute(storage, "val2", out);
+    EXPECT_EQ("NOT_FOUND", out);
+    Cas("KEY1", 0, 0, version).Execute(storage, "val2", out);
+    EXPECT_EQ("STORED", out);
+    Cas("KEY1", 0, 0, version).Execute(storage, "val3", out);
+    EXPECT_EQ("EXISTS", out);
+    CheckKeyValuePair(storage, "KEY1", "val2");
+}
+
+TEST(StorageTest, IncrDecr) {
+    MapBasedGlobalLockImpl storage(1024);
+    time_t now = time(nullptr);
+
+    std::string out;
+    Incr("KEY1", 1).Execute(storage, "", out);
+    EXPECT_EQ("NOT_FOUND", out);
+
+    storage.Put("KEY1", "99", now + 3600);
+    Incr("KEY1", 1).Execute(storage, "", out);
+    EXPECT_EQ("100", out);
+    Decr("KEY1", 95).Execute(storage, "", out);
+    EXPECT_EQ("5", out);
+    Decr("KEY1", 10).Execute(storage, "", out);
+    EXPECT_EQ("0", out);
+    CheckKeyValuePair(storage, "KEY1", "0");
+    EXPECT_EQ(4 + 1, storage.Memory().payload);
+
+    // Counter nobody references is rewritten in place
+    const char *data = storage.GetRef("KEY1").data();
+    Incr("KEY1", 7).Execute(storage, "", out);
+    EXPECT_EQ(data, storage.GetRef("KEY1").data());
+    CheckKeyValuePair(storage, "KEY1", "7");
+
+    // Increment wraps around, referenced value is never changed
+    storage.Put("KEY2", "18446744073709551615");
+    Afina::ValueRef ref = storage.GetRef("KEY2");
+    Incr("KEY2", 2).Execute(storage, "", out);
+    EXPECT_EQ("1", out);
+    EXPECT_EQ("18446744073709551615", ref.str());
+
+    storage.Put("KEY3", "12a");
+    Incr("KEY3", 1).Execute(storage, "", out);
+    EXPECT_EQ("CLIENT_ERROR cannot increment or decrement non-numeric value", out);
+    storage.Put("KEY3", "18446744073709551616");
+    Decr("KEY3", 1).Execute(storage, "", out);
+    EXPECT_EQ("CLIENT_ERROR cannot increment or decrement non-numeric value", out);
+
+    // Expired counter is not found
+    uint64_t value;
+    storage.Put("KEY4", "1", now - 1);
+    EXPECT_FALSE(storage.Increment("KEY4", 1, value));
+}
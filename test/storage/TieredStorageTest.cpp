@@ -0,0 +1,129 @@
+#include "gtest/gtest.h"
+#include <ctime>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <storage/MapBasedTieredImpl.h>
+#include <storage/SpillLog.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+const size_t TieredMemorySize = 64 * 1024;
+const size_t TieredSpillSize = 1 << 20;
+const size_t TieredValueSize = 1000;
+
+std::string SpillPath() { return "afina_spill_test_" + std::to_string(getpid()); }
+
+std::string TieredValue(size_t i) {
+    std::string value = std::to_string(i) + ":";
+    value.resize(TieredValueSize, 'a' + i % 26);
+    return value;
+}
+
+TEST(TieredStorageTest, SpillLogWraps) {
+    std::set<uint64_t> dropped;
+    SpillLog log(SpillPath(), 4000, [&dropped](const char *key, size_t key_size, uint64_t position) {
+        dropped.insert(position);
+    });
+
+    std::vector<uint64_t> positions;
+    std::string value(1000, 'x');
+    for (size_t i = 0; i < 10; i++) {
+        std::string key = "key_" + std::to_string(i);
+        positions.push_back(log.Append(key.data(), key.size(), value.data(), value.size(), 0));
+    }
+
+    // Each record takes 1024 bytes with the header, so only 3 of them fit at once
+    // and the rest of the file is skipped
+    EXPECT_EQ(7, dropped.size());
+    EXPECT_EQ(positions[7], log.Tail());
+    EXPECT_EQ(12000, positions[9]);
+    for (size_t i = 7; i < 10; i++) {
+        const SpillLog::Record *record = log.Read(positions[i]);
+        EXPECT_EQ("key_" + std::to_string(i), std::string(record->Key(), record->key_size));
+        EXPECT_EQ(value, std::string(record->Value(), record->value_size));
+    }
+    EXPECT_FALSE(log.Fits(10, 4096));
+}
+
+TEST(TieredStorageTest, SpillsLargeValues) {
+    MapBasedTieredImpl storage(TieredMemorySize, SpillPath(), TieredSpillSize);
+    const size_t n_items = 500;
+    for (size_t i = 0; i < n_items; i++) {
+        ASSERT_TRUE(storage.Put("key_" + std::to_string(i), TieredValue(i)));
+    }
+
+    // Memory holds about 64 values, the rest are on disk and nothing is lost
+    EXPECT_GT(storage.Spilled(), n_items / 2);
+    EXPECT_EQ(n_items, storage.Memory().items);
+
+    std::string value;
+    for (size_t i = 0; i < n_items; i++) {
+        ASSERT_TRUE(storage.Get("key_" + std::to_string(i), value)) << i;
+        EXPECT_EQ(TieredValue(i), value);
+    }
+}
+
+TEST(TieredStorageTest, SmallValuesAreDropped) {
+    MapBasedTieredImpl storage(1024, SpillPath(), TieredSpillSize);
+    for (size_t i = 0; i < 100; i++) {
+        storage.Put("key_" + std::to_string(i), "small_" + std::to_string(i));
+    }
+    EXPECT_EQ(0, storage.Spilled());
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("key_0", value));
+}
+
+TEST(TieredStorageTest, ChangesOfSpilledItems) {
+    MapBasedTieredImpl storage(4 * TieredValueSize, SpillPath(), TieredSpillSize);
+    for (size_t i = 0; i < 20; i++) {
+        storage.Put("key_" + std::to_string(i), TieredValue(i));
+    }
+    ASSERT_GT(storage.Spilled(), 10);
+
+    std::string value;
+    EXPECT_FALSE(storage.PutIfAbsent("key_0", "new"));
+    EXPECT_TRUE(storage.Set("key_1", TieredValue(101)));
+    EXPECT_TRUE(storage.Delete("key_2"));
+    EXPECT_FALSE(storage.Delete("key_2"));
+    EXPECT_TRUE(storage.Put("key_3", TieredValue(103), std::time(nullptr) - 1));
+
+    EXPECT_TRUE(storage.Get("key_1", value));
+    EXPECT_EQ(TieredValue(101), value);
+    EXPECT_FALSE(storage.Get("key_2", value));
+    EXPECT_FALSE(storage.Get("key_3", value));
+
+    // Old records of the changed items are not visible even once spilled again
+    for (size_t i = 20; i < 40; i++) {
+        storage.Put("key_" + std::to_string(i), TieredValue(i));
+    }
+    EXPECT_TRUE(storage.Get("key_1", value));
+    EXPECT_EQ(TieredValue(101), value);
+    EXPECT_FALSE(storage.Get("key_2", value));
+}
+
+TEST(TieredStorageTest, ScanIncludesSpilled) {
+    MapBasedTieredImpl storage(8 * TieredValueSize, SpillPath(), TieredSpillSize);
+    for (size_t i = 0; i < 100; i++) {
+        storage.Put("key_" + std::to_string(i), TieredValue(i));
+    }
+    storage.Delete("key_0");
+
+    std::set<std::string> keys;
+    std::vector<Afina::ScanItem> items;
+    size_t cursor = 0;
+    do {
+        cursor = storage.Scan(cursor, 8, items);
+    } while (cursor != 0);
+
+    for (auto &item : items) {
+        EXPECT_TRUE(keys.insert(item.key).second) << item.key;
+        EXPECT_EQ(TieredValue(std::stoul(item.key.substr(4))), item.value.str());
+    }
+    EXPECT_EQ(99, keys.size());
+}
@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <storage/Entry.h>
+#include <storage/TimerWheel.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+const uint32_t TimerWheelStart = 1000000;
+
+// Owns entries, so tests don't leak them
+class TestEntries {
+public:
+    Entry *New(const std::string &key) {
+        _entries.emplace_back(Entry::Create(key, 0, "value"), Entry::Destroy);
+        return _entries.back().get();
+    }
+
+private:
+    std::vector<std::unique_ptr<Entry, void (*)(Entry *)>> _entries;
+};
+
+// Collects all entries due by now
+std::vector<Entry *> Drain(TimerWheel &wheel, uint32_t now) {
+    std::vector<Entry *> result;
+    while (Entry *entry = wheel.Next(now)) {
+        result.push_back(entry);
+    }
+    return result;
+}
+
+TEST(TimerWheelTest, FiresInOrder) {
+    TestEntries entries;
+    TimerWheel wheel(TimerWheelStart);
+
+    // Deltas that land into every level of the wheel
+    std::vector<uint32_t> deltas = {1, 2, 63, 64, 65, 4095, 4096, 5000, 262144, 300000, 20000000};
+    std::vector<Entry *> scheduled;
+    for (uint32_t delta : deltas) {
+        Entry *entry = entries.New(std::to_string(delta));
+        wheel.Schedule(entry, TimerWheelStart + delta);
+        scheduled.push_back(entry);
+    }
+    EXPECT_EQ(deltas.size(), wheel.Size());
+    EXPECT_TRUE(Drain(wheel, TimerWheelStart).empty());
+
+    for (size_t i = 0; i < deltas.size(); i++) {
+        EXPECT_TRUE(Drain(wheel, TimerWheelStart + deltas[i] - 1).empty()) << "delta " << deltas[i];
+        std::vector<Entry *> fired = Drain(wheel, TimerWheelStart + deltas[i]);
+        ASSERT_EQ(1, fired.size()) << "delta " << deltas[i];
+        EXPECT_EQ(scheduled[i], fired[0]);
+        EXPECT_EQ(0, fired[0]->_timer);
+    }
+    EXPECT_EQ(0, wheel.Size());
+}
+
+TEST(TimerWheelTest, CancelAndReschedule) {
+    TestEntries entries;
+    TimerWheel wheel(TimerWheelStart);
+
+    Entry *a = entries.New("a");
+    Entry *b = entries.New("b");
+    Entry *c = entries.New("c");
+    wheel.Schedule(a, TimerWheelStart + 10);
+    wheel.Schedule(b, TimerWheelStart + 10);
+    wheel.Schedule(c, TimerWheelStart + 10);
+
+    wheel.Cancel(b);
+    wheel.Schedule(c, TimerWheelStart + 100);
+    EXPECT_EQ(2, wheel.Size());
+
+    std::vector<Entry *> fired = Drain(wheel, TimerWheelStart + 50);
+    ASSERT_EQ(1, fired.size());
+    EXPECT_EQ(a, fired[0]);
+
+    // Replaced entry takes the timer
+    Entry *d = entries.New("c");
+    wheel.Replace(c, d);
+    EXPECT_EQ(0, c->_timer);
+    fired = Drain(wheel, TimerWheelStart + 100);
+    ASSERT_EQ(1, fired.size());
+    EXPECT_EQ(d, fired[0]);
+
+    // Time 0 cancels, freed timer is reused
+    wheel.Schedule(a, TimerWheelStart + 200);
+    wheel.Schedule(a, 0);
+    EXPECT_EQ(0, wheel.Size());
+    EXPECT_TRUE(Drain(wheel, TimerWheelStart + 300).empty());
+}
+
+TEST(TimerWheelTest, PastTimeFiresRightAway) {
+    TestEntries entries;
+    TimerWheel wheel(TimerWheelStart);
+
+    Entry *entry = entries.New("a");
+    wheel.Schedule(entry, 1);
+    EXPECT_EQ(entry, wheel.Next(TimerWheelStart));
+}
+
+TEST(TimerWheelTest, BoundedBatches) {
+    TestEntries entries;
+    TimerWheel wheel(TimerWheelStart);
+
+    std::mt19937 rnd(7);
+    std::uniform_int_distribution<uint32_t> delta(1, 100000);
+    const size_t count = 10000;
+    for (size_t i = 0; i < count; i++) {
+        Entry *entry = entries.New(std::to_string(i));
+        entry->_expire = TimerWheelStart + delta(rnd);
+        wheel.Schedule(entry, entry->_expire);
+    }
+
+    // Everything is due, but each call gives one entry only and in order
+    uint32_t now = TimerWheelStart + 100000;
+    uint32_t last = 0;
+    std::set<Entry *> fired;
+    for (size_t i = 0; i < count; i++) {
+        Entry *entry = wheel.Next(now);
+        ASSERT_NE(nullptr, entry);
+        EXPECT_LE(last, entry->_expire);
+        last = entry->_expire;
+        fired.insert(entry);
+        EXPECT_EQ(count - i - 1, wheel.Size());
+    }
+    EXPECT_EQ(count, fired.size());
+    EXPECT_EQ(nullptr, wheel.Next(now));
+}
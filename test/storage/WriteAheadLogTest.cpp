@@ -0,0 +1,237 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <storage/MapBasedGlobalLockImpl.h>
+#include <storage/MapBasedStripedLockImpl.h>
+#include <storage/Snapshot.h>
+#include <storage/WriteAheadLog.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+const size_t LogStorageSize = 1 << 20;
+
+// Unique log file removed once test is done
+class TempLog {
+public:
+    TempLog() : _path("afina_wal_test_" + std::to_string(getpid()) + "_" + std::to_string(_counter++)) {}
+    ~TempLog() { std::remove(_path.c_str()); }
+
+    const std::string &str() const { return _path; }
+
+    size_t Size() const {
+        std::ifstream in(_path, std::ios::binary | std::ios::ate);
+        return in.tellg();
+    }
+
+private:
+    static size_t _counter;
+    std::string _path;
+};
+
+size_t TempLog::_counter = 0;
+
+std::unique_ptr<WriteAheadLog> OpenLog(const TempLog &path, const std::string &snapshot = std::string()) {
+    auto storage = std::make_shared<MapBasedGlobalLockImpl>(LogStorageSize);
+    std::unique_ptr<WriteAheadLog> log(new WriteAheadLog(storage, path.str(), snapshot));
+    log->Start();
+    return log;
+}
+
+TEST(WriteAheadLogTest, ReplayAfterCrash) {
+    TempLog path;
+    {
+        // Log is never stopped, as if process is killed
+        auto log = OpenLog(path);
+        EXPECT_TRUE(log->Put("KEY1", "val1"));
+        EXPECT_TRUE(log->Put("KEY2", "val2"));
+        EXPECT_TRUE(log->Set("KEY2", "VAL2"));
+        EXPECT_FALSE(log->Set("KEY3", "val3"));
+        EXPECT_TRUE(log->PutIfAbsent("KEY3", "val3"));
+        EXPECT_TRUE(log->Delete("KEY1"));
+    }
+
+    auto log = OpenLog(path);
+    EXPECT_EQ(5, log->Replayed());
+
+    std::string value;
+    EXPECT_FALSE(log->Get("KEY1", value));
+    EXPECT_TRUE(log->Get("KEY2", value));
+    EXPECT_EQ("VAL2", value);
+    EXPECT_TRUE(log->Get("KEY3", value));
+    EXPECT_EQ("val3", value);
+}
+
+TEST(WriteAheadLogTest, ReplayAppend) {
+    TempLog path;
+    {
+        auto log = OpenLog(path);
+        EXPECT_TRUE(log->Put("KEY1", "val1", time(nullptr) + 3600));
+        EXPECT_TRUE(log->Append("KEY1", "_tail"));
+        EXPECT_TRUE(log->Prepend("KEY1", "head_"));
+        EXPECT_FALSE(log->Append("KEY2", "tail"));
+    }
+
+    auto log = OpenLog(path);
+    EXPECT_EQ(3, log->Replayed());
+
+    std::string value;
+    EXPECT_TRUE(log->Get("KEY1", value));
+    EXPECT_EQ("head_val1_tail", value);
+    EXPECT_FALSE(log->Get("KEY2", value));
+}
+
+TEST(WriteAheadLogTest, ReplayCounter) {
+    TempLog path;
+    {
+        auto log = OpenLog(path);
+        uint64_t value;
+        EXPECT_TRUE(log->Put("KEY1", "10", time(nullptr) + 3600));
+        EXPECT_TRUE(log->Increment("KEY1", 5, value));
+        EXPECT_TRUE(log->Decrement("KEY1", 20, value));
+        EXPECT_TRUE(log->Increment("KEY1", 7, value));
+        EXPECT_FALSE(log->Increment("KEY2", 1, value));
+    }
+
+    auto log = OpenLog(path);
+    EXPECT_EQ(4, log->Replayed());
+
+    std::string value;
+    EXPECT_TRUE(log->Get("KEY1", value));
+    EXPECT_EQ("7", value);
+}
+
+TEST(WriteAheadLogTest, ReplayCas) {
+    TempLog path;
+    {
+        auto log = OpenLog(path);
+        EXPECT_TRUE(log->Put("KEY1", "val1"));
+        std::vector<Afina::ValueRef> values;
+        std::vector<uint64_t> versions;
+        log->Gets({"KEY1"}, values, versions);
+        EXPECT_EQ(Afina::CasResult::Stored, log->CompareAndSet("KEY1", "val2", versions[0]));
+        EXPECT_EQ(Afina::CasResult::Exists, log->CompareAndSet("KEY1", "val3", versions[0]));
+    }
+
+    // Versions are not logged, only the values stored by cas
+    auto log = OpenLog(path);
+    EXPECT_EQ(2, log->Replayed());
+
+    std::string value;
+    EXPECT_TRUE(log->Get("KEY1", value));
+    EXPECT_EQ("val2", value);
+}
+
+TEST(WriteAheadLogTest, TornTail) {
+    TempLog path;
+    {
+        auto log = OpenLog(path);
+        log->Put("KEY1", "val1");
+        log->Put("KEY2", "val2");
+        log->Stop();
+    }
+
+    // Last record is cut in the middle
+    size_t size = path.Size();
+    ASSERT_EQ(0, truncate(path.str().c_str(), size - 3));
+
+    auto log = OpenLog(path);
+    EXPECT_EQ(1, log->Replayed());
+    std::string value;
+    EXPECT_TRUE(log->Get("KEY1", value));
+    EXPECT_FALSE(log->Get("KEY2", value));
+
+    // Log is usable after the broken record is dropped
+    EXPECT_TRUE(log->Put("KEY2", "val2"));
+    log->Stop();
+    EXPECT_EQ(2, OpenLog(path)->Replayed());
+}
+
+TEST(WriteAheadLogTest, Compaction) {
+    TempLog path;
+    {
+        auto log = OpenLog(path);
+        for (size_t i = 0; i < 1000; i++) {
+            log->Put("KEY", "value_" + std::to_string(i));
+        }
+        log->Stop();
+    }
+    size_t before = path.Size();
+
+    auto log = OpenLog(path);
+    EXPECT_EQ(1000, log->Replayed());
+    EXPECT_LT(path.Size() * 100, before);
+
+    std::string value;
+    EXPECT_TRUE(log->Get("KEY", value));
+    EXPECT_EQ("value_999", value);
+    log->Stop();
+    EXPECT_EQ(1, OpenLog(path)->Replayed());
+}
+
+TEST(WriteAheadLogTest, SnapshotUnderLog) {
+    TempLog path, snapshot;
+    {
+        MapBasedGlobalLockImpl storage(LogStorageSize);
+        storage.Put("KEY1", "val1");
+        storage.Put("KEY2", "val2");
+        Snapshot::Save(storage, snapshot.str());
+    }
+
+    {
+        // There is no log yet, so storage starts from the snapshot
+        auto log = OpenLog(path, snapshot.str());
+        EXPECT_EQ(2, log->Loaded());
+        EXPECT_TRUE(log->Delete("KEY1"));
+    }
+
+    // Restart compacts the log and the Delete record with it, then the process
+    // crashes before the next snapshot is written
+    EXPECT_EQ(0, OpenLog(path, snapshot.str())->Loaded());
+
+    // Old snapshot still has the key, it must not come back from it
+    auto log = OpenLog(path, snapshot.str());
+    EXPECT_EQ(0, log->Loaded());
+    std::string value;
+    EXPECT_FALSE(log->Get("KEY1", value));
+    EXPECT_TRUE(log->Get("KEY2", value));
+    EXPECT_EQ("val2", value);
+}
+
+TEST(WriteAheadLogTest, GroupCommit) {
+    TempLog path;
+    const size_t n_threads = 8;
+    const size_t n_ops = 200;
+    {
+        WriteAheadLog log(std::make_shared<MapBasedStripedLockImpl>(LogStorageSize), path.str());
+        log.Start();
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < n_threads; t++) {
+            threads.emplace_back([&log, t]() {
+                for (size_t i = 0; i < n_ops; i++) {
+                    log.Put("key_" + std::to_string(t) + "_" + std::to_string(i), "value");
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        // Writers waiting for the same sync share it
+        EXPECT_LT(log.Syncs(), n_threads * n_ops);
+        std::cout << "writes: " << n_threads * n_ops << " syncs: " << log.Syncs() << std::endl;
+        log.Stop();
+    }
+
+    auto log = OpenLog(path);
+    EXPECT_EQ(n_threads * n_ops, log->Replayed());
+}